@@ -20,6 +20,7 @@
 
 #include "CodedInputData.h"
 #include "PBUtility.h"
+#include <algorithm>
 #include <stdexcept>
 #include <cstring>
 
@@ -38,6 +39,37 @@ CodedInputData::CodedInputData(const void *oData, size_t length)
     MMKV_ASSERT(m_ptr);
 }
 
+// decode varint32 without throwing, return nullptr on truncated/malformed data
+// no per-byte bounds checking as long as there are enough bytes left
+static inline const uint8_t *decodeVarint32(const uint8_t *ptr, const uint8_t *end, uint32_t &value) {
+    if (mmkv_likely(ptr < end && *ptr < 0x80)) {
+        value = *ptr;
+        return ptr + 1;
+    }
+    uint32_t result = 0;
+    if (mmkv_likely(end - ptr >= 5)) {
+        for (uint32_t shift = 0; shift < 35; shift += 7) {
+            uint32_t byte = *ptr++;
+            result |= (byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                value = result;
+                return ptr;
+            }
+        }
+    } else {
+        for (uint32_t shift = 0; shift < 35 && ptr < end; shift += 7) {
+            uint32_t byte = *ptr++;
+            result |= (byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                value = result;
+                return ptr;
+            }
+        }
+    }
+    // negative values take 10 bytes, not a size, leave it to the caller
+    return nullptr;
+}
+
 void CodedInputData::seek(size_t addedSize) {
     if (m_position + addedSize > m_size) {
         throw out_of_range("OutOfSpace");
@@ -136,6 +168,116 @@ string CodedInputData::readString(KeyValueHolder &kvHolder) {
     }
 }
 
+static inline bool decodeVarint64(const uint8_t *ptr, size_t size, uint64_t &value) {
+    if (mmkv_likely(size > 0 && *ptr < 0x80)) {
+        value = *ptr;
+        return true;
+    }
+    uint64_t result = 0;
+    auto end = ptr + std::min<size_t>(size, 10);
+    for (uint32_t shift = 0; ptr < end; shift += 7) {
+        uint64_t byte = *ptr++;
+        result |= (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CodedInputData::decodeBool(const void *ptr, size_t size, bool &value) {
+    uint64_t result = 0;
+    if (decodeVarint64((const uint8_t *) ptr, size, result)) {
+        value = static_cast<uint32_t>(result) != 0;
+        return true;
+    }
+    return false;
+}
+
+bool CodedInputData::decodeInt32(const void *ptr, size_t size, int32_t &value) {
+    uint64_t result = 0;
+    if (decodeVarint64((const uint8_t *) ptr, size, result)) {
+        // negative values are sign-extended to 64 bits, just discard upper 32 bits
+        value = static_cast<int32_t>(static_cast<uint32_t>(result));
+        return true;
+    }
+    return false;
+}
+
+bool CodedInputData::decodeUInt32(const void *ptr, size_t size, uint32_t &value) {
+    uint64_t result = 0;
+    if (decodeVarint64((const uint8_t *) ptr, size, result)) {
+        value = static_cast<uint32_t>(result);
+        return true;
+    }
+    return false;
+}
+
+bool CodedInputData::decodeInt64(const void *ptr, size_t size, int64_t &value) {
+    uint64_t result = 0;
+    if (decodeVarint64((const uint8_t *) ptr, size, result)) {
+        value = static_cast<int64_t>(result);
+        return true;
+    }
+    return false;
+}
+
+bool CodedInputData::decodeUInt64(const void *ptr, size_t size, uint64_t &value) {
+    return decodeVarint64((const uint8_t *) ptr, size, value);
+}
+
+bool CodedInputData::decodeFloat(const void *ptr, size_t size, float &value) {
+    if (size < pbFloatSize()) {
+        return false;
+    }
+    auto bytes = (const uint8_t *) ptr;
+    auto result = static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+                  (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    value = Int32ToFloat32(static_cast<int32_t>(result));
+    return true;
+}
+
+bool CodedInputData::decodeDouble(const void *ptr, size_t size, double &value) {
+    if (size < pbDoubleSize()) {
+        return false;
+    }
+    auto bytes = (const uint8_t *) ptr;
+    uint64_t result = 0;
+    for (int index = 7; index >= 0; index--) {
+        result = (result << 8) | bytes[index];
+    }
+    value = Int64ToFloat64(static_cast<int64_t>(result));
+    return true;
+}
+
+bool CodedInputData::readKeyValueHolder(KeyValueHolder &kvHolder, string_view &key) {
+    auto begin = m_ptr + m_position;
+    auto end = m_ptr + m_size;
+    uint32_t keySize = 0;
+    auto ptr = decodeVarint32(begin, end, keySize);
+    if (mmkv_unlikely(!ptr || keySize > static_cast<size_t>(end - ptr))) {
+        return false;
+    }
+    kvHolder.offset = static_cast<uint32_t>(m_position);
+    kvHolder.keySize = static_cast<uint16_t>(keySize);
+    key = string_view((const char *) ptr, keySize);
+    ptr += keySize;
+
+    if (keySize > 0) {
+        uint32_t valueSize = 0;
+        ptr = decodeVarint32(ptr, end, valueSize);
+        if (mmkv_unlikely(!ptr || valueSize > static_cast<size_t>(end - ptr))) {
+            return false;
+        }
+        kvHolder.computedKVSize = static_cast<uint16_t>(ptr - begin);
+        kvHolder.valueSize = valueSize;
+        ptr += valueSize;
+    }
+    m_position = static_cast<size_t>(ptr - m_ptr);
+    return true;
+}
+
 MMBuffer CodedInputData::readRealData(mmkv::MMBuffer & data) {
     CodedInputData input(data.getPtr(), data.length());
     return input.readData(false, true);
@@ -177,6 +319,14 @@ void CodedInputData::readData(KeyValueHolder &kvHolder) {
 }
 
 int32_t CodedInputData::readRawVarint32() {
+    uint32_t value = 0;
+    auto ptr = m_ptr + m_position;
+    auto next = decodeVarint32(ptr, m_ptr + m_size, value);
+    if (mmkv_likely(next != nullptr)) {
+        m_position += static_cast<size_t>(next - ptr);
+        return static_cast<int32_t>(value);
+    }
+    // negative values & truncated data goes the slow way
     int8_t tmp = this->readRawByte();
     if (tmp >= 0) {
         return tmp;
@@ -48,6 +48,8 @@ public:
 
     bool isAtEnd() const { return m_position == m_size; };
 
+    size_t getPosition() const { return m_position; }
+
     void seek(size_t addedSize);
 
     bool readBool();
@@ -73,6 +75,18 @@ public:
     std::string readString();
     void readString(std::string &s);
     std::string readString(KeyValueHolder &kvHolder);
+    // decode primitive values directly from memory without throwing, return false on truncated/malformed data
+    static bool decodeBool(const void *ptr, size_t size, bool &value);
+    static bool decodeInt32(const void *ptr, size_t size, int32_t &value);
+    static bool decodeUInt32(const void *ptr, size_t size, uint32_t &value);
+    static bool decodeInt64(const void *ptr, size_t size, int64_t &value);
+    static bool decodeUInt64(const void *ptr, size_t size, uint64_t &value);
+    static bool decodeFloat(const void *ptr, size_t size, float &value);
+    static bool decodeDouble(const void *ptr, size_t size, double &value);
+
+    // decode one key-value record without throwing or copying the key, return false on truncated/malformed data
+    // an empty key has no value followed, just like readString(kvHolder) + readData(kvHolder)
+    bool readKeyValueHolder(KeyValueHolder &kvHolder, std::string_view &key);
 #ifdef __OBJC__
     NSString *readNSString();
     NSString *readNSString(KeyValueHolder &kvHolder);
@@ -38,8 +38,9 @@ using namespace std;
 
 namespace mmkv {
 
-CodedInputDataCrypt::CodedInputDataCrypt(const void *oData, size_t length, AESCrypt &crypt)
-    : m_ptr((uint8_t *) oData), m_size(length), m_position(0), m_decryptPosition(0), m_decrypter(crypt) {
+CodedInputDataCrypt::CodedInputDataCrypt(const void *oData, size_t length, AESCrypt &crypt, bool lazyDecrypt)
+    : m_ptr((uint8_t *) oData), m_size(length), m_position(0), m_decryptPosition(0), m_decrypter(crypt)
+    , m_lazyDecrypt(lazyDecrypt) {
     m_decryptBufferSize = AES_KEY_LEN * 2;
     m_decryptBufferPosition = static_cast<size_t>(crypt.m_number);
     m_decryptBufferDiscardPosition = m_decryptBufferPosition;
@@ -140,7 +141,16 @@ void CodedInputDataCrypt::skipBytes(size_t length) {
     auto bytesLeftInSrc = m_size - m_decryptPosition;
     auto size = min(alignSize, bytesLeftInSrc);
     decryptedBytesLeft = size - length;
-    for (size_t index = 0, round = size / AES_KEY_LEN; index < round; index++) {
+    auto round = size / AES_KEY_LEN;
+    if (m_decrypter.isRandomAccess() && round > 1) {
+        // nothing skipped needs decrypting, except the last block that's partially used
+        auto skipRound = (size % AES_KEY_LEN) ? round : round - 1;
+        m_decrypter.skipBlocks(skipRound);
+        m_decryptPosition += skipRound * AES_KEY_LEN;
+        size -= skipRound * AES_KEY_LEN;
+        round -= skipRound;
+    }
+    for (size_t index = 0; index < round; index++) {
         m_decrypter.decrypt(m_ptr + m_decryptPosition, m_decryptBuffer, AES_KEY_LEN);
         m_decryptPosition += AES_KEY_LEN;
         size -= AES_KEY_LEN;
@@ -248,7 +258,7 @@ void CodedInputDataCrypt::readData(KeyValueHolderCrypt &kvHolder) {
 
     auto s_size = static_cast<size_t>(size);
     if (s_size <= m_size - m_position) {
-        if (KeyValueHolderCrypt::isValueStoredAsOffset(s_size)) {
+        if (KeyValueHolderCrypt::isValueStoredAsOffset(s_size, m_lazyDecrypt)) {
             kvHolder.type = KeyValueHolderType_Offset;
             kvHolder.valueSize = static_cast<uint32_t>(s_size);
             kvHolder.pbKeyValueSize =
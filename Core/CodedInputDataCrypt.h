@@ -51,6 +51,7 @@ class CodedInputDataCrypt {
     size_t m_decryptBufferPosition; // reader position in the buffer, synced with m_position
     size_t m_decryptBufferDecryptLength; // length of the buffer that has been used
     size_t m_decryptBufferDiscardPosition; // recycle position, any data before that can be discarded
+    bool m_lazyDecrypt; // see KeyValueHolderCrypt::isValueStoredAsOffset()
 
     void consumeBytes(size_t length, bool discardPreData = false);
     void skipBytes(size_t length);
@@ -61,7 +62,7 @@ class CodedInputDataCrypt {
     int32_t readRawVarint32(bool discardPreData = false);
 
 public:
-    CodedInputDataCrypt(const void *oData, size_t length, AESCrypt &crypt);
+    CodedInputDataCrypt(const void *oData, size_t length, AESCrypt &crypt, bool lazyDecrypt = false);
 
     ~CodedInputDataCrypt();
 
@@ -0,0 +1,101 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DecryptedValueCache.h"
+
+#ifndef MMKV_APPLE
+
+using namespace std;
+
+namespace mmkv {
+
+// a rough estimation of the list node, the hash node & the heap blocks behind them
+constexpr size_t EntryOverhead = 96;
+
+size_t DecryptedValueCache::entrySize(const string &key, const MMBuffer &value) {
+    return key.size() + value.length() + EntryOverhead;
+}
+
+MMBuffer DecryptedValueCache::get(string_view key, bool &found) {
+    auto itr = m_index.find(key);
+    if (itr == m_index.end()) {
+        m_missCount++;
+        found = false;
+        return MMBuffer();
+    }
+    m_hitCount++;
+    found = true;
+    auto entry = itr->second;
+    if (entry != m_entries.begin()) {
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+    }
+    auto &value = entry->second;
+    return MMBuffer(value.getPtr(), value.length(), MMBufferCopy);
+}
+
+void DecryptedValueCache::put(string_view key, const MMBuffer &value) {
+    erase(key);
+
+    string keyStr(key);
+    auto size = entrySize(keyStr, value);
+    if (size > m_sizeLimit) {
+        return;
+    }
+    evictToFit(m_sizeLimit - size);
+
+    m_entries.emplace_front(std::move(keyStr), MMBuffer(value.getPtr(), value.length(), MMBufferCopy));
+    m_index.emplace(m_entries.front().first, m_entries.begin());
+    m_totalSize += size;
+}
+
+void DecryptedValueCache::erase(string_view key) {
+    auto itr = m_index.find(key);
+    if (itr == m_index.end()) {
+        return;
+    }
+    auto entry = itr->second;
+    m_totalSize -= entrySize(entry->first, entry->second);
+    m_index.erase(itr);
+    m_entries.erase(entry);
+}
+
+void DecryptedValueCache::evictToFit(size_t sizeLimit) {
+    while (m_totalSize > sizeLimit && !m_entries.empty()) {
+        auto &last = m_entries.back();
+        m_totalSize -= entrySize(last.first, last.second);
+        m_index.erase(m_index.find(last.first));
+        m_entries.pop_back();
+    }
+}
+
+void DecryptedValueCache::clear() {
+    m_index.clear();
+    m_entries.clear();
+    m_totalSize = 0;
+}
+
+void DecryptedValueCache::setSizeLimit(size_t sizeLimit) {
+    m_sizeLimit = sizeLimit;
+    evictToFit(sizeLimit);
+}
+
+} // namespace mmkv
+
+#endif // !MMKV_APPLE
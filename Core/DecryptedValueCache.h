@@ -0,0 +1,85 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MMKV_DECRYPTEDVALUECACHE_H
+#define MMKV_DECRYPTEDVALUECACHE_H
+#ifdef __cplusplus
+
+#include "MMBuffer.h"
+#include "MMKVPredef.h"
+
+#ifndef MMKV_APPLE
+
+#    include <list>
+#    include <string>
+#    include <unordered_map>
+
+namespace mmkv {
+
+// LRU cache of decrypted values, bounded by the total bytes of keys & values it holds
+// not thread-safe, the owner instance guards it with its own lock
+class DecryptedValueCache {
+    using Entry = std::pair<std::string, MMBuffer>;
+    using EntryList = std::list<Entry>;
+
+    // the most recently used entry comes first
+    EntryList m_entries;
+    std::unordered_map<std::string, EntryList::iterator, KeyHasher, KeyEqualer> m_index;
+
+    size_t m_sizeLimit;
+    size_t m_totalSize = 0;
+    uint64_t m_hitCount = 0;
+    uint64_t m_missCount = 0;
+
+    static size_t entrySize(const std::string &key, const MMBuffer &value);
+
+    void evictToFit(size_t sizeLimit);
+
+public:
+    explicit DecryptedValueCache(size_t sizeLimit) : m_sizeLimit(sizeLimit) {}
+
+    // return a copy of the cached value, or an empty buffer if not found
+    MMBuffer get(std::string_view key, bool &found);
+
+    // values larger than the whole budget are not cached
+    void put(std::string_view key, const MMBuffer &value);
+
+    void erase(std::string_view key);
+
+    void clear();
+
+    size_t sizeLimit() const { return m_sizeLimit; }
+    void setSizeLimit(size_t sizeLimit);
+
+    size_t itemCount() const { return m_index.size(); }
+    size_t totalSize() const { return m_totalSize; }
+    uint64_t hitCount() const { return m_hitCount; }
+    uint64_t missCount() const { return m_missCount; }
+
+    // just forbid it for possibly misuse
+    explicit DecryptedValueCache(const DecryptedValueCache &other) = delete;
+    DecryptedValueCache &operator=(const DecryptedValueCache &other) = delete;
+};
+
+} // namespace mmkv
+
+#endif // !MMKV_APPLE
+#endif // __cplusplus
+#endif // MMKV_DECRYPTEDVALUECACHE_H
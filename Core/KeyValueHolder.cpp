@@ -161,6 +161,15 @@ MMBuffer KeyValueHolderCrypt::toMMBuffer(const void *basePtr, const AESCrypt *cr
         auto realPtr = (uint8_t *) basePtr + offset;
         auto position = static_cast<uint32_t>(pbKeyValueSize + keySize);
         auto realSize = position + valueSize;
+        if (crypter->isRandomAccess()) {
+            // decrypt the value alone, right from its position
+            AESCryptStatus status;
+            crypter->statusAtPosition(offset + position, status);
+            auto decrypter = crypter->cloneWithStatus(status);
+            MMBuffer result(valueSize);
+            decrypter.decrypt(realPtr + position, result.getPtr(), valueSize);
+            return result;
+        }
         auto kvBuffer = MMBuffer(realPtr, realSize, MMBufferNoCopy);
         auto decrypter = crypter->cloneWithStatus(cryptStatus);
         return decryptBuffer(decrypter, kvBuffer, position);
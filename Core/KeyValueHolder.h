@@ -82,7 +82,10 @@ struct KeyValueHolderCrypt {
         return 256;
     }
 
-    static bool isValueStoredAsOffset(size_t valueSize) { return valueSize > MediumBufferSize(); }
+    // with lazyDecrypt, only values small enough to be stored directly are kept decrypted in memory
+    static bool isValueStoredAsOffset(size_t valueSize, bool lazyDecrypt = false) {
+        return valueSize > (lazyDecrypt ? SmallBufferSize() : MediumBufferSize());
+    }
 
     KeyValueHolderCrypt() = default;
     KeyValueHolderCrypt(const void *valuePtr, size_t valueLength);
@@ -20,17 +20,20 @@
 
 #include "CodedInputData.h"
 #include "CodedOutputData.h"
+#include "DecryptedValueCache.h"
 #include "InterProcessLock.h"
 #include "KeyValueHolder.h"
 #include "MMBuffer.h"
 #include "MMKVLog.h"
 #include "MMKVMetaInfo.hpp"
+#include "MMKVSnapshot.h"
 #include "MMKV_IO.h"
 #include "MMKV_OSX.h"
 #include "MemoryFile.h"
 #include "MiniPBCoder.h"
 #include "PBUtility.h"
 #include "ScopedLock.hpp"
+#include "SegmentCRC.h"
 #include "ThreadLock.h"
 #include "aes/AESCrypt.h"
 #include "aes/openssl/openssl_aes.h"
@@ -41,6 +44,18 @@
 #include <cstring>
 #include <unordered_set>
 #include <cassert>
+#include <condition_variable>
+#include <mutex>
+
+#ifndef MMKV_APPLE
+#    include <atomic>
+#    include <chrono>
+#    include <thread>
+#endif
+
+#ifdef MMKV_LINUX
+#    include <unistd.h>
+#endif
 
 #if defined(__aarch64__) && defined(__linux__) && !defined (MMKV_OHOS)
 #    include <asm/hwcap.h>
@@ -65,13 +80,66 @@ static ThreadLock *g_namespaceLock;
 static unordered_map<MMKVPath_t, MMKVPath_t> g_realRootMap;
 static mmkv::ErrorHandler g_errorHandler;
 size_t mmkv::DEFAULT_MMAP_SIZE;
+// files being worked on without g_instanceLock (backup, restore, expire sweeping)
+// they must not be opened or closed meanwhile
+static unordered_set<MMKVPath_t> g_busyInstancePaths;
+static condition_variable_any g_busyInstanceCondition;
+
+// mark a file busy & let go of g_instanceLock while working on it, take the lock back on leaving
+class BusyInstanceScope {
+    unique_lock<ThreadLock> &m_instanceLock;
+    const MMKVPath_t &m_path;
+
+public:
+    BusyInstanceScope(unique_lock<ThreadLock> &instanceLock, const MMKVPath_t &path) : m_instanceLock(instanceLock), m_path(path) {
+        g_busyInstancePaths.insert(m_path);
+        m_instanceLock.unlock();
+    }
+
+    ~BusyInstanceScope() {
+        m_instanceLock.lock();
+        g_busyInstancePaths.erase(m_path);
+        g_busyInstanceCondition.notify_all();
+    }
+
+    // just forbid it for possibly misuse
+    explicit BusyInstanceScope(const BusyInstanceScope &other) = delete;
+    BusyInstanceScope &operator=(const BusyInstanceScope &other) = delete;
+};
+
+// the caller might hold g_instanceLock more than once, let go of all of them while waiting
+class FullyReleasedInstanceLock {
+    size_t m_depth = 0;
+
+public:
+    void unlock() { m_depth = g_instanceLock->unlockFully(); }
+    void lock() { g_instanceLock->relock(m_depth); }
+};
+
+void waitForIdleInstancePath(const MMKVPath_t &path) {
+    FullyReleasedInstanceLock lock;
+    while (g_busyInstancePaths.find(path) != g_busyInstancePaths.end()) {
+        g_busyInstanceCondition.wait(lock);
+    }
+}
+
+static void waitForAllIdleInstancePaths() {
+    FullyReleasedInstanceLock lock;
+    while (!g_busyInstancePaths.empty()) {
+        g_busyInstanceCondition.wait(lock);
+    }
+}
 
 #ifndef MMKV_WIN32
 constexpr auto SPECIAL_CHARACTER_DIRECTORY_NAME = "specialCharacter";
 constexpr auto CRC_SUFFIX = ".crc";
+constexpr auto BACKUP_MANIFEST_SUFFIX = ".manifest";
+constexpr auto COMPACTION_JOURNAL_SUFFIX = ".journal";
 #else
 constexpr auto SPECIAL_CHARACTER_DIRECTORY_NAME = L"specialCharacter";
 constexpr auto CRC_SUFFIX = L".crc";
+constexpr auto BACKUP_MANIFEST_SUFFIX = L".manifest";
+constexpr auto COMPACTION_JOURNAL_SUFFIX = L".journal";
 #endif
 
 MMKV_NAMESPACE_BEGIN
@@ -120,6 +188,16 @@ MMKV::MMKV(const string &mmapID, MMKVMode mode, const string *cryptKey, const MM
     m_lock->initialize();
     m_sharedProcessLock->m_enable = isMultiProcess();
     m_exclusiveProcessLock->m_enable = isMultiProcess();
+    // every change to the data goes through updateCRCDigest()/recalculateCRCDigest*()/writeActualSize()
+    m_file->enableDirtyTracking();
+    if ((m_mode & MMKV_BUFFERED_IO) && !isMultiProcess()) {
+        // the meta file must not reach the disk ahead of the data
+        m_file->setBackend(StorageBackend::Buffered);
+        m_metaFile->setBackend(StorageBackend::Buffered);
+    }
+    if (m_mode & MMKV_HUGE_PAGE) {
+        m_file->enableHugePage();
+    }
 
     // sensitive zone
     /*{
@@ -127,12 +205,66 @@ MMKV::MMKV(const string &mmapID, MMKVMode mode, const string *cryptKey, const MM
         loadFromFile();
     }*/
 }
+
+#    ifdef MMKV_LINUX
+// also the key of a memfd instance in g_instanceDic, apart from the md5 of paths that file instances use
+static string memfdPathWithID(const string &mmapID) {
+    return "/memfd:" + mmapID;
+}
+
+MMKV::MMKV(const string &mmapID, int memfd, int memfdMeta, const string *cryptKey)
+    : m_mmapID(mmapID)
+    , m_mode(MMKV_MEMFD)
+    , m_path(memfdPathWithID(mmapID))
+    , m_crcPath(crcPathWithPath(m_path))
+    , m_dic(nullptr)
+    , m_dicCrypt(nullptr)
+    , m_expectedCapacity(DEFAULT_MMAP_SIZE)
+    , m_file(new MemoryFile(memfd))
+    , m_metaFile(new MemoryFile(memfdMeta))
+    , m_metaInfo(new MMKVMetaInfo())
+    , m_crypter(nullptr)
+    , m_lock(new ThreadLock())
+    , m_fileLock(new FileLock(m_metaFile->getFd()))
+    , m_sharedProcessLock(new InterProcessLock(m_fileLock, SharedLockType))
+    , m_exclusiveProcessLock(new InterProcessLock(m_fileLock, ExclusiveLockType))
+{
+    m_actualSize = 0;
+    m_output = nullptr;
+
+#        ifndef MMKV_DISABLE_CRYPT
+    if (cryptKey && !cryptKey->empty()) {
+        m_dicCrypt = new MMKVMapCrypt();
+        m_crypter = new AESCrypt(cryptKey->data(), cryptKey->length());
+    } else {
+        m_dic = new MMKVMap();
+    }
+#        else
+    m_dic = new MMKVMap();
+#        endif
+
+    m_needLoadFromFile = true;
+    m_hasFullWriteback = false;
+
+    m_crcDigest = 0;
+
+    m_lock->initialize();
+    m_sharedProcessLock->m_enable = true;
+    m_exclusiveProcessLock->m_enable = true;
+    m_file->enableDirtyTracking();
+}
+#    endif // MMKV_LINUX
 #endif
 
 MMKV::~MMKV() {
-    clearMemoryCache();
+    doClearMemoryCache();
 
     delete m_dic;
+    delete m_lazyIndex;
+#ifndef MMKV_APPLE
+    delete m_valueCache;
+    delete m_changedKeys;
+#endif
 #ifndef MMKV_DISABLE_CRYPT
     delete m_dicCrypt;
     delete m_crypter;
@@ -197,6 +329,36 @@ static void initialize() {
 #    endif // MMKV_USE_ARMV8_CRC32
 #endif     // __aarch64__ && defined(__linux__) && !defined (MMKV_OHOS)
 
+    // get CPU status of x86-64 extensions (AES-NI, VAES, PCLMULQDQ)
+#if defined(MMKV_USE_AES_NI) && (__ARM_MAX_ARCH__ <= 7) && !defined(MMKV_DISABLE_CRYPT)
+    auto aesCapability = openssl::AES_NI_capability();
+    if (aesCapability != openssl::AESNINotSupported) {
+        openssl::AES_set_encrypt_key = openssl::AES_NI_set_encrypt_key;
+        openssl::AES_set_decrypt_key = openssl::AES_NI_set_decrypt_key;
+        openssl::AES_encrypt = openssl::AES_NI_encrypt;
+        openssl::AES_decrypt = openssl::AES_NI_decrypt;
+        if (aesCapability == openssl::AESNIWithVAESSupported) {
+            openssl::AES_cfb128_decrypt_blocks = openssl::AES_VAES_cfb128_decrypt_blocks;
+            openssl::AES_ctr128_encrypt_blocks = openssl::AES_VAES_ctr128_encrypt_blocks;
+            MMKVInfo("x86-64 AES-NI & VAES instructions is supported");
+        } else {
+            openssl::AES_cfb128_decrypt_blocks = openssl::AES_NI_cfb128_decrypt_blocks;
+            openssl::AES_ctr128_encrypt_blocks = openssl::AES_NI_ctr128_encrypt_blocks;
+            MMKVInfo("x86-64 AES-NI instructions is supported");
+        }
+    } else {
+        MMKVInfo("x86-64 AES-NI instructions is not supported");
+    }
+#endif // MMKV_USE_AES_NI && !MMKV_DISABLE_CRYPT
+#ifdef MMKV_USE_PCLMUL_CRC32
+    if (mmkv::pclmul_crc32_supported()) {
+        CRC32 = mmkv::pclmul_crc32;
+        MMKVInfo("x86-64 PCLMULQDQ instructions is supported");
+    } else {
+        MMKVInfo("x86-64 PCLMULQDQ instructions is not supported");
+    }
+#endif // MMKV_USE_PCLMUL_CRC32
+
 #if defined(MMKV_DEBUG) && !defined(MMKV_DISABLE_CRYPT)
     // AESCrypt::testAESCrypt();
     // KeyValueHolderCrypt::testAESToMMBuffer();
@@ -244,12 +406,35 @@ MMKV *MMKV::mmkvWithID(const string &mmapID, MMKVMode mode, const string *cryptK
     }
     SCOPED_LOCK(g_instanceLock);
 
+#ifdef MMKV_LINUX
+    auto mmapKey = (mode & MMKV_MEMFD) ? memfdPathWithID(mmapID) : mmapedKVKey(mmapID, rootPath);
+#else
     auto mmapKey = mmapedKVKey(mmapID, rootPath);
+#endif
     auto itr = g_instanceDic->find(mmapKey);
     if (itr != g_instanceDic->end()) {
         MMKV *kv = itr->second;
         return kv;
     }
+#ifdef MMKV_LINUX
+    if (mode & MMKV_MEMFD) {
+        auto fd = createMemfd(mmapID, std::max<size_t>(DEFAULT_MMAP_SIZE, expectedCapacity));
+        auto metaFD = (fd >= 0) ? createMemfd(mmapID + CRC_SUFFIX, DEFAULT_MMAP_SIZE) : -1;
+        if (metaFD < 0) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return nullptr;
+        }
+        MMKVInfo("prepare to load %s (id %s) in memfd", mmapID.c_str(), mmapKey.c_str());
+        auto kv = new MMKV(mmapID, fd, metaFD, cryptKey);
+        kv->m_mmapKey = mmapKey;
+        (*g_instanceDic)[mmapKey] = kv;
+        return kv;
+    }
+#endif
+    // it might be in the middle of backup or restore
+    waitForIdleInstancePath(mappedKVPathWithID(mmapID, rootPath));
 
     if (rootPath && !(mode & MMKV_READ_ONLY)) {
         MMKVPath_t specialPath = (*rootPath) + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
@@ -271,16 +456,58 @@ MMKV *MMKV::mmkvWithID(const string &mmapID, MMKVMode mode, const string *cryptK
 }
 #endif
 
+#ifdef MMKV_LINUX
+MMKV *MMKV::mmkvWithMemfdFD(const string &mmapID, int fd, int metaFD, const string *cryptKey) {
+
+    if (fd < 0 || metaFD < 0 || !g_instanceLock) {
+        return nullptr;
+    }
+    SCOPED_LOCK(g_instanceLock);
+
+    auto mmapKey = memfdPathWithID(mmapID);
+    auto itr = g_instanceDic->find(mmapKey);
+    if (itr != g_instanceDic->end()) {
+        MMKV *kv = itr->second;
+        return kv;
+    }
+    auto memfd = reopenMemfd(fd);
+    auto memfdMeta = (memfd >= 0) ? reopenMemfd(metaFD) : -1;
+    if (memfdMeta < 0) {
+        if (memfd >= 0) {
+            ::close(memfd);
+        }
+        return nullptr;
+    }
+    auto kv = new MMKV(mmapID, memfd, memfdMeta, cryptKey);
+    kv->m_mmapKey = mmapKey;
+    (*g_instanceDic)[mmapKey] = kv;
+    return kv;
+}
+
+int MMKV::memfdFD() {
+    return isMemfd() ? m_file->getFd() : -1;
+}
+
+int MMKV::memfdMetaFD() {
+    return isMemfd() ? m_metaFile->getFd() : -1;
+}
+#endif
+
 void MMKV::onExit() {
     if (!g_instanceLock) {
         return;
     }
+#ifndef MMKV_APPLE
+    stopExpireSweeper();
+#endif
     SCOPED_LOCK(g_instanceLock);
+    // backup, restore & expire sweeping might still be working on some of them
+    waitForAllIdleInstancePaths();
 
     for (auto &pair : *g_instanceDic) {
         MMKV *kv = pair.second;
         kv->sync();
-        kv->clearMemoryCache();
+        kv->doClearMemoryCache();
         delete kv;
         pair.second = nullptr;
     }
@@ -295,11 +522,72 @@ const string &MMKV::mmapID() const {
 
 mmkv::ContentChangeHandler g_contentChangeHandler = nullptr;
 
+#ifndef MMKV_APPLE
+mmkv::ContentKeysChangeHandler g_contentKeysChangeHandler = nullptr;
+#endif
+
 void MMKV::notifyContentChanged() {
     if (g_contentChangeHandler) {
         g_contentChangeHandler(m_mmapID);
     }
+#ifndef MMKV_APPLE
+    if (!m_changedKeys) {
+        return;
+    }
+    unique_ptr<ChangedKeys> changedKeys(m_changedKeys);
+    m_changedKeys = nullptr;
+    auto handler = g_contentKeysChangeHandler;
+    if (handler) {
+        ContentChangedKeys changes;
+        for (auto &itr : *changedKeys) {
+            auto existedBefore = itr.second.first;
+            auto existsAfter = itr.second.second;
+            if (existedBefore && existsAfter) {
+                changes.updatedKeys.push_back(itr.first);
+            } else if (existsAfter) {
+                changes.addedKeys.push_back(itr.first);
+            } else if (existedBefore) {
+                changes.removedKeys.push_back(itr.first);
+            }
+        }
+        handler(m_mmapID, changes);
+    }
+#endif
+}
+
+#ifndef MMKV_APPLE
+void MMKV::beginTrackingChangedKeys() {
+    if (g_contentKeysChangeHandler && !m_changedKeys) {
+        m_changedKeys = new ChangedKeys();
+    }
+}
+
+void MMKV::trackChangedKey(const string &key, bool existedBefore, bool existsAfter) {
+    // the first time we see a key tells whether it had existed before catching up
+    auto ret = m_changedKeys->emplace(key, make_pair(existedBefore, existsAfter));
+    if (!ret.second) {
+        ret.first->second.second = existsAfter;
+    }
+}
+
+vector<string> MMKV::loadedKeys() const {
+    vector<string> keys;
+#ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        keys.reserve(m_dicCrypt->size());
+        for (auto &itr : *m_dicCrypt) {
+            keys.push_back(itr.first);
+        }
+        return keys;
+    }
+#endif
+    keys.reserve(m_dic->size());
+    for (auto &itr : *m_dic) {
+        keys.push_back(itr.first);
+    }
+    return keys;
 }
+#endif // !MMKV_APPLE
 
 void MMKV::checkContentChanged() {
     SCOPED_LOCK(m_lock);
@@ -314,16 +602,39 @@ void MMKV::unRegisterContentChangeHandler() {
     g_contentChangeHandler = nullptr;
 }
 
+#ifndef MMKV_APPLE
+void MMKV::registerContentKeysChangeHandler(mmkv::ContentKeysChangeHandler handler) {
+    g_contentKeysChangeHandler = handler;
+}
+
+void MMKV::unRegisterContentKeysChangeHandler() {
+    g_contentKeysChangeHandler = nullptr;
+}
+#endif
+
 void MMKV::clearMemoryCache(bool keepSpace) {
+    SCOPED_LOCK(m_lock);
+    if (!keepSpace && !m_needLoadFromFile) {
+        // unmapping alone leaves the pages in the page cache as if they were still hot
+        adviseDataAccess(AccessHint::Cold, m_actualSize);
+    }
+    doClearMemoryCache(keepSpace);
+}
+
+void MMKV::doClearMemoryCache(bool keepSpace) {
     SCOPED_LOCK(m_lock);
     if (m_needLoadFromFile) {
         return;
     }
+    detachSnapshots();
     MMKVInfo("clearMemoryCache [%s]", m_mmapID.c_str());
     m_needLoadFromFile = true;
     m_hasFullWriteback = false;
+    m_lazyLookupFailed = false;
 
     clearDictionary(m_dic);
+    clearExpireIndex();
+    clearDecryptedValueCache();
 #ifndef MMKV_DISABLE_CRYPT
     clearDictionary(m_dicCrypt);
     if (m_crypter) {
@@ -347,10 +658,58 @@ void MMKV::clearMemoryCache(bool keepSpace) {
     m_metaInfo->m_crcDigest = 0;
 }
 
+void MMKV::enableAccessHints(bool enable) {
+    SCOPED_LOCK(m_lock);
+    m_enableAccessHints = enable;
+    if (!m_needLoadFromFile) {
+        adviseDataAccess(enable ? AccessHint::Random : AccessHint::Normal, m_actualSize);
+    }
+}
+
+void MMKV::reclaimPageCache(bool pageOut) {
+    SCOPED_LOCK(m_lock);
+    if (m_needLoadFromFile) {
+        return;
+    }
+    MMKVInfo("reclaimPageCache [%s], pageOut %d", m_mmapID.c_str(), pageOut);
+    m_file->adviseAccess(pageOut ? AccessHint::PageOut : AccessHint::Cold, 0, m_file->getFileSize());
+}
+
+void MMKV::reclaimAllPageCache(bool pageOut) {
+    if (!g_instanceLock) {
+        return;
+    }
+    SCOPED_LOCK(g_instanceLock);
+
+    for (auto &pair : *g_instanceDic) {
+        pair.second->reclaimPageCache(pageOut);
+    }
+}
+
+void MMKV::detachSnapshots() {
+#ifndef MMKV_APPLE
+    if (mmkv_likely(m_snapshots.empty())) {
+        return;
+    }
+    for (auto &weakSnapshot : m_snapshots) {
+        if (auto snapshot = weakSnapshot.lock()) {
+            snapshot->detach();
+        }
+    }
+    m_snapshots.clear();
+#endif
+}
+
 void MMKV::close() {
     MMKVInfo("close [%s]", m_mmapID.c_str());
     SCOPED_LOCK(g_instanceLock);
+    // it might be in the middle of expire sweeping
+    waitForIdleInstancePath(m_path);
     m_lock->lock();
+    if (!m_needLoadFromFile) {
+        // no longer needed in the near future
+        adviseDataAccess(AccessHint::Cold, m_actualSize);
+    }
 
     auto itr = g_instanceDic->find(m_mmapKey);
     if (itr != g_instanceDic->end()) {
@@ -361,6 +720,13 @@ void MMKV::close() {
 
 #ifndef MMKV_DISABLE_CRYPT
 
+MMKVCryptMode MMKV::cryptMode() {
+    SCOPED_LOCK(m_lock);
+    SCOPED_LOCK(m_sharedProcessLock);
+    checkLoadData();
+    return m_crypter ? m_crypter->cryptMode() : MMKVCryptCFB;
+}
+
 string MMKV::cryptKey() const {
     SCOPED_LOCK(m_lock);
 
@@ -382,7 +748,7 @@ void MMKV::checkReSetCryptKey(const string *cryptKey) {
                 MMKVInfo("setting new aes key");
                 delete m_crypter;
                 auto ptr = cryptKey->data();
-                m_crypter = new AESCrypt(ptr, cryptKey->length());
+                m_crypter = new AESCrypt(ptr, cryptKey->length(), nullptr, 0, m_metaInfo->cryptMode());
 
                 checkLoadData();
             } else {
@@ -399,7 +765,7 @@ void MMKV::checkReSetCryptKey(const string *cryptKey) {
         if (cryptKey && !cryptKey->empty()) {
             MMKVInfo("setting new aes key");
             auto ptr = cryptKey->data();
-            m_crypter = new AESCrypt(ptr, cryptKey->length());
+            m_crypter = new AESCrypt(ptr, cryptKey->length(), nullptr, 0, m_metaInfo->cryptMode());
 
             checkLoadData();
         } else {
@@ -430,21 +796,13 @@ bool MMKV::checkFileCRCValid(size_t actualSize, uint32_t crcDigest) {
     return false;
 }
 
-void MMKV::recalculateCRCDigestWithIV(const void *iv) {
-    auto ptr = (const uint8_t *) m_file->getMemory();
-    if (ptr) {
-        m_crcDigest = 0;
-        m_crcDigest = (uint32_t) CRC32(0, ptr + Fixed32Size, (uint32_t) m_actualSize);
-        writeActualSize(m_actualSize, m_crcDigest, iv, IncreaseSequence);
-    }
-}
-
-void MMKV::recalculateCRCDigestOnly() {
+void MMKV::recalculateCRCDigestWithIV(const void *iv, AESCrypt *crypter, size_t unchangedSize, bool logSequence) {
     auto ptr = (const uint8_t *) m_file->getMemory();
     if (ptr) {
-        m_crcDigest = 0;
-        m_crcDigest = (uint32_t) CRC32(0, ptr + Fixed32Size, (uint32_t) m_actualSize);
-        writeActualSize(m_actualSize, m_crcDigest, nullptr, KeepSequence);
+        m_file->markDirty(Fixed32Size + unchangedSize, m_actualSize - std::min(unchangedSize, m_actualSize));
+        m_crcDigest = recalculateSegmentCRC(crypter, unchangedSize);
+        writeActualSize(m_actualSize, m_crcDigest, iv, IncreaseSequence, logSequence);
+        confirmSegmentCRC();
     }
 }
 
@@ -452,9 +810,161 @@ void MMKV::updateCRCDigest(const uint8_t *ptr, size_t length) {
     if (ptr == nullptr) {
         return;
     }
-    m_crcDigest = (uint32_t) CRC32(m_crcDigest, ptr, (uint32_t) length);
+    m_file->markDirty(ptr - (const uint8_t *) m_file->getMemory(), length);
 
+#ifndef MMKV_APPLE
+    auto hasSegmentCRC = isSegmentCRCValid();
+    if (hasSegmentCRC) {
+        // the table checksums the appended bytes and derives the whole digest from them
+        SegmentCRCTable table(m_metaFile->getMemory());
+        auto basePtr = (const uint8_t *) m_file->getMemory() + Fixed32Size;
+        m_crcDigest = table.append(basePtr, m_actualSize - length, m_actualSize, m_crcDigest);
+    } else {
+        m_crcDigest = (uint32_t) CRC32(m_crcDigest, ptr, (uint32_t) length);
+    }
+    writeActualSize(m_actualSize, m_crcDigest, nullptr, KeepSequence);
+    if (hasSegmentCRC) {
+        confirmSegmentCRC();
+    }
+#else
+    m_crcDigest = (uint32_t) CRC32(m_crcDigest, ptr, (uint32_t) length);
     writeActualSize(m_actualSize, m_crcDigest, nullptr, KeepSequence);
+#endif
+}
+
+bool MMKV::canKeepSegmentCRC() const {
+#ifndef MMKV_APPLE
+    return !isReadOnly() && m_metaFile->isFileValid() &&
+           m_metaFile->getFileSize() >= SegmentCRCTable::TableOffset + SegmentCRCTable::TableSize;
+#else
+    return false;
+#endif
+}
+
+bool MMKV::isSegmentCRCValid() const {
+#ifndef MMKV_APPLE
+    if (!canKeepSegmentCRC() || m_metaInfo->m_version < MMKVVersionSegmentCRC) {
+        return false;
+    }
+    SegmentCRCTable table(m_metaFile->getMemory());
+    return table.isValid(m_metaInfo->m_actualSize, m_metaInfo->m_crcDigest);
+#else
+    return false;
+#endif
+}
+
+uint32_t MMKV::recalculateSegmentCRC(AESCrypt *crypter, size_t unchangedSize) {
+    auto ptr = (const uint8_t *) m_file->getMemory() + Fixed32Size;
+#ifndef MMKV_APPLE
+    if (canKeepSegmentCRC()) {
+        SegmentCRCTable table(m_metaFile->getMemory());
+        MMBuffer data((void *) ptr, m_actualSize, MMBufferNoCopy);
+        // only the items after the unchanged ones need checksum & indexing
+        if (!crypter && unchangedSize > 0 && isSegmentCRCValid()) {
+            auto itemOffsets = MiniPBCoder::decodeItemOffsets(data, unchangedSize);
+            return table.update(ptr, m_actualSize, unchangedSize, itemOffsets);
+        }
+#    ifndef MMKV_DISABLE_CRYPT
+        if (crypter) {
+            AESCryptStatus status;
+            crypter->statusAtPosition(0, status);
+            auto decrypter = crypter->cloneWithStatus(status);
+            return table.rebuild(ptr, m_actualSize, MiniPBCoder::decodeItemOffsets(data, &decrypter));
+        }
+#    endif
+        return table.rebuild(ptr, m_actualSize, MiniPBCoder::decodeItemOffsets(data));
+    }
+#endif
+    return (uint32_t) CRC32(0, ptr, (uint32_t) m_actualSize);
+}
+
+void MMKV::confirmSegmentCRC() {
+#ifndef MMKV_APPLE
+    if (!canKeepSegmentCRC()) {
+        return;
+    }
+    if (m_metaInfo->m_version < MMKVVersionSegmentCRC) {
+        m_metaInfo->m_version = MMKVVersionSegmentCRC;
+        m_metaInfo->write(m_metaFile->getMemory());
+    }
+    SegmentCRCTable table(m_metaFile->getMemory());
+    table.confirm(m_actualSize, m_crcDigest);
+#endif
+}
+
+void MMKV::checkSegmentCRC() {
+#ifndef MMKV_APPLE
+    if (!canKeepSegmentCRC() || isSegmentCRCValid()) {
+        return;
+    }
+    SCOPED_LOCK(m_exclusiveProcessLock);
+
+    auto crcDigest = recalculateSegmentCRC(m_crypter, 0);
+    if (crcDigest == m_crcDigest && m_actualSize == m_metaInfo->m_actualSize) {
+        confirmSegmentCRC();
+        MMKVInfo("[%s] segment crc rebuilt for %zu actual size", m_mmapID.c_str(), m_actualSize);
+    } else {
+        MMKVWarning("[%s] segment crc %u not equal to crc digest %u", m_mmapID.c_str(), crcDigest, m_crcDigest);
+    }
+#endif
+}
+
+bool MMKV::salvageBySegmentCRC() {
+#ifndef MMKV_APPLE
+    if (m_actualSize != m_metaInfo->m_actualSize || !isSegmentCRCValid()) {
+        return false;
+    }
+    SegmentCRCTable table(m_metaFile->getMemory());
+    auto basePtr = (uint8_t *) m_file->getMemory() + Fixed32Size;
+    auto damaged = table.damagedSegments(basePtr, m_actualSize);
+    auto segmentSize = table.segmentSize();
+    auto segmentCount = damaged.size();
+    MMKVInfo("[%s] %zu of %zu segments damaged", m_mmapID.c_str(), std::count(damaged.begin(), damaged.end(), true),
+             segmentCount);
+
+    // decode each run of good segments, the items that cross the damaged ones are dropped
+    for (size_t index = 0; index < segmentCount;) {
+        if (damaged[index]) {
+            index++;
+            continue;
+        }
+        auto runBegin = index;
+        while (index < segmentCount && !damaged[index]) {
+            index++;
+        }
+        auto start = runBegin * segmentSize;
+        auto end = min(index * segmentSize, m_actualSize);
+        size_t position = (runBegin == 0) ? 0 : table.firstItem(runBegin);
+#    ifndef MMKV_DISABLE_CRYPT
+        // CFB needs the ciphertext of the previous block to start decrypting
+        if (m_crypter && !m_crypter->isRandomAccess()) {
+            for (auto next = runBegin + 1; position > 0 && position < start + AES_KEY_LEN; next++) {
+                position = (next < index) ? table.firstItem(next) : end;
+            }
+        }
+#    endif
+        if (runBegin > 0 && (position < start || position >= end)) {
+            continue;
+        }
+        MMBuffer inputBuffer(basePtr, end, MMBufferNoCopy);
+#    ifndef MMKV_DISABLE_CRYPT
+        if (m_crypter) {
+            AESCryptStatus status;
+            m_crypter->statusAtPosition(position, status, basePtr);
+            auto decrypter = m_crypter->cloneWithStatus(status);
+            MiniPBCoder::greedyDecodeMap(*m_dicCrypt, inputBuffer, &decrypter, position, isLazyDecrypt());
+        } else
+#    endif
+        {
+            MiniPBCoder::greedyDecodeMap(*m_dic, inputBuffer, position);
+        }
+    }
+    // the table describes the damaged data, let the full writeback rebuild it
+    table.invalidate();
+    return true;
+#else
+    return false;
+#endif
 }
 
 // set & get
@@ -792,6 +1302,23 @@ void MMKV::shared_unlock() {
     m_lock->unlock();
 }
 
+template <typename T, bool (*decode)(const void *, size_t, T &)>
+bool MMKV::getPrimitiveInPlace(MMKVKey_t key, T &value, bool *hasValue) {
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    if (mmkv_unlikely(!getRawValuePtrForKey(key, ptr, size))) {
+        return false;
+    }
+    bool found = ptr && decode(ptr, size, value);
+    if (mmkv_unlikely(ptr && !found)) {
+        MMKVError("[%s] fail to decode a value of %zu bytes", m_mmapID.c_str(), size);
+    }
+    if (hasValue != nullptr) {
+        *hasValue = found;
+    }
+    return true;
+}
+
 bool MMKV::getBool(MMKVKey_t key, bool defaultValue, bool *hasValue) {
     if (isKeyEmpty(key)) {
         if (hasValue != nullptr) {
@@ -801,6 +1328,10 @@ bool MMKV::getBool(MMKVKey_t key, bool defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<bool, CodedInputData::decodeBool>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -830,6 +1361,10 @@ int32_t MMKV::getInt32(MMKVKey_t key, int32_t defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<int32_t, CodedInputData::decodeInt32>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -859,6 +1394,10 @@ uint32_t MMKV::getUInt32(MMKVKey_t key, uint32_t defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<uint32_t, CodedInputData::decodeUInt32>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -888,6 +1427,10 @@ int64_t MMKV::getInt64(MMKVKey_t key, int64_t defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<int64_t, CodedInputData::decodeInt64>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -917,6 +1460,10 @@ uint64_t MMKV::getUInt64(MMKVKey_t key, uint64_t defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<uint64_t, CodedInputData::decodeUInt64>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -946,6 +1493,10 @@ float MMKV::getFloat(MMKVKey_t key, float defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<float, CodedInputData::decodeFloat>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -975,6 +1526,10 @@ double MMKV::getDouble(MMKVKey_t key, double defaultValue, bool *hasValue) {
     }
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
+    auto value = defaultValue;
+    if (mmkv_likely((getPrimitiveInPlace<double, CodedInputData::decodeDouble>(key, value, hasValue)))) {
+        return value;
+    }
     auto data = getDataForKey(key);
     if (data.length() > 0) {
         try {
@@ -1021,33 +1576,42 @@ size_t MMKV::getValueSize(MMKVKey_t key, bool actualSize) {
     return data.length();
 }
 
-int32_t MMKV::writeValueToBuffer(MMKVKey_t key, void *ptr, int32_t size) {
-    if (isKeyEmpty(key) || size < 0) {
+// the data should be a length-prefixed bytes, or any other raw encoded data, return -1 if it won't fit
+static int32_t writeDataToBuffer(const MMBuffer &data, void *ptr, int32_t size) {
+    if (size < 0) {
         return -1;
     }
     auto s_size = static_cast<size_t>(size);
+    CodedInputData input(data.getPtr(), data.length());
+    auto length = input.readInt32();
+    auto offset = pbRawVarint32Size(length);
+    if (length >= 0) {
+        auto s_length = static_cast<size_t>(length);
+        if (offset + s_length == data.length()) {
+            if (s_length <= s_size) {
+                memcpy(ptr, (uint8_t *) data.getPtr() + offset, s_length);
+                return length;
+            }
+        } else {
+            if (data.length() <= s_size) {
+                memcpy(ptr, data.getPtr(), data.length());
+                return static_cast<int32_t>(data.length());
+            }
+        }
+    }
+    return -1;
+}
+
+int32_t MMKV::writeValueToBuffer(MMKVKey_t key, void *ptr, int32_t size) {
+    if (isKeyEmpty(key) || size < 0) {
+        return -1;
+    }
 
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_sharedProcessLock);
     auto data = getDataForKey(key);
     try {
-        CodedInputData input(data.getPtr(), data.length());
-        auto length = input.readInt32();
-        auto offset = pbRawVarint32Size(length);
-        if (length >= 0) {
-            auto s_length = static_cast<size_t>(length);
-            if (offset + s_length == data.length()) {
-                if (s_length <= s_size) {
-                    memcpy(ptr, (uint8_t *) data.getPtr() + offset, s_length);
-                    return length;
-                }
-            } else {
-                if (data.length() <= s_size) {
-                    memcpy(ptr, data.getPtr(), data.length());
-                    return static_cast<int32_t>(data.length());
-                }
-            }
-        }
+        return writeDataToBuffer(data, ptr, size);
     } catch (std::exception &exception) {
         MMKVError("%s", exception.what());
     } catch (...) {
@@ -1078,8 +1642,13 @@ size_t MMKV::count(bool filterExpire) {
     checkLoadData();
 
     if (mmkv_unlikely(filterExpire && m_enableKeyExpire)) {
+#ifndef MMKV_APPLE
+        // expired keys are dropped from memory only, they are gone from the file on next full writeback
+        filterExpiredKeys();
+#else
         SCOPED_LOCK(m_exclusiveProcessLock);
         fullWriteback(nullptr, true);
+#endif
     }
 
     if (m_crypter) {
@@ -1123,8 +1692,7 @@ vector<string> MMKV::allKeys(bool filterExpire) {
     checkLoadData();
 
     if (mmkv_unlikely(filterExpire && m_enableKeyExpire)) {
-        SCOPED_LOCK(m_exclusiveProcessLock);
-        fullWriteback(nullptr, true);
+        filterExpiredKeys();
     }
 
     vector<string> keys;
@@ -1140,6 +1708,353 @@ vector<string> MMKV::allKeys(bool filterExpire) {
     return keys;
 }
 
+size_t MMKV::sweepExpiredKeys(size_t maxCount) {
+    if (isReadOnly()) {
+        return 0;
+    }
+    SCOPED_LOCK(m_lock);
+    // never load an instance just for sweeping
+    if (m_needLoadFromFile || !m_enableKeyExpire) {
+        return 0;
+    }
+    SCOPED_LOCK(m_exclusiveProcessLock);
+    checkLoadData();
+    if (!m_enableKeyExpire) {
+        return 0;
+    }
+
+    auto now = getCurrentTimeInSecond();
+    size_t count = 0;
+    string key;
+    uint32_t time = 0;
+    while (count < maxCount && popExpiredKey(now, key, time)) {
+        if (removeDataForKey(key)) {
+            count++;
+        }
+    }
+    if (count > 0) {
+        MMKVInfo("swept %zu expired keys inside [%s]", count, m_mmapID.c_str());
+    }
+    return count;
+}
+
+static mutex g_sweeperMutex;
+static condition_variable g_sweeperCondition;
+static thread *g_sweeperThread = nullptr;
+static bool g_sweeperStopped = false;
+
+void MMKV::startExpireSweeper(uint32_t intervalInSeconds, size_t batchSize) {
+    stopExpireSweeper();
+
+    lock_guard<mutex> lock(g_sweeperMutex);
+    g_sweeperStopped = false;
+    g_sweeperThread = new thread([intervalInSeconds, batchSize] {
+        MMKVInfo("expire sweeper started, interval %u seconds, batch size %zu", intervalInSeconds, batchSize);
+        unique_lock<mutex> sweeperLock(g_sweeperMutex);
+        auto interval = chrono::seconds(max<uint32_t>(1, intervalInSeconds));
+        while (!g_sweeperCondition.wait_for(sweeperLock, interval, [] { return g_sweeperStopped; })) {
+            sweeperLock.unlock();
+            if (g_instanceLock) {
+                // sweep one instance at a time without g_instanceLock, it's marked busy so that it's not closed meanwhile
+                unique_lock<ThreadLock> instanceLock(*g_instanceLock);
+                vector<string> mmapKeys;
+                if (g_instanceDic) {
+                    for (auto &pair : *g_instanceDic) {
+                        mmapKeys.push_back(pair.first);
+                    }
+                }
+                for (auto &mmapKey : mmapKeys) {
+                    if (!g_instanceDic) {
+                        break;
+                    }
+                    auto itr = g_instanceDic->find(mmapKey);
+                    if (itr == g_instanceDic->end() || !itr->second) {
+                        continue;
+                    }
+                    auto kv = itr->second;
+                    // being backed up or restored, leave it to the next round
+                    if (g_busyInstancePaths.find(kv->m_path) != g_busyInstancePaths.end()) {
+                        continue;
+                    }
+                    BusyInstanceScope busyScope(instanceLock, kv->m_path);
+                    kv->sweepExpiredKeys(batchSize);
+                }
+            }
+            sweeperLock.lock();
+        }
+        MMKVInfo("expire sweeper stopped");
+    });
+}
+
+void MMKV::stopExpireSweeper() {
+    thread *sweeper = nullptr;
+    {
+        lock_guard<mutex> lock(g_sweeperMutex);
+        g_sweeperStopped = true;
+        swap(sweeper, g_sweeperThread);
+    }
+    if (sweeper) {
+        g_sweeperCondition.notify_all();
+        sweeper->join();
+        delete sweeper;
+    }
+}
+
+void MMKV::forEach(const ForEachCallback &callback, bool filterExpire) {
+    if (!callback) {
+        return;
+    }
+    SCOPED_LOCK(m_lock);
+    SCOPED_LOCK(m_sharedProcessLock);
+    checkLoadData();
+
+    auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
+    auto now = (filterExpire && m_enableKeyExpire) ? getCurrentTimeInSecond() : 0;
+    auto yield = [&](const string &key, MMBuffer &&raw) {
+        if (mmkv_likely(!m_enableKeyExpire)) {
+            return callback(key, raw);
+        }
+        if (raw.length() < Fixed32Size) {
+            MMKVWarning("key [%s] has invalid value size %u", key.c_str(), raw.length());
+            return true;
+        }
+        auto newLength = raw.length() - Fixed32Size;
+        if (filterExpire) {
+            auto ptr = (const uint8_t *) raw.getPtr() + newLength;
+            auto time = *(const uint32_t *) ptr;
+            if (time != ExpireNever && time <= now) {
+                return true;
+            }
+        }
+        MMBuffer value(std::move(raw), newLength);
+        return callback(key, value);
+    };
+
+#ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        for (const auto &itr : *m_dicCrypt) {
+            if (!yield(itr.first, itr.second.toMMBuffer(basePtr, m_crypter))) {
+                break;
+            }
+        }
+    } else
+#endif
+    {
+        for (const auto &itr : *m_dic) {
+            if (!yield(itr.first, itr.second.toMMBuffer(basePtr))) {
+                break;
+            }
+        }
+    }
+}
+
+shared_ptr<MMKVSnapshot> MMKV::snapshot() {
+    SCOPED_LOCK(m_lock);
+    SCOPED_LOCK(m_sharedProcessLock);
+    checkLoadData();
+
+    auto basePtr = isFileValid() ? (const uint8_t *) m_file->getMemory() + Fixed32Size : nullptr;
+    AESCrypt *crypter = nullptr;
+#ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        // decrypting the prefix needs a crypter rewound to the very beginning
+        uint8_t key[AES_KEY_LEN];
+        m_crypter->getKey(key);
+        crypter = new AESCrypt(key, AES_KEY_LEN, nullptr, 0, m_crypter->cryptMode());
+        if (m_metaInfo->m_version >= MMKVVersionRandomIV) {
+            crypter->resetIV(m_metaInfo->m_vector, sizeof(m_metaInfo->m_vector));
+        }
+    }
+#endif
+    auto now = m_enableKeyExpire ? getCurrentTimeInSecond() : 0;
+    shared_ptr<MMKVSnapshot> snapshot(
+        new MMKVSnapshot(m_mmapID, basePtr, m_actualSize, m_metaInfo->m_sequence, crypter, m_enableKeyExpire, now));
+    if (isMultiProcess()) {
+        // other processes may rewrite the file at any time without telling us
+        snapshot->detach();
+    } else {
+        auto expired = [](const weak_ptr<MMKVSnapshot> &weakSnapshot) { return weakSnapshot.expired(); };
+        m_snapshots.erase(remove_if(m_snapshots.begin(), m_snapshots.end(), expired), m_snapshots.end());
+        m_snapshots.push_back(snapshot);
+    }
+    return snapshot;
+}
+
+void MMKV::enableDecryptedValueCache(size_t sizeLimit) {
+    SCOPED_LOCK(m_lock);
+    if (sizeLimit > 0 && m_valueCache) {
+        m_valueCache->setSizeLimit(sizeLimit);
+        return;
+    }
+    if (sizeLimit == 0 && !m_valueCache) {
+        return;
+    }
+    // the values kept in memory are decided on loading, so reload with/without lazy decrypting
+    doClearMemoryCache();
+    delete m_valueCache;
+    m_valueCache = sizeLimit > 0 ? new DecryptedValueCache(sizeLimit) : nullptr;
+    MMKVInfo("decrypted value cache of [%s] size limit %zu", m_mmapID.c_str(), sizeLimit);
+}
+
+MMKV::DecryptedValueCacheStats MMKV::decryptedValueCacheStats() {
+    SCOPED_LOCK(m_lock);
+    DecryptedValueCacheStats stats;
+    if (m_valueCache) {
+        stats.hitCount = m_valueCache->hitCount();
+        stats.missCount = m_valueCache->missCount();
+        stats.itemCount = m_valueCache->itemCount();
+        stats.totalSize = m_valueCache->totalSize();
+        stats.sizeLimit = m_valueCache->sizeLimit();
+    }
+    return stats;
+}
+
+size_t MMKV::getManyData(const vector<string> &keys, const DataDecoder &decoder) {
+    SCOPED_LOCK(m_lock);
+    SCOPED_LOCK(m_sharedProcessLock);
+    checkLoadData();
+
+    auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
+    auto now = m_enableKeyExpire ? getCurrentTimeInSecond() : 0;
+    size_t count = 0;
+    for (size_t index = 0; index < keys.size(); index++) {
+        const auto &key = keys[index];
+        MMBuffer data;
+#ifndef MMKV_DISABLE_CRYPT
+        if (m_crypter) {
+            auto itr = m_dicCrypt->find(key);
+            if (itr != m_dicCrypt->end()) {
+                data = decryptValue(key, itr->second, basePtr);
+            }
+        } else
+#endif
+        {
+            auto itr = m_dic->find(key);
+            if (itr != m_dic->end()) {
+                data = itr->second.toMMBuffer(basePtr);
+            }
+        }
+        if (mmkv_unlikely(m_enableKeyExpire) && data.length() > 0) {
+            if (data.length() < Fixed32Size) {
+                MMKVWarning("key [%s] has invalid value size %u", key.c_str(), data.length());
+                continue;
+            }
+            auto newLength = data.length() - Fixed32Size;
+            auto time = *(const uint32_t *) ((const uint8_t *) data.getPtr() + newLength);
+            if (time != ExpireNever && time <= now) {
+                continue;
+            }
+            data = MMBuffer(std::move(data), newLength);
+        }
+        if (data.length() > 0) {
+            try {
+                if (decoder(index, data)) {
+                    count++;
+                }
+            } catch (std::exception &exception) {
+                MMKVError("%s", exception.what());
+            } catch (...) {
+                MMKVError("decode fail");
+            }
+        }
+    }
+    return count;
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<bool> &results, bool defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readBool();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<int32_t> &results, int32_t defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readInt32();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<uint32_t> &results, uint32_t defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readUInt32();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<int64_t> &results, int64_t defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readInt64();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<uint64_t> &results, uint64_t defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readUInt64();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<float> &results, float defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readFloat();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<double> &results, double defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readDouble();
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<string> &results, const string &defaultValue) {
+    results.assign(keys.size(), defaultValue);
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        input.readString(results[index]);
+        return true;
+    });
+}
+
+size_t MMKV::getMany(const vector<string> &keys, vector<MMBuffer> &results) {
+    results.clear();
+    results.resize(keys.size());
+    return getManyData(keys, [&results](size_t index, const MMBuffer &data) {
+        CodedInputData input(data.getPtr(), data.length());
+        results[index] = input.readData();
+        return true;
+    });
+}
+
+size_t MMKV::writeValuesToBuffers(const vector<string> &keys, void *const *buffers, int32_t *sizes) {
+    if (!buffers || !sizes) {
+        return 0;
+    }
+    vector<int32_t> capacities(sizes, sizes + keys.size());
+    std::fill(sizes, sizes + keys.size(), -1);
+    return getManyData(keys, [&](size_t index, const MMBuffer &data) {
+        sizes[index] = writeDataToBuffer(data, buffers[index], capacities[index]);
+        return sizes[index] >= 0;
+    });
+}
+
 bool MMKV::removeValuesForKeys(const vector<string> &arrKeys) {
     if (isReadOnly()) {
         MMKVWarning("[%s] file readonly", m_mmapID.c_str());
@@ -1161,6 +2076,7 @@ bool MMKV::removeValuesForKeys(const vector<string> &arrKeys) {
         for (const auto &key : arrKeys) {
             auto itr = m_dicCrypt->find(key);
             if (itr != m_dicCrypt->end()) {
+                eraseDecryptedValue(key);
                 m_dicCrypt->erase(itr);
                 deleteCount++;
             }
@@ -1225,6 +2141,139 @@ bool MMKV::try_lock_thread() {
 
 // backup
 
+#ifndef MMKV_APPLE
+// what a backup is made from, saved beside the backup files after they are all written
+struct BackupManifest {
+    uint32_t version;
+    uint32_t sequence;
+    uint32_t crcDigest;
+    uint32_t actualSize;
+    // crc32 of the whole meta file
+    uint32_t metaDigest;
+    uint32_t reserved;
+    // size of the backup data file
+    uint64_t fileSize;
+};
+constexpr uint32_t BackupManifestVersion = 1;
+
+static bool readBackupManifest(const MMKVPath_t &path, BackupManifest &manifest) {
+    if (!isFileExist(path)) {
+        return false;
+    }
+    unique_ptr<MMBuffer> buffer(readWholeFile(path));
+    if (!buffer || buffer->length() < sizeof(BackupManifest)) {
+        return false;
+    }
+    memcpy(&manifest, buffer->getPtr(), sizeof(BackupManifest));
+    return manifest.version == BackupManifestVersion;
+}
+
+static bool writeBackupManifest(const MMKVPath_t &path, const BackupManifest &manifest) {
+#    ifndef MMKV_ANDROID
+    MemoryFile file(path);
+#    else
+    MemoryFile file(path, DEFAULT_MMAP_SIZE, MMFILE_TYPE_FILE);
+#    endif
+    if (!file.isFileValid()) {
+        return false;
+    }
+    memcpy(file.getMemory(), &manifest, sizeof(BackupManifest));
+    return file.msync(MMKV_SYNC);
+}
+
+static size_t fileSizeOf(const MMKVPath_t &path) {
+    File file(path, OpenFlag::ReadOnly);
+    return file.isFileValid() ? file.getActualFileSize() : 0;
+}
+
+// the backup is the source before [tail] had been appended, if the crc digest of the source is the combination of them
+static bool copyAppendedData(MemoryFile &srcFile, const MMKVPath_t &dstPath, const BackupManifest &last,
+                             const BackupManifest &current) {
+    size_t tailStart = Fixed32Size + last.actualSize;
+    size_t tailLength = current.actualSize - last.actualSize;
+    if (Fixed32Size + current.actualSize > srcFile.getFileSize()) {
+        return false;
+    }
+    auto ptr = (const uint8_t *) srcFile.getMemory();
+    auto tailDigest = (uint32_t) CRC32(0, ptr + tailStart, tailLength);
+    if (SegmentCRCTable::combine(last.crcDigest, tailDigest, tailLength) != current.crcDigest) {
+        return false;
+    }
+    File dstFile(dstPath, OpenFlag::WriteOnly);
+    if (!dstFile.isFileValid()) {
+        return false;
+    }
+    auto srcFD = srcFile.getFd();
+    return copyFileRange(srcFD, dstFile.getFd(), 0, Fixed32Size) &&
+           copyFileRange(srcFD, dstFile.getFd(), tailStart, tailLength);
+}
+
+// skip the instance if nothing has changed since the last backup, or only copy what has been appended if possible
+// the caller should hold the process lock of the instance
+static bool backupIncrementally(const string &mmapKey, const MMKVPath_t &srcPath, const MMKVPath_t &dstPath) {
+    auto srcCRCPath = srcPath + CRC_SUFFIX;
+    auto dstCRCPath = dstPath + CRC_SUFFIX;
+    auto manifestPath = dstPath + BACKUP_MANIFEST_SUFFIX;
+
+    unique_ptr<MMBuffer> meta(readWholeFile(srcCRCPath));
+    if (!meta || meta->length() < sizeof(MMKVMetaInfo)) {
+        return false;
+    }
+    MMKVMetaInfo metaInfo;
+    metaInfo.read(meta->getPtr());
+    BackupManifest current = {BackupManifestVersion, metaInfo.m_sequence, metaInfo.m_crcDigest, metaInfo.m_actualSize,
+                              (uint32_t) CRC32(0, (const uint8_t *) meta->getPtr(), meta->length()), 0, 0};
+
+    BackupManifest last = {};
+    auto hasBackup = readBackupManifest(manifestPath, last) && isFileExist(dstCRCPath) &&
+                     fileSizeOf(dstPath) == last.fileSize && last.fileSize > 0;
+    if (hasBackup && last.sequence == current.sequence && last.crcDigest == current.crcDigest &&
+        last.actualSize == current.actualSize && last.metaDigest == current.metaDigest) {
+        MMKVInfo("skip backup of unchanged mmkv[%s]", mmapKey.c_str());
+        return true;
+    }
+    // an interrupted backup leaves no manifest, so that the next one starts over
+    if (isFileExist(manifestPath)) {
+        deleteFile(manifestPath);
+    }
+
+    bool dataCopied = false;
+    if (hasBackup && last.sequence == current.sequence && last.actualSize <= current.actualSize) {
+#    ifndef MMKV_ANDROID
+        MemoryFile srcFile(srcPath, 0, true);
+#    else
+        MemoryFile srcFile(srcPath, 0, MMFILE_TYPE_FILE, 0, true);
+#    endif
+        dataCopied = srcFile.isFileValid() && copyAppendedData(srcFile, dstPath, last, current);
+        if (dataCopied) {
+            MMKVInfo("backup %u bytes appended to mmkv[%s]", current.actualSize - last.actualSize, mmapKey.c_str());
+        }
+    }
+    if (!dataCopied && !copyFile(srcPath, dstPath)) {
+        return false;
+    }
+    if (!copyFile(srcCRCPath, dstCRCPath)) {
+        return false;
+    }
+    current.fileSize = fileSizeOf(dstPath);
+    return writeBackupManifest(manifestPath, current);
+}
+#endif // !MMKV_APPLE
+
+MMKV *MMKV::findCachedInstance(const string &mmapKey, const MMKVPath_t &path, bool compareFullPath) {
+    if (!compareFullPath) {
+        auto itr = g_instanceDic->find(mmapKey);
+        return (itr != g_instanceDic->end()) ? itr->second : nullptr;
+    }
+    // mmapKey is actually filename, we can't simply call find()
+    for (auto &pair : *g_instanceDic) {
+        if (pair.second->m_path == path) {
+            return pair.second;
+        }
+    }
+    return nullptr;
+}
+
 static bool backupOneToDirectoryByFilePath(const string &mmapKey, const MMKVPath_t &srcPath, const MMKVPath_t &dstPath) {
     File crcFile(srcPath, OpenFlag::ReadOnly);
     if (!crcFile.isFileValid()) {
@@ -1242,12 +2291,16 @@ static bool backupOneToDirectoryByFilePath(const string &mmapKey, const MMKVPath
         InterProcessLock lock(&fileLock, SharedLockType);
         SCOPED_LOCK(&lock);
 
+#ifndef MMKV_APPLE
+        ret = backupIncrementally(mmapKey, srcPath, dstPath);
+#else
         ret = copyFile(srcPath, dstPath);
         if (ret) {
             auto srcCRCPath = srcPath + CRC_SUFFIX;
             auto dstCRCPath = dstPath + CRC_SUFFIX;
             ret = copyFile(srcCRCPath, dstCRCPath);
         }
+#endif
         MMKVInfo("finish backup one mmkv[%s]", mmapKey.c_str());
     }
     return ret;
@@ -1258,22 +2311,16 @@ bool MMKV::backupOneToDirectory(const string &mmapKey, const MMKVPath_t &dstPath
         return false;
     }
     // we have to lock the creation of MMKV instance, regardless of in cache or not
-    SCOPED_LOCK(g_instanceLock);
-    MMKV *kv = nullptr;
-    if (!compareFullPath) {
-        auto itr = g_instanceDic->find(mmapKey);
-        if (itr != g_instanceDic->end()) {
-            kv = itr->second;
-        }
-    } else {
-        // mmapKey is actually filename, we can't simply call find()
-        for (auto &pair : *g_instanceDic) {
-            if (pair.second->m_path == srcPath) {
-                kv = pair.second;
-                break;
-            }
-        }
+    unique_lock<ThreadLock> instanceLock(*g_instanceLock);
+    waitForIdleInstancePath(srcPath);
+    auto kv = findCachedInstance(mmapKey, srcPath, compareFullPath);
+#ifdef MMKV_LINUX
+    // keyed & located apart from the files, never expected here
+    if (kv && kv->isMemfd()) {
+        MMKVWarning("memfd mmkv[%s] has no file to back up", kv->m_mmapID.c_str());
+        return false;
     }
+#endif
     // get one in cache, do it the easy way
     if (kv) {
 #ifdef MMKV_WIN32
@@ -1281,20 +2328,27 @@ bool MMKV::backupOneToDirectory(const string &mmapKey, const MMKVPath_t &dstPath
 #else
         MMKVInfo("backup one cached mmkv[%s] from [%s] to [%s]", mmapKey.c_str(), srcPath.c_str(), dstPath.c_str());
 #endif
+        // close() & onExit() wait for it to be idle, other instances can go on meanwhile
+        BusyInstanceScope busyScope(instanceLock, srcPath);
         SCOPED_LOCK(kv->m_lock);
         SCOPED_LOCK(kv->m_sharedProcessLock);
 
         kv->sync();
+#ifndef MMKV_APPLE
+        auto ret = backupIncrementally(mmapKey, kv->m_path, dstPath);
+#else
         auto ret = copyFile(kv->m_path, dstPath);
         if (ret) {
             auto dstCRCPath = dstPath + CRC_SUFFIX;
             ret = copyFile(kv->m_crcPath, dstCRCPath);
         }
+#endif
         MMKVInfo("finish backup one mmkv[%s], ret: %d", mmapKey.c_str(), ret);
         return ret;
     }
 
     // no luck with cache, do it the hard way
+    BusyInstanceScope busyScope(instanceLock, srcPath);
     bool ret = backupOneToDirectoryByFilePath(mmapKey, srcPath, dstPath);
     return ret;
 }
@@ -1343,42 +2397,60 @@ MMKVPath_t filename(const MMKVPath_t &path) {
     return filename;
 }
 
-size_t MMKV::backupAllToDirectory(const MMKVPath_t &dstDir, const MMKVPath_t &srcDir, bool isInSpecialDir) {
+// instance files in the directory that come with a crc file
+static vector<MMKVPath_t> listInstanceFiles(const MMKVPath_t &dir) {
     unordered_set<MMKVPath_t> mmapIDSet;
     unordered_set<MMKVPath_t> mmapIDCRCSet;
-    walkInDir(srcDir, WalkFile, [&](const MMKVPath_t &filePath, WalkType) {
+    walkInDir(dir, WalkFile, [&](const MMKVPath_t &filePath, WalkType) {
         if (endsWith(filePath, CRC_SUFFIX)) {
             mmapIDCRCSet.insert(filePath);
-        } else {
+        } else if (!endsWith(filePath, BACKUP_MANIFEST_SUFFIX) && !endsWith(filePath, COMPACTION_JOURNAL_SUFFIX)) {
             mmapIDSet.insert(filePath);
         }
     });
 
-    size_t count = 0;
-    if (!mmapIDSet.empty()) {
-        mkPath(dstDir);
-        auto compareFullPath = isInSpecialDir;
-        for (auto &srcPath : mmapIDSet) {
-            auto srcCRCPath = srcPath + CRC_SUFFIX;
-            if (mmapIDCRCSet.find(srcCRCPath) == mmapIDCRCSet.end()) {
+    vector<MMKVPath_t> result;
+    for (auto &path : mmapIDSet) {
+        auto crcPath = path + CRC_SUFFIX;
+        if (mmapIDCRCSet.find(crcPath) == mmapIDCRCSet.end()) {
 #ifdef MMKV_WIN32
-                MMKVWarning("crc not exist [%ls]", srcCRCPath.c_str());
+            MMKVWarning("crc not exist [%ls]", crcPath.c_str());
 #else
-                MMKVWarning("crc not exist [%s]", srcCRCPath.c_str());
+            MMKVWarning("crc not exist [%s]", crcPath.c_str());
 #endif
-                continue;
-            }
-            auto basename = filename(srcPath);
-            const auto &strBasename = MMKVPath_t2String(basename);
-            auto mmapKey = isInSpecialDir ? strBasename : mmapedKVKey(strBasename, &srcDir);
-            auto dstPath = dstDir + MMKV_PATH_SLASH;
-            dstPath += basename;
-            if (backupOneToDirectory(mmapKey, dstPath, srcPath, compareFullPath)) {
-                count++;
-            }
+            continue;
         }
+        result.push_back(path);
     }
-    return count;
+    return result;
+}
+
+void MMKV::listBackupJobs(const MMKVPath_t &dstDir, const MMKVPath_t &srcDir, bool isInSpecialDir, vector<TransferJob> &jobs) {
+    auto srcPaths = listInstanceFiles(srcDir);
+    if (srcPaths.empty()) {
+        return;
+    }
+    mkPath(dstDir);
+    for (auto &srcPath : srcPaths) {
+        auto basename = filename(srcPath);
+        const auto &strBasename = MMKVPath_t2String(basename);
+        auto mmapKey = isInSpecialDir ? strBasename : mmapedKVKey(strBasename, &srcDir);
+        auto dstPath = dstDir + MMKV_PATH_SLASH;
+        dstPath += basename;
+        jobs.push_back({std::move(mmapKey), std::move(srcPath), std::move(dstPath), isInSpecialDir});
+    }
+}
+
+vector<MMKV::TransferJob> MMKV::backupJobsOf(const MMKVPath_t &dstDir, const MMKVPath_t &srcDir) {
+    vector<TransferJob> jobs;
+    listBackupJobs(dstDir, srcDir, false, jobs);
+
+    auto specialSrcDir = srcDir + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
+    if (isFileExist(specialSrcDir)) {
+        auto specialDstDir = dstDir + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
+        listBackupJobs(specialDstDir, specialSrcDir, true, jobs);
+    }
+    return jobs;
 }
 
 size_t MMKV::backupAllToDirectory(const MMKVPath_t &dstDir, const MMKVPath_t *srcDir) {
@@ -1386,12 +2458,11 @@ size_t MMKV::backupAllToDirectory(const MMKVPath_t &dstDir, const MMKVPath_t *sr
     if (*rootPath == dstDir) {
         return true;
     }
-    auto count = backupAllToDirectory(dstDir, *rootPath, false);
-
-    auto specialSrcDir = *rootPath + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
-    if (isFileExist(specialSrcDir)) {
-        auto specialDstDir = dstDir + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
-        count += backupAllToDirectory(specialDstDir, specialSrcDir, true);
+    size_t count = 0;
+    for (auto &job : backupJobsOf(dstDir, *rootPath)) {
+        if (backupOneToDirectory(job.mmapKey, job.dstPath, job.srcPath, job.compareFullPath)) {
+            count++;
+        }
     }
     return count;
 }
@@ -1434,22 +2505,16 @@ bool MMKV::restoreOneFromDirectory(const string &mmapKey, const MMKVPath_t &srcP
         return false;
     }
     // we have to lock the creation of MMKV instance, regardless of in cache or not
-    SCOPED_LOCK(g_instanceLock);
-    MMKV *kv = nullptr;
-    if (!compareFullPath) {
-        auto itr = g_instanceDic->find(mmapKey);
-        if (itr != g_instanceDic->end()) {
-            kv = itr->second;
-        }
-    } else {
-        // mmapKey is actually filename, we can't simply call find()
-        for (auto &pair : *g_instanceDic) {
-            if (pair.second->m_path == dstPath) {
-                kv = pair.second;
-                break;
-            }
-        }
+    unique_lock<ThreadLock> instanceLock(*g_instanceLock);
+    waitForIdleInstancePath(dstPath);
+    auto kv = findCachedInstance(mmapKey, dstPath, compareFullPath);
+#ifdef MMKV_LINUX
+    // keyed & located apart from the files, never expected here
+    if (kv && kv->isMemfd()) {
+        MMKVWarning("memfd mmkv[%s] has no file to restore to", kv->m_mmapID.c_str());
+        return false;
     }
+#endif
     // get one in cache, do it the easy way
     if (kv) {
 #ifdef MMKV_WIN32
@@ -1457,10 +2522,13 @@ bool MMKV::restoreOneFromDirectory(const string &mmapKey, const MMKVPath_t &srcP
 #else
         MMKVInfo("restore one cached mmkv[%s] from [%s] to [%s]", mmapKey.c_str(), srcPath.c_str(), dstPath.c_str());
 #endif
+        // close() & onExit() wait for it to be idle, other instances can go on meanwhile
+        BusyInstanceScope busyScope(instanceLock, dstPath);
         SCOPED_LOCK(kv->m_lock);
         SCOPED_LOCK(kv->m_exclusiveProcessLock);
 
         kv->sync();
+        kv->detachSnapshots();
         auto ret = copyFileContent(srcPath, kv->m_file->getFd());
         kv->m_file->cleanMayflyFD();
         if (ret) {
@@ -1480,8 +2548,12 @@ bool MMKV::restoreOneFromDirectory(const string &mmapKey, const MMKVPath_t &srcP
         }
 
         // reload data after restore
-        kv->clearMemoryCache();
-        kv->loadFromFile();
+#ifndef MMKV_APPLE
+        if (kv->isMultiProcess()) {
+            kv->beginTrackingChangedKeys();
+        }
+#endif
+        kv->fullReloadFromFile();
         if (kv->isMultiProcess()) {
             kv->notifyContentChanged();
         }
@@ -1491,6 +2563,7 @@ bool MMKV::restoreOneFromDirectory(const string &mmapKey, const MMKVPath_t &srcP
     }
 
     // no luck with cache, do it the hard way
+    BusyInstanceScope busyScope(instanceLock, dstPath);
     bool ret = restoreOneFromDirectoryByFilePath(mmapKey, srcPath, dstPath);
     return ret;
 }
@@ -1517,42 +2590,32 @@ bool MMKV::restoreOneFromDirectory(const string &mmapID, const MMKVPath_t &srcDi
     return restoreOneFromDirectory(mmapKey, srcPath, dstPath, false);
 }
 
-size_t MMKV::restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t &dstDir, bool isInSpecialDir) {
-    unordered_set<MMKVPath_t> mmapIDSet;
-    unordered_set<MMKVPath_t> mmapIDCRCSet;
-    walkInDir(srcDir, WalkFile, [&](const MMKVPath_t &filePath, WalkType) {
-        if (endsWith(filePath, CRC_SUFFIX)) {
-            mmapIDCRCSet.insert(filePath);
-        } else {
-            mmapIDSet.insert(filePath);
-        }
-    });
+void MMKV::listRestoreJobs(const MMKVPath_t &srcDir, const MMKVPath_t &dstDir, bool isInSpecialDir, vector<TransferJob> &jobs) {
+    auto srcPaths = listInstanceFiles(srcDir);
+    if (srcPaths.empty()) {
+        return;
+    }
+    mkPath(dstDir);
+    for (auto &srcPath : srcPaths) {
+        auto basename = filename(srcPath);
+        const auto &strBasename = MMKVPath_t2String(basename);
+        auto mmapKey = isInSpecialDir ? strBasename : mmapedKVKey(strBasename, &dstDir);
+        auto dstPath = dstDir + MMKV_PATH_SLASH;
+        dstPath += basename;
+        jobs.push_back({std::move(mmapKey), std::move(srcPath), std::move(dstPath), isInSpecialDir});
+    }
+}
 
-    size_t count = 0;
-    if (!mmapIDSet.empty()) {
-        mkPath(dstDir);
-        auto compareFullPath = isInSpecialDir;
-        for (auto &srcPath : mmapIDSet) {
-            auto srcCRCPath = srcPath + CRC_SUFFIX;
-            if (mmapIDCRCSet.find(srcCRCPath) == mmapIDCRCSet.end()) {
-#ifdef MMKV_WIN32
-                MMKVWarning("crc not exist [%ls]", srcCRCPath.c_str());
-#else
-                MMKVWarning("crc not exist [%s]", srcCRCPath.c_str());
-#endif
-                continue;
-            }
-            auto basename = filename(srcPath);
-            const auto &strBasename = MMKVPath_t2String(basename);
-            auto mmapKey = isInSpecialDir ? strBasename : mmapedKVKey(strBasename, &dstDir);
-            auto dstPath = dstDir + MMKV_PATH_SLASH;
-            dstPath += basename;
-            if (restoreOneFromDirectory(mmapKey, srcPath, dstPath, compareFullPath)) {
-                count++;
-            }
-        }
+vector<MMKV::TransferJob> MMKV::restoreJobsOf(const MMKVPath_t &srcDir, const MMKVPath_t &dstDir) {
+    vector<TransferJob> jobs;
+    listRestoreJobs(srcDir, dstDir, true, jobs);
+
+    auto specialSrcDir = srcDir + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
+    if (isFileExist(specialSrcDir)) {
+        auto specialDstDir = dstDir + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
+        listRestoreJobs(specialSrcDir, specialDstDir, false, jobs);
     }
-    return count;
+    return jobs;
 }
 
 size_t MMKV::restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t *dstDir) {
@@ -1560,16 +2623,81 @@ size_t MMKV::restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t
     if (*rootPath == srcDir) {
         return true;
     }
-    auto count = restoreAllFromDirectory(srcDir, *rootPath, true);
-
-    auto specialSrcDir = srcDir + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
-    if (isFileExist(specialSrcDir)) {
-        auto specialDstDir = *rootPath + MMKV_PATH_SLASH + SPECIAL_CHARACTER_DIRECTORY_NAME;
-        count += restoreAllFromDirectory(specialSrcDir, specialDstDir, false);
+    size_t count = 0;
+    for (auto &job : restoreJobsOf(srcDir, *rootPath)) {
+        if (restoreOneFromDirectory(job.mmapKey, job.srcPath, job.dstPath, job.compareFullPath)) {
+            count++;
+        }
     }
     return count;
 }
 
+#ifndef MMKV_APPLE
+
+// workers take the jobs one by one, each job locks the instance it works on
+template <typename Job, typename Func>
+static MMKV::TransferResult runTransferJobs(const vector<Job> &jobs, size_t concurrency, Func func) {
+    if (concurrency == 0) {
+        concurrency = max<size_t>(1, thread::hardware_concurrency());
+    }
+    concurrency = min(concurrency, jobs.size());
+
+    MMKV::TransferResult result;
+    mutex resultMutex;
+    atomic<size_t> nextJob(0);
+    auto worker = [&] {
+        for (auto index = nextJob++; index < jobs.size(); index = nextJob++) {
+            auto &job = jobs[index];
+            auto ret = func(job);
+            lock_guard<mutex> lock(resultMutex);
+            if (ret) {
+                result.succeededCount++;
+            } else {
+                result.failedPaths.push_back(job.srcPath);
+            }
+        }
+    };
+    if (concurrency <= 1) {
+        worker();
+    } else {
+        vector<thread> workers;
+        for (size_t index = 0; index < concurrency; index++) {
+            workers.emplace_back(worker);
+        }
+        for (auto &one : workers) {
+            one.join();
+        }
+    }
+    sort(result.failedPaths.begin(), result.failedPaths.end());
+    return result;
+}
+
+MMKV::TransferResult MMKV::backupAllToDirectory(const MMKVPath_t &dstDir, const MMKVPath_t *srcDir, size_t concurrency) {
+    auto rootPath = srcDir ? srcDir : &g_realRootDir;
+    if (*rootPath == dstDir) {
+        return {};
+    }
+    auto jobs = backupJobsOf(dstDir, *rootPath);
+    MMKVInfo("backup %zu mmkv on %zu threads", jobs.size(), concurrency);
+    return runTransferJobs(jobs, concurrency, [](const TransferJob &job) {
+        return backupOneToDirectory(job.mmapKey, job.dstPath, job.srcPath, job.compareFullPath);
+    });
+}
+
+MMKV::TransferResult MMKV::restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t *dstDir, size_t concurrency) {
+    auto rootPath = dstDir ? dstDir : &g_realRootDir;
+    if (*rootPath == srcDir) {
+        return {};
+    }
+    auto jobs = restoreJobsOf(srcDir, *rootPath);
+    MMKVInfo("restore %zu mmkv on %zu threads", jobs.size(), concurrency);
+    return runTransferJobs(jobs, concurrency, [](const TransferJob &job) {
+        return restoreOneFromDirectory(job.mmapKey, job.srcPath, job.dstPath, job.compareFullPath);
+    });
+}
+
+#endif // !MMKV_APPLE
+
 // callbacks
 
 void MMKV::registerErrorHandler(ErrorHandler handler) {
@@ -1715,6 +2843,10 @@ MMKVPath_t crcPathWithPath(const MMKVPath_t &kvPath) {
     return kvPath + CRC_SUFFIX;
 }
 
+MMKVPath_t compactionJournalPathWithPath(const MMKVPath_t &kvPath) {
+    return kvPath + COMPACTION_JOURNAL_SUFFIX;
+}
+
 MMKVRecoverStrategic onMMKVCRCCheckFail(const string &mmapID) {
     if (g_errorHandler) {
         return g_errorHandler(mmapID, MMKVErrorType::MMKVCRCCheckFail);
@@ -1784,6 +2916,16 @@ size_t NameSpace::restoreAllFromDirectory(const MMKVPath_t &srcDir) {
     return MMKV::restoreAllFromDirectory(srcDir, &m_rootDir);
 }
 
+#ifndef MMKV_APPLE
+MMKV::TransferResult NameSpace::backupAllToDirectory(const MMKVPath_t &dstDir, size_t concurrency) {
+    return MMKV::backupAllToDirectory(dstDir, &m_rootDir, concurrency);
+}
+
+MMKV::TransferResult NameSpace::restoreAllFromDirectory(const MMKVPath_t &srcDir, size_t concurrency) {
+    return MMKV::restoreAllFromDirectory(srcDir, &m_rootDir, concurrency);
+}
+#endif
+
 bool NameSpace::isFileValid(const std::string &mmapID) {
     return MMKV::isFileValid(mmapID, &m_rootDir);
 }
@@ -35,6 +35,8 @@
 #include "MiniPBCoder.h"
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <type_traits>
 #include <cstring>
 
@@ -47,10 +49,14 @@ class FileLock;
 class InterProcessLock;
 class ThreadLock;
 class NameSpace;
+class DecryptedValueCache;
+enum class AccessHint : uint8_t;
 } // namespace mmkv
 
 MMKV_NAMESPACE_BEGIN
 
+class MMKVSnapshot;
+
 enum MMKVMode : uint32_t {
     MMKV_SINGLE_PROCESS = 1 << 0,
     MMKV_MULTI_PROCESS = 1 << 1,
@@ -60,6 +66,22 @@ enum MMKVMode : uint32_t {
     MMKV_BACKUP = 1 << 4,
 #endif
     MMKV_READ_ONLY = 1 << 5,
+    // serve point reads from an index of the key offsets before the dictionary is built, it saves decoding the values
+    // & copying the keys, while the first read still checks the crc & scans the whole file, as a full load does
+    // only works for single-process, non-encrypted instances, ignored otherwise
+    MMKV_LAZY_LOAD = 1 << 6,
+    // map the data file with transparent huge pages to cut TLB misses of a multi-GB instance
+    // only works on Linux with file THP support (e.g. ext4/xfs with large folios), ignored otherwise
+    MMKV_HUGE_PAGE = 1 << 7,
+    // keep the data in a heap buffer written back with pwrite(), rather than mapping the files
+    // for filesystems with poor mmap writeback, writes since the last sync() (at most 1MB of them) are lost on a crash
+    // only works for single-process instances, ignored otherwise
+    MMKV_BUFFERED_IO = 1 << 8,
+#ifdef MMKV_LINUX
+    // keep the data in an anonymous memfd instead of a file, shared with other processes by passing its fds
+    // the content is gone once every process has closed it, always multi-process
+    MMKV_MEMFD = 1 << 9,
+#endif
 };
 
 static inline MMKVMode operator | (MMKVMode one, MMKVMode other) {
@@ -97,6 +119,9 @@ concept MMKV_SUPPORTED_VALUE_TYPE = MMKV_SUPPORTED_PRIMITIVE_VALUE_TYPE<T> || MM
 class MMKV_EXPORT MMKV {
 #ifndef MMKV_ANDROID
     MMKV(const std::string &mmapID, MMKVMode mode, const std::string *cryptKey, const MMKVPath_t *rootPath, size_t expectedCapacity = 0);
+#ifdef MMKV_LINUX
+    MMKV(const std::string &mmapID, int memfd, int memfdMeta, const std::string *cryptKey);
+#endif
 #else // defined(MMKV_ANDROID)
 #ifndef MMKV_OHOS
     mmkv::FileLock *m_fileModeLock;
@@ -146,6 +171,29 @@ class MMKV_EXPORT MMKV {
 
     bool m_enableCompareBeforeSet = false;
 
+    // the last record of every key, built by the first point read before the dictionary, see MMKV_LAZY_LOAD
+    // in an append-only log the last record is only known at the end, so it's always a scan of the whole file
+    // the keys point into the mmap, loadFromFile() turns it into the dictionary without decoding the file again
+    using LazyIndex = std::unordered_map<std::string_view, mmkv::KeyValueHolder>;
+    LazyIndex *m_lazyIndex = nullptr;
+    bool m_lazyLookupFailed = false;
+
+    // see enableAccessHints()
+    bool m_enableAccessHints = true;
+
+#ifndef MMKV_APPLE
+    // snapshots still reading the log prefix in place, see snapshot()
+    std::vector<std::weak_ptr<MMKVSnapshot>> m_snapshots;
+
+    // min-heap of <expire date, key> for keys that will expire, built on first use
+    // entries are never updated in place, they are checked against the dictionary when popped
+    std::vector<std::pair<uint32_t, std::string>> m_expireIndex;
+    bool m_expireIndexValid = false;
+
+    // LRU cache of decrypted values, see enableDecryptedValueCache()
+    mmkv::DecryptedValueCache *m_valueCache = nullptr;
+#endif
+
 #ifdef MMKV_APPLE
 #ifdef __OBJC__
     using MMKVKey_t = NSString *__unsafe_unretained;
@@ -168,6 +216,14 @@ class MMKV_EXPORT MMKV {
     void loadFromFile();
 
     void partialLoadFromFile();
+
+    // whether the offsets moved by a compaction are published to other processes, see compactionJournalPathWithPath()
+    bool hasCompactionJournal() const;
+    // relocations: pairs of (old offset, new offset) sorted by the old offset, must be called after writeActualSize()
+    void writeCompactionJournal(const std::vector<std::pair<uint32_t, uint32_t>> &relocations,
+                                uint32_t lastSequence, size_t lastActualSize, uint32_t lastCRCDigest);
+    // catch up with a compaction by another process without decoding the file again, return false if not applicable
+    bool relocateByCompactionJournal(const mmkv::MMKVMetaInfo &metaInfo);
     
 //#if defined(MMKV_APPLE) || defined(MMKV_WIN32)
 // the disk corruption detection is tested in iOS/Win32, but not Android
@@ -188,16 +244,32 @@ class MMKV_EXPORT MMKV {
 
     bool checkFileCRCValid(size_t actualSize, uint32_t crcDigest);
 
-    void recalculateCRCDigestWithIV(const void *iv);
-    void recalculateCRCDigestOnly();
+    // crypter: what the data is encrypted with, nullptr for plain text
+    // unchangedSize: the size of the leading items that stay where they were, 0 if unknown
+    void recalculateCRCDigestWithIV(const void *iv, mmkv::AESCrypt *crypter = nullptr, size_t unchangedSize = 0,
+                                    bool logSequence = true);
 
     void updateCRCDigest(const uint8_t *ptr, size_t length);
 
+    // the crc of each segment is kept in the meta file, see MMKVVersionSegmentCRC
+    bool canKeepSegmentCRC() const;
+    // whether the segment crc table matches the meta info
+    bool isSegmentCRCValid() const;
+    // update or rebuild the segment crc table for [0, m_actualSize), return the crc digest of the whole data
+    uint32_t recalculateSegmentCRC(mmkv::AESCrypt *crypter, size_t unchangedSize);
+    // mark the segment crc table up to date, must be called after writeActualSize()
+    void confirmSegmentCRC();
+    // the segment crc table is missing or out of date, rebuild it from the loaded data
+    void checkSegmentCRC();
+    // decode the items in undamaged segments of a corrupted file, return false if the segment crc table is not usable
+    bool salvageBySegmentCRC();
+
     size_t readActualSize();
 
     void oldStyleWriteActualSize(size_t actualSize);
 
-    bool writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool increaseSequence);
+    // logSequence: an Info log on increasing the sequence, a Debug one otherwise
+    bool writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool increaseSequence, bool logSequence = true);
 
     bool ensureMemorySize(size_t newSize);
 
@@ -213,6 +285,27 @@ class MMKV_EXPORT MMKV {
 
     mmkv::MMBuffer getDataForKey(MMKVKey_t key);
 
+    // the fast path of primitive getters: locate the value in the mmap memory directly, no copying, no decrypting
+    // ptr is nullptr if not found, return false if not applicable (encrypted/expiring/lazy-loading)
+    bool getRawValuePtrForKey(MMKVKey_t key, const uint8_t *&ptr, size_t &size);
+    // decode on the fast path, value is left untouched if not found, return false if not applicable
+    template <typename T, bool (*decode)(const void *, size_t, T &)>
+    bool getPrimitiveInPlace(MMKVKey_t key, T &value, bool *hasValue);
+
+    // look up the key in m_lazyIndex without building the dictionary, return false if not applicable
+    bool lazyGetDataForKey(MMKVKey_t key, mmkv::MMBuffer &result);
+    bool buildLazyIndex();
+
+    // copy the log prefix out for every live snapshot, must be called before rewriting it or unmapping it
+    void detachSnapshots();
+
+#ifndef MMKV_APPLE
+    // look up keys with one lock acquisition & one staleness check, pass every value found to decoder
+    // return the count of values the decoder accepts
+    using DataDecoder = std::function<bool(size_t index, const mmkv::MMBuffer &data)>;
+    size_t getManyData(const std::vector<std::string> &keys, const DataDecoder &decoder);
+#endif
+
     // isDataHolder: avoid memory copying
     bool setDataForKey(mmkv::MMBuffer &&data, MMKVKey_t key, bool isDataHolder = false);
 
@@ -247,19 +340,74 @@ class MMKV_EXPORT MMKV {
 
     void notifyContentChanged();
 
+    // what clearMemoryCache() does except advising the pages cold, they are read back soon after a reload
+    void doClearMemoryCache(bool keepSpace = false);
+
+    // doClearMemoryCache() & loadFromFile(), with the keys changed tracked if needed
+    void fullReloadFromFile(bool keepSpace = false);
+
+#ifndef MMKV_APPLE
+    // key -> (exists before catching up with other processes, exists after), only while anyone is listening
+    using ChangedKeys = std::unordered_map<std::string, std::pair<bool, bool>>;
+    ChangedKeys *m_changedKeys = nullptr;
+
+    void beginTrackingChangedKeys();
+    void trackChangedKey(const std::string &key, bool existedBefore, bool existsAfter);
+    std::vector<std::string> loadedKeys() const;
+    void trackReloadedKeys(const std::vector<std::string> &oldKeys);
+#endif
+
 #if defined(MMKV_ANDROID) && !defined(MMKV_DISABLE_CRYPT)
     void checkReSetCryptKey(int fd, int metaFD, const std::string *cryptKey);
 #endif
+    static MMKV *findCachedInstance(const std::string &mmapKey, const MMKVPath_t &path, bool compareFullPath);
     static bool backupOneToDirectory(const std::string &mmapKey, const MMKVPath_t &dstPath, const MMKVPath_t &srcPath, bool compareFullPath);
-    static size_t backupAllToDirectory(const MMKVPath_t &dstDir, const MMKVPath_t &srcDir, bool isInSpecialDir);
     static bool restoreOneFromDirectory(const std::string &mmapKey, const MMKVPath_t &srcPath, const MMKVPath_t &dstPath, bool compareFullPath);
-    static size_t restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t &dstDir, bool isInSpecialDir);
+
+    // one instance found in the directory to backup or restore
+    struct TransferJob {
+        std::string mmapKey;
+        MMKVPath_t srcPath;
+        MMKVPath_t dstPath;
+        bool compareFullPath;
+    };
+    static void listBackupJobs(const MMKVPath_t &dstDir, const MMKVPath_t &srcDir, bool isInSpecialDir, std::vector<TransferJob> &jobs);
+    static void listRestoreJobs(const MMKVPath_t &srcDir, const MMKVPath_t &dstDir, bool isInSpecialDir, std::vector<TransferJob> &jobs);
+    static std::vector<TransferJob> backupJobsOf(const MMKVPath_t &dstDir, const MMKVPath_t &srcDir);
+    static std::vector<TransferJob> restoreJobsOf(const MMKVPath_t &srcDir, const MMKVPath_t &dstDir);
 
     static uint32_t getCurrentTimeInSecond();
     uint32_t getExpireTimeForKey(MMKVKey_t key);
     mmkv::MMBuffer getDataWithoutMTimeForKey(MMKVKey_t key);
     size_t filterExpiredKeys();
 
+    // drop the expire index, it will be rebuilt from the dictionary on next use
+    void clearExpireIndex();
+
+    // whether values are decrypted on demand rather than kept decrypted in memory, see enableDecryptedValueCache()
+    bool isLazyDecrypt() const;
+    void eraseDecryptedValue(MMKVKey_t key);
+    void clearDecryptedValueCache();
+
+    // hint the kernel how the first (Fixed32Size + dataSize) bytes of the data file are going to be accessed
+    void adviseDataAccess(mmkv::AccessHint hint, size_t dataSize);
+#ifndef MMKV_DISABLE_CRYPT
+    // decrypt the value of kvHolder, served from the decrypted value cache if possible
+    mmkv::MMBuffer decryptValue(MMKVKey_t key, const mmkv::KeyValueHolderCrypt &kvHolder, const uint8_t *basePtr);
+#endif
+#ifndef MMKV_APPLE
+    void buildExpireIndex();
+    void indexExpireTime(MMKVKey_t key, const mmkv::MMBuffer &data);
+    // read the expire date of the key in the dictionary, return false if not found
+    bool getExpireTimeInDictionary(std::string_view key, uint32_t &time);
+    // pop the next key that is due and still in the dictionary
+    bool popExpiredKey(uint32_t now, std::string &key, uint32_t &time);
+    size_t importRecordsFrom(MMKV *src);
+
+    struct BatchItem;
+    size_t appendBatch(std::vector<BatchItem> &items, size_t totalSize);
+#endif
+
     static constexpr uint32_t ConstFixed32Size = 4;
     void shared_lock();
     void shared_unlock();
@@ -282,6 +430,17 @@ public:
                             const MMKVPath_t *rootPath = nullptr,
                             size_t expectedCapacity = 0);
 
+#ifdef MMKV_LINUX
+    // the counterpart of mmkvWithID(MMKV_MEMFD) in another process, with the fds passed through fork() or SCM_RIGHTS
+    // the fds are left to the caller, the instance works on its own copies
+    static MMKV *mmkvWithMemfdFD(const std::string &mmapID, int fd, int metaFD, const std::string *cryptKey = nullptr);
+
+    // -1 if it's not a memfd instance, the fds are close-on-exec
+    int memfdFD();
+
+    int memfdMetaFD();
+#endif
+
 #else // defined(MMKV_ANDROID)
 
     // mmapID: any unique ID (com.tencent.xin.pay, etc.)
@@ -315,7 +474,16 @@ public:
     static void onExit();
 
     const std::string &mmapID() const;
-#ifndef MMKV_ANDROID
+#if defined(MMKV_LINUX)
+    bool isMultiProcess() const {
+        return (m_mode & MMKV_MULTI_PROCESS) != 0
+            || (m_mode & MMKV_MEMFD) != 0; // memfd is always multi-process
+    }
+
+    bool isMemfd() const {
+        return (m_mode & MMKV_MEMFD) != 0;
+    }
+#elif !defined(MMKV_ANDROID)
     bool isMultiProcess() const { return  (m_mode & MMKV_MULTI_PROCESS) != 0; }
 #else
     bool isMultiProcess() const {
@@ -330,13 +498,24 @@ public:
 #endif
     bool isReadOnly() const { return (m_mode & MMKV_READ_ONLY) != 0; }
 
+    bool isLazyLoad() const { return (m_mode & MMKV_LAZY_LOAD) != 0; }
+
 #ifndef MMKV_DISABLE_CRYPT
     std::string cryptKey() const;
 
     // transform plain text into encrypted text, or vice versa with empty cryptKey
     // you can change existing crypt key with different cryptKey
+    // the crypt mode stays the same, a plain text file turns into MMKVCryptCFB
     bool reKey(const std::string &cryptKey);
 
+    // same as above, and transform into the crypt mode at the same time
+    // e.g. reKey(cryptKey(), mmkv::MMKVCryptCTR) migrates an existing CFB file to CTR with the same key
+    // note: older versions of MMKV can't read a MMKVCryptCTR file
+    bool reKey(const std::string &cryptKey, mmkv::MMKVCryptMode mode);
+
+    // MMKVCryptCFB for plain text files
+    mmkv::MMKVCryptMode cryptMode();
+
     // just reset cryptKey (will not encrypt or decrypt anything)
     // usually you should call this method after other process reKey() the multi-process mmkv
     void checkReSetCryptKey(const std::string *cryptKey);
@@ -557,6 +736,69 @@ public:
     // filterExpire: return all non-expired keys, keep in mind it comes with cost
     std::vector<std::string> allKeys(bool filterExpire = false);
 
+    // the value is the raw encoded data like getDataForKey(), only valid inside the callback
+    // return false to stop the iteration
+    using ForEachCallback = std::function<bool(const std::string &key, const mmkv::MMBuffer &value)>;
+
+    // walk through all key-values under one lock, without copying keys or (non-encrypted) values
+    // don't modify this instance inside the callback
+    // filterExpire: skip expired keys (without deleting them)
+    void forEach(const ForEachCallback &callback, bool filterExpire = false);
+
+    // a read-only view frozen at the current actual size & sequence, see MMKVSnapshot.h
+    // it reads the log prefix in place until this instance is about to rewrite it, appends are not blocked
+    std::shared_ptr<MMKVSnapshot> snapshot();
+
+    struct DecryptedValueCacheStats {
+        uint64_t hitCount = 0;
+        uint64_t missCount = 0;
+        size_t itemCount = 0;
+        size_t totalSize = 0;
+        size_t sizeLimit = 0;
+
+        double hitRatio() const {
+            auto total = hitCount + missCount;
+            return total ? static_cast<double>(hitCount) / static_cast<double>(total) : 0;
+        }
+    };
+
+    // for encrypted instances: keep only the tiniest values decrypted in memory, decrypt the others on demand,
+    // and keep the recently read ones in an LRU cache, bounded by sizeLimit bytes (keys & values & bookkeeping)
+    // calling it again just changes the budget, sizeLimit = 0 turns it off and restores the default behavior
+    // it drops the memory cache, so the instance is reloaded on next access
+    void enableDecryptedValueCache(size_t sizeLimit);
+
+    // the counters are reset when the cache is turned off
+    DecryptedValueCacheStats decryptedValueCacheStats();
+
+    // remove at most maxCount expired keys, return the count removed
+    // it's cheap when nothing is expired, call it periodically or use startExpireSweeper()
+    size_t sweepExpiredKeys(size_t maxCount = 64);
+
+    // a background thread calling sweepExpiredKeys(batchSize) on all loaded instances every intervalInSeconds
+    static void startExpireSweeper(uint32_t intervalInSeconds = 60, size_t batchSize = 64);
+    static void stopExpireSweeper();
+
+    // multi-get: fetch many keys with one lock acquisition and one staleness check
+    // results[i] is the value of keys[i], or defaultValue if it's not found (expired keys are not found)
+    // return the count of keys found
+    size_t getMany(const std::vector<std::string> &keys, std::vector<bool> &results, bool defaultValue = false);
+    size_t getMany(const std::vector<std::string> &keys, std::vector<int32_t> &results, int32_t defaultValue = 0);
+    size_t getMany(const std::vector<std::string> &keys, std::vector<uint32_t> &results, uint32_t defaultValue = 0);
+    size_t getMany(const std::vector<std::string> &keys, std::vector<int64_t> &results, int64_t defaultValue = 0);
+    size_t getMany(const std::vector<std::string> &keys, std::vector<uint64_t> &results, uint64_t defaultValue = 0);
+    size_t getMany(const std::vector<std::string> &keys, std::vector<float> &results, float defaultValue = 0);
+    size_t getMany(const std::vector<std::string> &keys, std::vector<double> &results, double defaultValue = 0);
+    // a found key with an empty value is still found, only missing keys get defaultValue
+    size_t getMany(const std::vector<std::string> &keys, std::vector<std::string> &results,
+                   const std::string &defaultValue = std::string());
+    // results[i] is empty if keys[i] is not found
+    size_t getMany(const std::vector<std::string> &keys, std::vector<mmkv::MMBuffer> &results);
+
+    // scatter version of writeValueToBuffer(): write the value of keys[i] into buffers[i] with capacity sizes[i]
+    // sizes[i] becomes the size written, or -1 if it's not found or the buffer is too small
+    size_t writeValuesToBuffers(const std::vector<std::string> &keys, void *const *buffers, int32_t *sizes);
+
     bool removeValuesForKeys(const std::vector<std::string> &arrKeys);
 #endif // MMKV_APPLE
 
@@ -574,6 +816,36 @@ public:
     // return count of items imported
     size_t importFrom(MMKV *src);
 
+#ifndef MMKV_APPLE
+    // take the next chunk of the stream, return false to abort
+    using StreamWriter = std::function<bool(const void *ptr, size_t size)>;
+    // read at most size bytes into buffer, return the count read, 0 on the end of stream or error
+    using StreamReader = std::function<size_t(void *buffer, size_t size)>;
+
+    // write all non-expired key-values (decrypted) as a versioned, length-prefixed & checksummed record stream
+    // it's written in chunks under the lock of this instance, a slow writer blocks other threads
+    bool dumpTo(const StreamWriter &writer);
+
+    // set the key-values of a stream written by dumpTo(), they are appended in batches with bounded memory
+    // items before a broken or truncated record are kept, and false is returned
+    bool loadFrom(const StreamReader &reader, size_t *loadedCount = nullptr);
+
+    // a position in the append log, which is only appended within a sequence
+    struct ChangeCursor {
+        uint32_t sequence = 0;
+        uint32_t offset = 0;
+    };
+    // take one set record (or a removal, with an empty value) in the order they were written, return false to stop
+    using ChangeVisitor = std::function<bool(const std::string &key, const mmkv::MMBuffer &value)>;
+
+    // visit the records appended after cursor, and move it past the visited ones
+    // a default cursor visits the whole current log, replaying it rebuilds the full content
+    // return false if the log has been rewritten (compacted, overridden, cleared...) since cursor, resync needed:
+    // cursor is reset to the beginning of the current log, drop what has been replicated & call again
+    // encrypted instances decrypt from cursor to the end on every call; a slow visitor blocks other threads
+    bool changesSince(ChangeCursor &cursor, const ChangeVisitor &visitor);
+#endif
+
     // call this method if the instance is no longer needed in the near future
     // any subsequent call to the instance is undefined behavior
     void close();
@@ -583,6 +855,18 @@ public:
     // keepSpace: remove all keys but keep the file size not changed, running faster
     void clearMemoryCache(bool keepSpace = false);
 
+    // hint the kernel how the data file is accessed: read ahead as a whole before a full load, sequentially during a
+    // full writeback, randomly in between; it's on by default
+    void enableAccessHints(bool enable);
+
+    // call this method if you are facing memory-warning but the instance is still in use
+    // the pages of the data file are the first to be reclaimed by the kernel (or right now if pageOut),
+    // unlike clearMemoryCache(), key-values are kept in memory & the pages are read back on demand
+    void reclaimPageCache(bool pageOut = false);
+
+    // reclaimPageCache() of all loaded instances
+    static void reclaimAllPageCache(bool pageOut = false);
+
     // you don't need to call this, really, I mean it
     // unless you worry about running out of battery
     void sync(SyncFlag flag = MMKV_SYNC);
@@ -619,6 +903,19 @@ public:
     // return count of MMKV successfully restored
     static size_t restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t *dstDir = nullptr);
 
+#ifndef MMKV_APPLE
+    struct TransferResult {
+        size_t succeededCount = 0;
+        // the source files of the instances that failed, see the log for details
+        std::vector<MMKVPath_t> failedPaths;
+    };
+
+    // the same as above, but backup/restore instances on [concurrency] threads
+    // concurrency = 0 means the number of CPU cores, it returns after all of them are done
+    static TransferResult backupAllToDirectory(const MMKVPath_t &dstDir, const MMKVPath_t *srcDir, size_t concurrency);
+    static TransferResult restoreAllFromDirectory(const MMKVPath_t &srcDir, const MMKVPath_t *dstDir, size_t concurrency);
+#endif
+
     // check if content been changed by other process
     void checkContentChanged();
 
@@ -627,6 +924,12 @@ public:
     static void registerContentChangeHandler(mmkv::ContentChangeHandler handler);
     static void unRegisterContentChangeHandler();
 
+#ifndef MMKV_APPLE
+    // the same as above, with the keys added, updated or removed, so that listeners can invalidate precisely
+    static void registerContentKeysChangeHandler(mmkv::ContentKeysChangeHandler handler);
+    static void unRegisterContentKeysChangeHandler();
+#endif
+
     // by default MMKV will discard all datas on failure
     // return `OnErrorRecover` to recover any data from file
     static void registerErrorHandler(mmkv::ErrorHandler handler);
@@ -754,6 +1057,12 @@ public:
     // return count of MMKV successfully restored
     size_t restoreAllFromDirectory(const MMKVPath_t &srcDir);
 
+#ifndef MMKV_APPLE
+    // backup/restore instances on [concurrency] threads
+    MMKV::TransferResult backupAllToDirectory(const MMKVPath_t &dstDir, size_t concurrency);
+    MMKV::TransferResult restoreAllFromDirectory(const MMKVPath_t &srcDir, size_t concurrency);
+#endif
+
     // detect if the MMKV file is valid or not
     // Note: Don't use this to check the existence of the instance, the return value is undefined if the file was never created.
     bool isFileValid(const std::string &mmapID);
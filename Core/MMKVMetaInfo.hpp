@@ -43,8 +43,11 @@ enum MMKVVersion : uint32_t {
     // store extra flags
     MMKVVersionFlag = 4,
 
+    // store crc of each segment after the meta info, see SegmentCRCTable
+    MMKVVersionSegmentCRC = 5,
+
     // preserved for next use
-    MMKVVersionNext = 5,
+    MMKVVersionNext = 6,
 
     // always large than next, a placeholder for error check
     MMKVVersionHolder = MMKVVersionNext + 1,
@@ -68,8 +71,14 @@ struct MMKVMetaInfo {
 
     enum MMKVMetaInfoFlag : uint64_t {
         EnableKeyExipre = 1 << 0,
+        // encrypted in AES CTR-128 instead of CFB-128
+        EnableCryptCTR = 1 << 1,
     };
     bool hasFlag(MMKVMetaInfoFlag flag) { return (m_flags & flag) != 0; }
+
+    MMKVCryptMode cryptMode() const {
+        return (m_version >= MMKVVersionFlag && (m_flags & EnableCryptCTR)) ? MMKVCryptCTR : MMKVCryptCFB;
+    }
     void setFlag(MMKVMetaInfoFlag flag) { m_flags |= flag; }
     void unsetFlag(MMKVMetaInfoFlag flag) { m_flags &= ~flag; }
 
@@ -85,6 +94,18 @@ struct MMKVMetaInfo {
         other->m_actualSize = m_actualSize;
     }
 
+    // everything a rewrite from the beginning changes, when the version & flags stay the same
+    void writeCRCAndSequenceOnly(void *ptr) const {
+        MMKV_ASSERT(ptr);
+        auto other = (MMKVMetaInfo *) ptr;
+        other->m_crcDigest = m_crcDigest;
+        other->m_sequence = m_sequence;
+        memcpy(other->m_vector, m_vector, sizeof(m_vector));
+        other->m_actualSize = m_actualSize;
+        other->m_lastConfirmedMetaInfo.lastActualSize = m_lastConfirmedMetaInfo.lastActualSize;
+        other->m_lastConfirmedMetaInfo.lastCRCDigest = m_lastConfirmedMetaInfo.lastCRCDigest;
+    }
+
     void read(const void *ptr) {
         MMKV_ASSERT(ptr);
         memcpy(this, ptr, sizeof(MMKVMetaInfo));
@@ -181,6 +181,19 @@ typedef MMKVRecoverStrategic (*ErrorHandler)(const std::string &mmapID, MMKVErro
 // doesn't guarantee real-time notification
 typedef void (*ContentChangeHandler)(const std::string &mmapID);
 
+#ifndef MMKV_APPLE
+// the keys changed by other processes since the last notification
+// when the instance has to be reloaded as a whole (e.g. encrypted, rewritten), every key that survives counts as updated
+struct ContentChangedKeys {
+    std::vector<std::string> addedKeys;
+    std::vector<std::string> updatedKeys;
+    std::vector<std::string> removedKeys;
+};
+
+// called along with ContentChangeHandler
+typedef void (*ContentKeysChangeHandler)(const std::string &mmapID, const ContentChangedKeys &changes);
+#endif
+
 
 extern MMKV_EXPORT size_t DEFAULT_MMAP_SIZE;
 #define DEFAULT_MMAP_ID "mmkv.default"
@@ -272,6 +285,14 @@ void unused(const T &) {}
 constexpr size_t AES_KEY_LEN = 16;
 constexpr size_t AES_KEY_BITSET_LEN = 128;
 
+// the cipher mode of an encrypted file
+enum MMKVCryptMode : uint32_t {
+    // AES CFB-128, every byte is chained to the previous cipher text, decrypted sequentially only
+    MMKVCryptCFB = 0,
+    // AES CTR-128 with the file IV as the initial counter, any record can be decrypted from its offset alone
+    MMKVCryptCTR = 1,
+};
+
 } // namespace mmkv
 
 #ifdef MMKV_DEBUG
@@ -0,0 +1,274 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MMKVSnapshot.h"
+
+#ifndef MMKV_APPLE
+
+#    include "CodedInputData.h"
+#    include "KeyValueHolder.h"
+#    include "MMKVLog.h"
+#    include "MiniPBCoder.h"
+#    include "PBUtility.h"
+#    include "ScopedLock.hpp"
+#    include "ThreadLock.h"
+#    include "aes/AESCrypt.h"
+#    include <cstring>
+
+using namespace std;
+using namespace mmkv;
+
+MMKV_NAMESPACE_BEGIN
+
+MMKVSnapshot::MMKVSnapshot(const string &mmapID, const uint8_t *basePtr, size_t actualSize, uint32_t sequence,
+                           AESCrypt *crypter, bool enableKeyExpire, uint32_t timeInSecond)
+    : m_mmapID(mmapID)
+    , m_actualSize(basePtr ? actualSize : 0)
+    , m_sequence(sequence)
+    , m_enableKeyExpire(enableKeyExpire)
+    , m_timeInSecond(timeInSecond)
+    , m_basePtr(basePtr)
+    , m_crypter(crypter)
+    , m_lock(new ThreadLock()) {
+    m_lock->initialize();
+}
+
+MMKVSnapshot::~MMKVSnapshot() {
+    delete m_dic;
+#    ifndef MMKV_DISABLE_CRYPT
+    delete m_crypter;
+#    endif
+    delete m_lock;
+}
+
+void MMKVSnapshot::detach() {
+    SCOPED_LOCK(m_lock);
+    if (m_detached) {
+        return;
+    }
+    if (m_actualSize > 0) {
+        m_ownedData = MMBuffer((void *) m_basePtr, m_actualSize);
+        m_basePtr = (const uint8_t *) m_ownedData.getPtr();
+    }
+    m_detached = true;
+    MMKVInfo("snapshot of [%s] detached with %zu actual size", m_mmapID.c_str(), m_actualSize);
+}
+
+bool MMKVSnapshot::isDetached() {
+    SCOPED_LOCK(m_lock);
+    return m_detached;
+}
+
+void MMKVSnapshot::loadIndexIfNeeded() {
+    if (mmkv_likely(m_dic)) {
+        return;
+    }
+    m_dic = new MMKVMap();
+    if (m_actualSize == 0) {
+        return;
+    }
+#    ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        // it's a stream cipher, decrypt the whole prefix once and serve everything else in plain text
+        MMBuffer plainData(m_actualSize);
+        m_crypter->decrypt(m_basePtr, plainData.getPtr(), m_actualSize);
+        m_ownedData = std::move(plainData);
+        m_basePtr = (const uint8_t *) m_ownedData.getPtr();
+        m_detached = true;
+        delete m_crypter;
+        m_crypter = nullptr;
+    }
+#    endif
+    MMBuffer inputBuffer((void *) m_basePtr, m_actualSize, MMBufferNoCopy);
+    MiniPBCoder::decodeMap(*m_dic, inputBuffer);
+}
+
+bool MMKVSnapshot::getRawValue(const KeyValueHolder &kvHolder, const uint8_t *&ptr, size_t &size) const {
+    ptr = m_basePtr + kvHolder.offset + kvHolder.computedKVSize;
+    size = kvHolder.valueSize;
+    if (mmkv_unlikely(m_enableKeyExpire)) {
+        if (size < Fixed32Size) {
+            return false;
+        }
+        size -= Fixed32Size;
+        uint32_t time = 0;
+        memcpy(&time, ptr + size, Fixed32Size);
+        if (time != MMKV::ExpireNever && time <= m_timeInSecond) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MMKVSnapshot::getRawValueForKey(string_view key, const uint8_t *&ptr, size_t &size) {
+    loadIndexIfNeeded();
+    auto itr = m_dic->find(key);
+    if (itr == m_dic->end()) {
+        return false;
+    }
+    return getRawValue(itr->second, ptr, size);
+}
+
+template <typename T>
+T MMKVSnapshot::getPrimitive(string_view key, T defaultValue, bool *hasValue,
+                             bool (*decoder)(const void *, size_t, T &)) {
+    SCOPED_LOCK(m_lock);
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    T value = defaultValue;
+    bool found = getRawValueForKey(key, ptr, size) && decoder(ptr, size, value);
+    if (hasValue != nullptr) {
+        *hasValue = found;
+    }
+    return found ? value : defaultValue;
+}
+
+bool MMKVSnapshot::getBool(string_view key, bool defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeBool);
+}
+
+int32_t MMKVSnapshot::getInt32(string_view key, int32_t defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeInt32);
+}
+
+uint32_t MMKVSnapshot::getUInt32(string_view key, uint32_t defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeUInt32);
+}
+
+int64_t MMKVSnapshot::getInt64(string_view key, int64_t defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeInt64);
+}
+
+uint64_t MMKVSnapshot::getUInt64(string_view key, uint64_t defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeUInt64);
+}
+
+float MMKVSnapshot::getFloat(string_view key, float defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeFloat);
+}
+
+double MMKVSnapshot::getDouble(string_view key, double defaultValue, bool *hasValue) {
+    return getPrimitive(key, defaultValue, hasValue, CodedInputData::decodeDouble);
+}
+
+bool MMKVSnapshot::getString(string_view key, string &result) {
+    SCOPED_LOCK(m_lock);
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    if (getRawValueForKey(key, ptr, size) && size > 0) {
+        try {
+            CodedInputData input(ptr, size);
+            result = input.readString();
+            return true;
+        } catch (std::exception &exception) {
+            MMKVError("%s", exception.what());
+        } catch (...) {
+            MMKVError("decode fail");
+        }
+    }
+    return false;
+}
+
+bool MMKVSnapshot::getBytes(string_view key, MMBuffer &result) {
+    SCOPED_LOCK(m_lock);
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    if (getRawValueForKey(key, ptr, size) && size > 0) {
+        try {
+            CodedInputData input(ptr, size);
+            result = input.readData();
+            return true;
+        } catch (std::exception &exception) {
+            MMKVError("%s", exception.what());
+        } catch (...) {
+            MMKVError("decode fail");
+        }
+    }
+    return false;
+}
+
+bool MMKVSnapshot::containsKey(string_view key) {
+    SCOPED_LOCK(m_lock);
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    return getRawValueForKey(key, ptr, size);
+}
+
+size_t MMKVSnapshot::count() {
+    SCOPED_LOCK(m_lock);
+    loadIndexIfNeeded();
+    if (mmkv_likely(!m_enableKeyExpire)) {
+        return m_dic->size();
+    }
+    size_t count = 0;
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    for (const auto &itr : *m_dic) {
+        if (getRawValue(itr.second, ptr, size)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+vector<string> MMKVSnapshot::allKeys() {
+    SCOPED_LOCK(m_lock);
+    loadIndexIfNeeded();
+    vector<string> keys;
+    keys.reserve(m_dic->size());
+    const uint8_t *ptr = nullptr;
+    size_t size = 0;
+    for (const auto &itr : *m_dic) {
+        if (getRawValue(itr.second, ptr, size)) {
+            keys.push_back(itr.first);
+        }
+    }
+    return keys;
+}
+
+void MMKVSnapshot::forEach(const MMKV::ForEachCallback &callback) {
+    if (!callback) {
+        return;
+    }
+    {
+        SCOPED_LOCK(m_lock);
+        loadIndexIfNeeded();
+    }
+    // the index never changes once built, only the memory it points to might be detached
+    for (const auto &itr : *m_dic) {
+        MMBuffer value;
+        {
+            SCOPED_LOCK(m_lock);
+            const uint8_t *ptr = nullptr;
+            size_t size = 0;
+            if (!getRawValue(itr.second, ptr, size)) {
+                continue;
+            }
+            value = MMBuffer((void *) ptr, size);
+        }
+        if (!callback(itr.first, value)) {
+            break;
+        }
+    }
+}
+
+MMKV_NAMESPACE_END
+
+#endif // !MMKV_APPLE
@@ -0,0 +1,110 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MMKV_MMKVSNAPSHOT_H
+#define MMKV_MMKVSNAPSHOT_H
+#ifdef __cplusplus
+
+#include "MMKV.h"
+
+#ifndef MMKV_APPLE
+
+MMKV_NAMESPACE_BEGIN
+
+// A read-only view of an MMKV instance, frozen at the actual size & sequence of the moment it's taken.
+// The log prefix is read in place from the instance's mmap; right before the instance is about to rewrite it
+// (full writeback, trim, clearAll, clearMemoryCache, close...), the prefix is copied to the heap.
+// Writers are never blocked by a scan over a snapshot, except for that copy.
+// It's thread-safe, and it stays valid after the instance is closed.
+class MMKVSnapshot {
+    std::string m_mmapID;
+    size_t m_actualSize;
+    uint32_t m_sequence;
+    bool m_enableKeyExpire;
+    uint32_t m_timeInSecond;
+
+    // points to the instance's mmap before detached, or m_ownedData after
+    const uint8_t *m_basePtr;
+    mmkv::MMBuffer m_ownedData;
+    bool m_detached = false;
+
+    // the index is built on first use, from the pinned log prefix
+    mmkv::MMKVMap *m_dic = nullptr;
+    mmkv::AESCrypt *m_crypter;
+    mmkv::ThreadLock *m_lock;
+
+    MMKVSnapshot(const std::string &mmapID, const uint8_t *basePtr, size_t actualSize, uint32_t sequence,
+                 mmkv::AESCrypt *crypter, bool enableKeyExpire, uint32_t timeInSecond);
+
+    // copy the log prefix out of the instance's mmap, called by the instance with its lock held
+    void detach();
+
+    void loadIndexIfNeeded();
+
+    // return the raw value (without the expire time) of the key, only valid with m_lock held
+    bool getRawValue(const mmkv::KeyValueHolder &kvHolder, const uint8_t *&ptr, size_t &size) const;
+    bool getRawValueForKey(std::string_view key, const uint8_t *&ptr, size_t &size);
+
+    template <typename T>
+    T getPrimitive(std::string_view key, T defaultValue, bool *hasValue, bool (*decoder)(const void *, size_t, T &));
+
+    friend class MMKV;
+
+public:
+    ~MMKVSnapshot();
+
+    const std::string &mmapID() const { return m_mmapID; }
+
+    // the actual size & sequence of the instance when this snapshot is taken
+    size_t actualSize() const { return m_actualSize; }
+    uint32_t sequence() const { return m_sequence; }
+
+    // whether the log prefix has been copied out of the instance's mmap
+    bool isDetached();
+
+    bool getBool(std::string_view key, bool defaultValue = false, bool *hasValue = nullptr);
+    int32_t getInt32(std::string_view key, int32_t defaultValue = 0, bool *hasValue = nullptr);
+    uint32_t getUInt32(std::string_view key, uint32_t defaultValue = 0, bool *hasValue = nullptr);
+    int64_t getInt64(std::string_view key, int64_t defaultValue = 0, bool *hasValue = nullptr);
+    uint64_t getUInt64(std::string_view key, uint64_t defaultValue = 0, bool *hasValue = nullptr);
+    float getFloat(std::string_view key, float defaultValue = 0, bool *hasValue = nullptr);
+    double getDouble(std::string_view key, double defaultValue = 0, bool *hasValue = nullptr);
+    bool getString(std::string_view key, std::string &result);
+    bool getBytes(std::string_view key, mmkv::MMBuffer &result);
+
+    // keys expired at the moment this snapshot is taken are filtered out
+    bool containsKey(std::string_view key);
+    size_t count();
+    std::vector<std::string> allKeys();
+
+    // the value is a copy of the raw encoded data, the callback is called without holding any lock
+    // return false to stop the iteration
+    void forEach(const MMKV::ForEachCallback &callback);
+
+    // just forbid it for possibly misuse
+    explicit MMKVSnapshot(const MMKVSnapshot &other) = delete;
+    MMKVSnapshot &operator=(const MMKVSnapshot &other) = delete;
+};
+
+MMKV_NAMESPACE_END
+
+#endif // !MMKV_APPLE
+#endif // __cplusplus
+#endif // MMKV_MMKVSNAPSHOT_H
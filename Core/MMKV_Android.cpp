@@ -95,6 +95,15 @@ MMKV::MMKV(const string &mmapID, int size, MMKVMode mode, const string *cryptKey
 
     m_sharedProcessLock->m_enable = isMultiProcess();
     m_exclusiveProcessLock->m_enable = isMultiProcess();
+    m_file->enableDirtyTracking();
+    if ((m_mode & MMKV_BUFFERED_IO) && !isMultiProcess()) {
+        // the meta file must not reach the disk ahead of the data
+        m_file->setBackend(StorageBackend::Buffered);
+        m_metaFile->setBackend(StorageBackend::Buffered);
+    }
+    if (m_mode & MMKV_HUGE_PAGE) {
+        m_file->enableHugePage();
+    }
 
     // sensitive zone
     /*{
@@ -225,6 +234,11 @@ MMKV *MMKV::mmkvWithID(const string &mmapID, int size, MMKVMode mode, const stri
         MMKVInfo("prepare to load %s (id %s) from rootPath %s", mmapID.c_str(), mmapKey.c_str(), rootPath->c_str());
     }
 
+    if (!(mode & MMKV_ASHMEM)) {
+        // it might be in the middle of backup or restore
+        waitForIdleInstancePath(mappedKVPathWithID(mmapID, rootPath, mode));
+    }
+
     MMKV *kv = nullptr;
     auto migrateStatus = (mode & MMKV_ASHMEM) ? MigrateStatus::NoneExist : tryMigrateLegacyMMKVFile(mmapID, rootPath);
     switch (migrateStatus) {
@@ -237,6 +251,7 @@ MMKV *MMKV::mmkvWithID(const string &mmapID, int size, MMKVMode mode, const stri
             break;
         case MigrateStatus::OldToNewMigrateFail: {
             auto legacyID = legacyMmapedKVKey(mmapID, rootPath);
+            waitForIdleInstancePath(mappedKVPathWithID(legacyID, rootPath, mode));
             kv = new MMKV(legacyID, size, mode, cryptKey, rootPath, expectedCapacity);
             break;
         }
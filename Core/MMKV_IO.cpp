@@ -21,6 +21,7 @@
 #include "MMKV_IO.h"
 #include "CodedInputData.h"
 #include "CodedOutputData.h"
+#include "DecryptedValueCache.h"
 #include "InterProcessLock.h"
 #include "MMBuffer.h"
 #include "MMKVLog.h"
@@ -38,6 +39,8 @@
 #include <cassert>
 #include <cstring>
 #include <ctime>
+#include <functional>
+#include <memory>
 
 #ifdef MMKV_IOS
 #    include "MMKV_OSX.h"
@@ -63,6 +66,8 @@ MMKV_NAMESPACE_BEGIN
 
 void MMKV::loadFromFile() {
     loadMetaInfoAndCheck();
+    clearExpireIndex();
+    clearDecryptedValueCache();
 #ifndef MMKV_DISABLE_CRYPT
     if (m_crypter) {
         if (m_metaInfo->m_version >= MMKVVersionRandomIV) {
@@ -78,7 +83,16 @@ void MMKV::loadFromFile() {
     } else {
         // error checking
         bool loadFromFile = false, needFullWriteback = false;
-        checkDataValid(loadFromFile, needFullWriteback);
+        unique_ptr<LazyIndex> lazyIndex(m_lazyIndex);
+        m_lazyIndex = nullptr;
+        if (lazyIndex && m_actualSize == readActualSize() && m_actualSize == m_metaInfo->m_actualSize &&
+            m_crcDigest == m_metaInfo->m_crcDigest) {
+            // the crc has been checked by the lazy lookups, nothing has changed since
+            loadFromFile = true;
+        } else {
+            lazyIndex.reset();
+            checkDataValid(loadFromFile, needFullWriteback);
+        }
         MMKVInfo("loading [%s] with %zu actual size, file size %zu, InterProcess %d, meta info "
                  "version:%u",
                  m_mmapID.c_str(), m_actualSize, m_file->getFileSize(), isMultiProcess(), m_metaInfo->m_version);
@@ -94,9 +108,12 @@ void MMKV::loadFromFile() {
                 clearDictionary(m_dic);
             }
             if (needFullWriteback) {
+                if (salvageBySegmentCRC()) {
+                    MMKVInfo("[%s] salvaged by segment crc", m_mmapID.c_str());
+                } else
 #ifndef MMKV_DISABLE_CRYPT
                 if (m_crypter) {
-                    MiniPBCoder::greedyDecodeMap(*m_dicCrypt, inputBuffer, m_crypter);
+                    MiniPBCoder::greedyDecodeMap(*m_dicCrypt, inputBuffer, m_crypter, 0, isLazyDecrypt());
                 } else
 #endif
                 {
@@ -105,7 +122,15 @@ void MMKV::loadFromFile() {
             } else {
 #ifndef MMKV_DISABLE_CRYPT
                 if (m_crypter) {
-                    MiniPBCoder::decodeMap(*m_dicCrypt, inputBuffer, m_crypter);
+                    MiniPBCoder::decodeMap(*m_dicCrypt, inputBuffer, m_crypter, 0, isLazyDecrypt());
+                } else
+#endif
+#ifndef MMKV_APPLE
+                if (lazyIndex) {
+                    m_dic->reserve(lazyIndex->size());
+                    for (auto &itr : *lazyIndex) {
+                        m_dic->emplace(string(itr.first), itr.second);
+                    }
                 } else
 #endif
                 {
@@ -116,19 +141,34 @@ void MMKV::loadFromFile() {
             m_output->seek(m_actualSize);
             if (needFullWriteback) {
                 fullWriteback();
+            } else {
+                checkSegmentCRC();
             }
         } else {
             // file not valid or empty, discard everything
             SCOPED_LOCK(m_exclusiveProcessLock);
 
             m_output = new CodedOutputData(ptr + Fixed32Size, m_file->getFileSize() - Fixed32Size);
-            if (m_actualSize > 0) {
-                writeActualSize(0, 0, nullptr, IncreaseSequence);
+            if (m_actualSize > 0 || needFullWriteback) {
+#ifndef MMKV_DISABLE_CRYPT
+                // the keystream has been used by what's discarded
+                if (m_crypter) {
+                    uint8_t newIV[AES_KEY_LEN];
+                    AESCrypt::fillRandomIV(newIV);
+                    m_crypter->resetIV(newIV, sizeof(newIV));
+                    writeActualSize(0, 0, newIV, IncreaseSequence);
+                } else
+#endif
+                {
+                    writeActualSize(0, 0, nullptr, IncreaseSequence);
+                }
                 sync(MMKV_SYNC);
             } else {
                 writeActualSize(0, 0, nullptr, KeepSequence);
             }
         }
+        // from now on it's mostly point reads of values
+        adviseDataAccess(AccessHint::Random, m_actualSize);
         auto count = m_crypter ? m_dicCrypt->size() : m_dic->size();
         MMKVInfo("loaded [%s] with %zu key-values", m_mmapID.c_str(), count);
 //        auto keys = allKeys();
@@ -140,6 +180,12 @@ void MMKV::loadFromFile() {
     m_needLoadFromFile = false;
 }
 
+void MMKV::adviseDataAccess(AccessHint hint, size_t dataSize) {
+    if (m_enableAccessHints) {
+        m_file->adviseAccess(hint, 0, Fixed32Size + dataSize);
+    }
+}
+
 // read from last m_position
 void MMKV::partialLoadFromFile() {
     if (!m_file->isFileValid()) {
@@ -162,15 +208,42 @@ void MMKV::partialLoadFromFile() {
                 // incremental update crc digest
                 m_crcDigest = (uint32_t) CRC32(m_crcDigest, basePtr + position, (z_size_t) addedSize);
                 if (m_crcDigest == m_metaInfo->m_crcDigest) {
+                    // let sync() cover what other processes have appended
+                    m_file->markDirty(Fixed32Size + position, addedSize);
                     MMBuffer inputBuffer(basePtr, m_actualSize, MMBufferNoCopy);
 #ifndef MMKV_DISABLE_CRYPT
                     if (m_crypter) {
-                        MiniPBCoder::greedyDecodeMap(*m_dicCrypt, inputBuffer, m_crypter, position);
+#ifndef MMKV_APPLE
+                        // the keys are encrypted along with the values, tell what's changed by the key set
+                        auto oldKeys = m_changedKeys ? loadedKeys() : vector<string>();
+#endif
+                        MiniPBCoder::greedyDecodeMap(*m_dicCrypt, inputBuffer, m_crypter, position, isLazyDecrypt());
+#ifndef MMKV_APPLE
+                        if (m_changedKeys) {
+                            trackReloadedKeys(oldKeys);
+                        }
+#endif
                     } else
 #endif
                     {
+#ifndef MMKV_APPLE
+                        vector<string> keys;
+                        if (m_changedKeys) {
+                            keys = MiniPBCoder::decodeItemKeys(inputBuffer, position);
+                            for (auto &key : keys) {
+                                trackChangedKey(key, m_dic->find(key) != m_dic->end(), false);
+                            }
+                        }
+#endif
                         MiniPBCoder::greedyDecodeMap(*m_dic, inputBuffer, position);
+#ifndef MMKV_APPLE
+                        for (auto &key : keys) {
+                            trackChangedKey(key, false, m_dic->find(key) != m_dic->end());
+                        }
+#endif
                     }
+                    clearExpireIndex();
+                    clearDecryptedValueCache();
                     m_output->seek(addedSize);
                     m_hasFullWriteback = false;
 
@@ -184,8 +257,215 @@ void MMKV::partialLoadFromFile() {
         }
     }
     // something is wrong, do a full load
-    clearMemoryCache();
+    fullReloadFromFile();
+}
+
+void MMKV::fullReloadFromFile(bool keepSpace) {
+#ifndef MMKV_APPLE
+    auto oldKeys = m_changedKeys ? loadedKeys() : vector<string>();
+#endif
+    doClearMemoryCache(keepSpace);
     loadFromFile();
+#ifndef MMKV_APPLE
+    if (m_changedKeys) {
+        trackReloadedKeys(oldKeys);
+    }
+#endif
+}
+
+#ifndef MMKV_APPLE
+// values are not compared, every key that survives counts as updated
+void MMKV::trackReloadedKeys(const vector<string> &oldKeys) {
+    for (auto &key : oldKeys) {
+        bool exists = false;
+#ifndef MMKV_DISABLE_CRYPT
+        if (m_crypter) {
+            exists = m_dicCrypt->find(key) != m_dicCrypt->end();
+        } else
+#endif
+        {
+            exists = m_dic->find(key) != m_dic->end();
+        }
+        trackChangedKey(key, true, exists);
+    }
+    for (auto &key : loadedKeys()) {
+        trackChangedKey(key, false, true);
+    }
+}
+#endif
+
+// written by the process that compacts a multi-process instance, followed by [count] pairs of (old offset, new offset)
+struct CompactionJournal {
+    uint32_t version;
+    // the sequence increased by the compaction
+    uint32_t sequence;
+    // the data right before the compaction
+    uint32_t lastSequence;
+    uint32_t lastActualSize;
+    uint32_t lastCRCDigest;
+    // the data right after the compaction
+    uint32_t actualSize;
+    uint32_t crcDigest;
+    uint32_t count;
+};
+constexpr uint32_t CompactionJournalVersion = 1;
+using Relocation = pair<uint32_t, uint32_t>;
+
+bool MMKV::hasCompactionJournal() const {
+#ifdef MMKV_ANDROID
+    if (isAshmem()) {
+        return false;
+    }
+#elif defined(MMKV_LINUX)
+    if (isMemfd()) {
+        return false;
+    }
+#endif
+    return isMultiProcess();
+}
+
+void MMKV::writeCompactionJournal(const vector<Relocation> &relocations,
+                                  uint32_t lastSequence, size_t lastActualSize, uint32_t lastCRCDigest) {
+    auto size = sizeof(CompactionJournal) + relocations.size() * sizeof(Relocation);
+    auto path = compactionJournalPathWithPath(m_path);
+#ifndef MMKV_ANDROID
+    MemoryFile file(path, size);
+#else
+    MemoryFile file(path, DEFAULT_MMAP_SIZE, MMFILE_TYPE_FILE, size);
+#endif
+    if (!file.isFileValid() || file.getFileSize() < size) {
+        MMKVWarning("[%s] fail to write compaction journal", m_mmapID.c_str());
+        return;
+    }
+    CompactionJournal journal = {CompactionJournalVersion,
+                                 m_metaInfo->m_sequence,
+                                 lastSequence,
+                                 static_cast<uint32_t>(lastActualSize),
+                                 lastCRCDigest,
+                                 static_cast<uint32_t>(m_actualSize),
+                                 m_crcDigest,
+                                 static_cast<uint32_t>(relocations.size())};
+    // other processes only read it with the process lock, it's never torn
+    auto ptr = (uint8_t *) file.getMemory();
+    memcpy(ptr, &journal, sizeof(journal));
+    if (!relocations.empty()) {
+        memcpy(ptr + sizeof(journal), relocations.data(), relocations.size() * sizeof(Relocation));
+    }
+}
+
+bool MMKV::relocateByCompactionJournal(const MMKVMetaInfo &metaInfo) {
+    if (m_crypter || !m_dic || !m_output || !m_file->isFileValid() || !hasCompactionJournal()) {
+        return false;
+    }
+    unique_ptr<MMBuffer> buffer(readWholeFile(compactionJournalPathWithPath(m_path)));
+    if (!buffer || buffer->length() < sizeof(CompactionJournal)) {
+        return false;
+    }
+    CompactionJournal journal = {};
+    memcpy(&journal, buffer->getPtr(), sizeof(journal));
+    // the file is only appended within a sequence, what we have loaded is a prefix of what has been compacted
+    if (journal.version != CompactionJournalVersion || journal.sequence != metaInfo.m_sequence ||
+        journal.lastSequence != m_metaInfo->m_sequence || journal.lastActualSize < m_actualSize ||
+        (journal.lastActualSize == m_actualSize && journal.lastCRCDigest != m_crcDigest)) {
+        return false;
+    }
+    // and what's in the file now must start with the compacted data
+    if (metaInfo.m_actualSize < journal.actualSize ||
+        (metaInfo.m_actualSize == journal.actualSize && metaInfo.m_crcDigest != journal.crcDigest)) {
+        return false;
+    }
+    if (buffer->length() < sizeof(CompactionJournal) + journal.count * sizeof(Relocation)) {
+        return false;
+    }
+    auto relocations = (const Relocation *) ((const uint8_t *) buffer->getPtr() + sizeof(CompactionJournal));
+
+    // the compaction keeps the items in the order of their offsets
+    vector<MMKVMap::iterator> vec;
+    vec.reserve(m_dic->size());
+    for (auto itr = m_dic->begin(); itr != m_dic->end(); itr++) {
+        vec.push_back(itr);
+    }
+    sort(vec.begin(), vec.end(), [](const auto &left, const auto &right) { return left->second.offset < right->second.offset; });
+    // every item kept from what we have loaded must be found, the rest have been overwritten or removed since
+    size_t loadedCount = 0;
+    while (loadedCount < journal.count && relocations[loadedCount].first < m_actualSize) {
+        loadedCount++;
+    }
+    size_t index = 0;
+    for (auto &itr : vec) {
+        if (index < loadedCount && itr->second.offset == relocations[index].first) {
+            index++;
+        } else if (index < loadedCount && itr->second.offset > relocations[index].first) {
+            return false;
+        }
+    }
+    if (index != loadedCount) {
+        return false;
+    }
+
+    detachSnapshots();
+    delete m_output;
+    m_output = nullptr;
+    // the compaction might have expanded the file
+    if (m_file->getActualFileSize() != m_file->getFileSize()) {
+        m_file->clearMemoryCache();
+        m_file->reloadFromFile(m_expectedCapacity);
+        if (!m_file->isFileValid() || Fixed32Size + metaInfo.m_actualSize > m_file->getFileSize()) {
+            return false;
+        }
+    }
+    index = 0;
+    for (auto &itr : vec) {
+        if (index < loadedCount && itr->second.offset == relocations[index].first) {
+            itr->second.offset = relocations[index].second;
+            index++;
+        } else {
+            auto oldKey = itr->first;
+#ifndef MMKV_APPLE
+            if (m_changedKeys) {
+                trackChangedKey(oldKey, true, false);
+            }
+#endif
+            m_dic->erase(itr);
+            mmkv_release_key(oldKey);
+        }
+    }
+    clearExpireIndex();
+    clearDecryptedValueCache();
+    m_metaInfo->read(m_metaFile->getMemory());
+    m_actualSize = journal.actualSize;
+    m_crcDigest = journal.crcDigest;
+    auto ptr = (uint8_t *) m_file->getMemory();
+    // what had been appended after what we have loaded ends up at the end of the compacted data
+    if (loadedCount < journal.count) {
+        MMBuffer inputBuffer(ptr + Fixed32Size, m_actualSize, MMBufferNoCopy);
+#ifndef MMKV_APPLE
+        vector<string> keys;
+        if (m_changedKeys) {
+            keys = MiniPBCoder::decodeItemKeys(inputBuffer, relocations[loadedCount].second);
+            for (auto &key : keys) {
+                trackChangedKey(key, m_dic->find(key) != m_dic->end(), false);
+            }
+        }
+#endif
+        MiniPBCoder::greedyDecodeMap(*m_dic, inputBuffer, relocations[loadedCount].second);
+#ifndef MMKV_APPLE
+        for (auto &key : keys) {
+            trackChangedKey(key, false, m_dic->find(key) != m_dic->end());
+        }
+#endif
+    }
+    m_output = new CodedOutputData(ptr + Fixed32Size, m_file->getFileSize() - Fixed32Size);
+    m_output->seek(m_actualSize);
+    m_hasFullWriteback = false;
+    MMKVInfo("[%s] relocated %zu items and decoded %zu items by the compaction of sequence %u", m_mmapID.c_str(),
+             loadedCount, journal.count - loadedCount, journal.sequence);
+
+    // what has been appended since the compaction
+    if (metaInfo.m_actualSize != journal.actualSize) {
+        partialLoadFromFile();
+    }
+    return true;
 }
 
 //#if defined(MMKV_APPLE) || defined(MMKV_WIN32)
@@ -248,6 +528,11 @@ void MMKV::loadMetaInfoAndCheck() {
             m_metaInfo->write(m_metaFile->getMemory());
         }
     }
+#ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter && m_crypter->cryptMode() != m_metaInfo->cryptMode()) {
+        m_crypter->setCryptMode(m_metaInfo->cryptMode());
+    }
+#endif
 }
 
 void MMKV::checkDataValid(bool &loadFromFile, bool &needFullWriteback) {
@@ -265,6 +550,8 @@ void MMKV::checkDataValid(bool &loadFromFile, bool &needFullWriteback) {
                     if (checkFileCRCValid(oldStyleActualSize, m_metaInfo->m_crcDigest)) {
                         MMKVInfo("looks like [%s] been downgrade & upgrade again", m_mmapID.c_str());
                         loadFromFile = true;
+                        // the keystream after the rolled back size has been used, rewrite with a new IV
+                        needFullWriteback = (m_crypter != nullptr);
                         writeActualSize(oldStyleActualSize, m_metaInfo->m_crcDigest, nullptr, KeepSequence);
                         return;
                     }
@@ -278,6 +565,7 @@ void MMKV::checkDataValid(bool &loadFromFile, bool &needFullWriteback) {
                 auto lastCRCDigest = m_metaInfo->m_lastConfirmedMetaInfo.lastCRCDigest;
                 if (checkFileCRCValid(lastActualSize, lastCRCDigest)) {
                     loadFromFile = true;
+                    needFullWriteback = (m_crypter != nullptr);
                     writeActualSize(lastActualSize, lastCRCDigest, nullptr, KeepSequence);
                 } else {
                     MMKVError("check [%s] error: lastActualSize %u, lastActualCRC %u", m_mmapID.c_str(), lastActualSize,
@@ -293,6 +581,8 @@ void MMKV::checkDataValid(bool &loadFromFile, bool &needFullWriteback) {
     m_actualSize = readActualSize();
 
     if (m_actualSize < fileSize && (m_actualSize + Fixed32Size) <= fileSize) {
+        // the crc check & decoding are about to read through the data, rather than faulting it in page by page
+        adviseDataAccess(AccessHint::WillNeed, m_actualSize);
         if (checkFileCRCValid(m_actualSize, m_metaInfo->m_crcDigest)) {
             loadFromFile = true;
         } else {
@@ -348,8 +638,14 @@ void MMKV::checkLoadData() {
         MMKVInfo("[%s] oldSeq %u, newSeq %u", m_mmapID.c_str(), m_metaInfo->m_sequence, metaInfo.m_sequence);
         SCOPED_LOCK(m_sharedProcessLock);
 
-        clearMemoryCache();
-        loadFromFile();
+#ifndef MMKV_APPLE
+        beginTrackingChangedKeys();
+#endif
+        if (!relocateByCompactionJournal(metaInfo)) {
+            // rewritten in place (override, full write back...), the mapping is still good as long as the size is
+            bool keepSpace = m_file->isFileValid() && m_file->getActualFileSize() == m_file->getFileSize();
+            fullReloadFromFile(keepSpace);
+        }
         notifyContentChanged();
     } else if ((m_metaInfo->m_crcDigest != metaInfo.m_crcDigest) || (m_metaInfo->m_actualSize != metaInfo.m_actualSize)) {
         MMKVDebug("[%s] crcDigest %u -> %u, actualSize %u -> %u", m_mmapID.c_str(), m_metaInfo->m_crcDigest,
@@ -361,9 +657,12 @@ void MMKV::checkLoadData() {
         /*size_t fileSize = m_file->getActualFileSize();
         if (m_file->getFileSize() != fileSize) {
             MMKVInfo("file size has changed [%s] from %zu to %zu", m_mmapID.c_str(), m_file->getFileSize(), fileSize);
-            clearMemoryCache();
+            doClearMemoryCache();
             loadFromFile();
         } else*/ {
+#ifndef MMKV_APPLE
+            beginTrackingChangedKeys();
+#endif
             partialLoadFromFile();
         }
         notifyContentChanged();
@@ -449,6 +748,7 @@ bool MMKV::ensureMemorySize(size_t newSize) {
 
 // try a full rewrite to make space
 bool MMKV::expandAndWriteBack(size_t newSize, std::pair<mmkv::MMBuffer, size_t> preparedData, bool needSync) {
+    detachSnapshots();
     auto fileSize = m_file->getFileSize();
     auto sizeOfDic = preparedData.second;
     size_t lenNeeded = sizeOfDic + Fixed32Size + newSize;
@@ -505,9 +805,10 @@ void MMKV::oldStyleWriteActualSize(size_t actualSize) {
 
     m_actualSize = actualSize;
     memcpy(m_file->getMemory(), &actualSize, Fixed32Size);
+    m_file->markDirty(0, Fixed32Size);
 }
 
-bool MMKV::writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool increaseSequence) {
+bool MMKV::writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool increaseSequence, bool logSequence) {
     // backward compatibility
     oldStyleWriteActualSize(size);
 
@@ -516,6 +817,7 @@ bool MMKV::writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool
     }
 
     bool needsFullWrite = false;
+    bool sequenceChanged = false;
     m_actualSize = size;
     m_metaInfo->m_actualSize = static_cast<uint32_t>(size);
     m_crcDigest = crcDigest;
@@ -529,8 +831,9 @@ bool MMKV::writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool
         memcpy(m_metaInfo->m_vector, iv, sizeof(m_metaInfo->m_vector));
         if (m_metaInfo->m_version < MMKVVersionRandomIV) {
             m_metaInfo->m_version = MMKVVersionRandomIV;
+            needsFullWrite = true;
         }
-        needsFullWrite = true;
+        sequenceChanged = true;
     }
 #endif
     if (mmkv_unlikely(increaseSequence)) {
@@ -539,21 +842,41 @@ bool MMKV::writeActualSize(size_t size, uint32_t crcDigest, const void *iv, bool
         m_metaInfo->m_lastConfirmedMetaInfo.lastCRCDigest = crcDigest;
         if (m_metaInfo->m_version < MMKVVersionActualSize) {
             m_metaInfo->m_version = MMKVVersionActualSize;
+            needsFullWrite = true;
+        }
+        sequenceChanged = true;
+        if (logSequence) {
+            MMKVInfo("[%s] increase sequence to %u, crc %u, actualSize %u", m_mmapID.c_str(), m_metaInfo->m_sequence,
+                     m_metaInfo->m_crcDigest, m_metaInfo->m_actualSize);
+        } else {
+            MMKVDebug("[%s] increase sequence to %u, crc %u, actualSize %u", m_mmapID.c_str(), m_metaInfo->m_sequence,
+                      m_metaInfo->m_crcDigest, m_metaInfo->m_actualSize);
         }
-        needsFullWrite = true;
-        MMKVInfo("[%s] increase sequence to %u, crc %u, actualSize %u", m_mmapID.c_str(), m_metaInfo->m_sequence,
-                 m_metaInfo->m_crcDigest, m_metaInfo->m_actualSize);
     }
     if (m_metaInfo->m_version < MMKVVersionFlag) {
         m_metaInfo->m_flags = 0;
         m_metaInfo->m_version = MMKVVersionFlag;
         needsFullWrite = true;
     }
+    // the flags or the version may be changed right before asking for a new sequence
+    if (mmkv_unlikely(sequenceChanged)) {
+        auto fileMetaInfo = (const MMKVMetaInfo *) m_metaFile->getMemory();
+        if (fileMetaInfo->m_flags != m_metaInfo->m_flags || fileMetaInfo->m_version != m_metaInfo->m_version) {
+            needsFullWrite = true;
+        }
+    }
     if (mmkv_unlikely(needsFullWrite)) {
         m_metaInfo->write(m_metaFile->getMemory());
+    } else if (mmkv_unlikely(sequenceChanged)) {
+        m_metaInfo->writeCRCAndSequenceOnly(m_metaFile->getMemory());
     } else {
         m_metaInfo->writeCRCAndActualSizeOnly(m_metaFile->getMemory());
     }
+    if (mmkv_unlikely(m_file->getPendingWriteBackSize() >= MemoryFile::BufferedWriteBackSize)) {
+        // bound what a crash loses with the Buffered backend, the data & meta agree with each other here
+        m_file->msync(MMKV_ASYNC);
+        m_metaFile->msync(MMKV_ASYNC);
+    }
     return true;
 }
 
@@ -564,7 +887,7 @@ MMBuffer MMKV::getRawDataForKey(MMKVKey_t key) {
         auto itr = m_dicCrypt->find(key);
         if (itr != m_dicCrypt->end()) {
             auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
-            return itr->second.toMMBuffer(basePtr, m_crypter);
+            return decryptValue(key, itr->second, basePtr);
         }
     } else
 #endif
@@ -579,13 +902,134 @@ MMBuffer MMKV::getRawDataForKey(MMKVKey_t key) {
     return nan;
 }
 
+bool MMKV::getRawValuePtrForKey(MMKVKey_t key, const uint8_t *&ptr, size_t &size) {
+    if (m_crypter || (mmkv_unlikely(m_needLoadFromFile) && isLazyLoad())) {
+        return false;
+    }
+    checkLoadData();
+    if (mmkv_unlikely(m_enableKeyExpire)) {
+        return false;
+    }
+    auto itr = m_dic->find(key);
+    if (itr != m_dic->end()) {
+        auto &kvHolder = itr->second;
+        ptr = (const uint8_t *) (m_file->getMemory()) + Fixed32Size + kvHolder.offset + kvHolder.computedKVSize;
+        size = kvHolder.valueSize;
+    } else {
+        ptr = nullptr;
+        size = 0;
+    }
+    return true;
+}
+
 mmkv::MMBuffer MMKV::getDataForKey(MMKVKey_t key) {
+    if (mmkv_unlikely(m_needLoadFromFile) && isLazyLoad()) {
+        MMBuffer data;
+        if (lazyGetDataForKey(key, data)) {
+            return data;
+        }
+    }
     if (mmkv_unlikely(m_enableKeyExpire)) {
         return getDataWithoutMTimeForKey(key);
     }
     return getRawDataForKey(key);
 }
 
+// one pass over the validated log, the last record of a key wins, just like decoding the whole map
+bool MMKV::buildLazyIndex() {
+    auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
+    auto index = make_unique<LazyIndex>();
+    try {
+        CodedInputData input(basePtr, m_actualSize);
+        if (m_actualSize > 0) {
+            input.readInt32();
+        }
+        while (!input.isAtEnd()) {
+            KeyValueHolder kvHolder;
+            string_view key;
+            if (!input.readKeyValueHolder(kvHolder, key)) {
+                MMKVError("[%s] InvalidProtocolBuffer truncatedMessage", m_mmapID.c_str());
+                return false;
+            }
+            if (key.empty()) {
+                continue;
+            }
+            if (kvHolder.valueSize > 0) {
+                (*index)[key] = kvHolder;
+            } else {
+                index->erase(key);
+            }
+        }
+    } catch (std::exception &exception) {
+        MMKVError("%s", exception.what());
+        return false;
+    }
+    MMKVInfo("[%s] lazily indexed %zu keys", m_mmapID.c_str(), index->size());
+    m_lazyIndex = index.release();
+    return true;
+}
+
+bool MMKV::lazyGetDataForKey(MMKVKey_t key, MMBuffer &result) {
+    if (m_crypter || isMultiProcess() || m_lazyLookupFailed) {
+        return false;
+    }
+    if (!m_lazyIndex) {
+        // leave all the error recovering to loadFromFile()
+        m_lazyLookupFailed = true;
+        loadMetaInfoAndCheck();
+        if (!m_file->isFileValid()) {
+            m_file->reloadFromFile(m_expectedCapacity);
+        }
+        if (!m_file->isFileValid() || !m_metaFile->isFileValid()) {
+            return false;
+        }
+        auto fileSize = m_file->getFileSize();
+        m_actualSize = readActualSize();
+        if (m_actualSize >= fileSize || (m_actualSize + Fixed32Size) > fileSize) {
+            return false;
+        }
+        if (!checkFileCRCValid(m_actualSize, m_metaInfo->m_crcDigest)) {
+            return false;
+        }
+        if (!buildLazyIndex()) {
+            return false;
+        }
+        m_lazyLookupFailed = false;
+    }
+
+#ifdef MMKV_APPLE
+    auto keyPtr = key.UTF8String;
+    auto keyLength = strlen(keyPtr);
+#else
+    auto keyPtr = key.data();
+    auto keyLength = key.length();
+#endif
+    auto itr = m_lazyIndex->find(string_view(keyPtr, keyLength));
+    if (itr == m_lazyIndex->end()) {
+        result = MMBuffer();
+        return true;
+    }
+
+    auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
+    auto raw = itr->second.toMMBuffer(basePtr);
+    if (m_enableKeyExpire) {
+        if (raw.length() < Fixed32Size) {
+            return false;
+        }
+        auto newLength = raw.length() - Fixed32Size;
+        auto ptr = (const uint8_t *) raw.getPtr() + newLength;
+        auto time = *(const uint32_t *) ptr;
+        if (time != ExpireNever && time <= getCurrentTimeInSecond()) {
+            // let the normal path delete it
+            return false;
+        }
+        result = MMBuffer(std::move(raw), newLength);
+    } else {
+        result = std::move(raw);
+    }
+    return true;
+}
+
 #ifndef MMKV_DISABLE_CRYPT
 // for Apple watch simulator
 #    if defined(TARGET_OS_SIMULATOR) && defined(TARGET_CPU_X86)
@@ -602,19 +1046,26 @@ bool MMKV::setDataForKey(MMBuffer &&data, MMKVKey_t key, bool isDataHolder) {
     SCOPED_LOCK(m_lock);
     SCOPED_LOCK(m_exclusiveProcessLock);
     checkLoadData();
+#ifndef MMKV_APPLE
+    if (mmkv_unlikely(m_enableKeyExpire) && !isDataHolder) {
+        indexExpireTime(key, data);
+    }
+#endif
 
 #ifndef MMKV_DISABLE_CRYPT
     if (m_crypter) {
+        eraseDecryptedValue(key);
+        auto lazyDecrypt = isLazyDecrypt();
         if (isDataHolder) {
             auto sizeNeededForData = pbRawVarint32Size((uint32_t) data.length()) + data.length();
-            if (!KeyValueHolderCrypt::isValueStoredAsOffset(sizeNeededForData)) {
+            if (!KeyValueHolderCrypt::isValueStoredAsOffset(sizeNeededForData, lazyDecrypt)) {
                 data = MiniPBCoder::encodeDataWithObject(data);
                 isDataHolder = false;
             }
         }
         auto itr = m_dicCrypt->find(key);
         if (itr != m_dicCrypt->end()) {
-            bool onlyOneKey = !isMultiProcess() && m_dicCrypt->size() == 1;
+            bool onlyOneKey = m_dicCrypt->size() == 1;
 #    ifdef MMKV_APPLE
             KVHolderRet_t ret;
             if (onlyOneKey) {
@@ -634,7 +1085,7 @@ bool MMKV::setDataForKey(MMBuffer &&data, MMKVKey_t key, bool isDataHolder) {
                 return false;
             }
             KeyValueHolderCrypt kvHolder;
-            if (KeyValueHolderCrypt::isValueStoredAsOffset(ret.second.valueSize)) {
+            if (KeyValueHolderCrypt::isValueStoredAsOffset(ret.second.valueSize, lazyDecrypt)) {
                 kvHolder = KeyValueHolderCrypt(ret.second.keySize, ret.second.valueSize, ret.second.offset);
                 memcpy(&kvHolder.cryptStatus, &t_status, sizeof(t_status));
             } else {
@@ -653,7 +1104,7 @@ bool MMKV::setDataForKey(MMBuffer &&data, MMKVKey_t key, bool isDataHolder) {
                 }
             }
         } else {
-            bool needOverride = !isMultiProcess() && m_dicCrypt->empty() && m_actualSize > 0;
+            bool needOverride = m_dicCrypt->empty() && m_actualSize > 0;
             KVHolderRet_t ret;
             if (needOverride) {
                 ret = overrideDataWithKey(data, key, isDataHolder);
@@ -663,7 +1114,7 @@ bool MMKV::setDataForKey(MMBuffer &&data, MMKVKey_t key, bool isDataHolder) {
             if (!ret.first) {
                 return false;
             }
-            if (KeyValueHolderCrypt::isValueStoredAsOffset(ret.second.valueSize)) {
+            if (KeyValueHolderCrypt::isValueStoredAsOffset(ret.second.valueSize, lazyDecrypt)) {
                 auto r = m_dicCrypt->emplace(
                     key, KeyValueHolderCrypt(ret.second.keySize, ret.second.valueSize, ret.second.offset));
                 if (r.second) {
@@ -705,7 +1156,7 @@ bool MMKV::setDataForKey(MMBuffer &&data, MMKVKey_t key, bool isDataHolder) {
                 }
             }
 
-            bool onlyOneKey = !isMultiProcess() && m_dic->size() == 1;
+            bool onlyOneKey = m_dic->size() == 1;
             if (mmkv_likely(!m_enableKeyExpire)) {
                 KVHolderRet_t ret;
                 if (onlyOneKey) {
@@ -737,7 +1188,7 @@ bool MMKV::setDataForKey(MMBuffer &&data, MMKVKey_t key, bool isDataHolder) {
                 }
             }
         } else {
-            bool needOverride = !isMultiProcess() && m_dic->empty() && m_actualSize > 0;
+            bool needOverride = m_dic->empty() && m_actualSize > 0;
             KVHolderRet_t ret;
             if (needOverride) {
                 ret = overrideDataWithKey(data, key, isDataHolder);
@@ -790,6 +1241,7 @@ bool MMKV::removeDataForKey(MMKVKey_t key) {
 #    else
             auto ret = appendDataWithKey(nan, key);
             if (ret.first) {
+                eraseDecryptedValue(key);
                 if (mmkv_unlikely(m_enableKeyExpire)) {
                     eraseHelper(*m_dicCrypt, key);
                 } else {
@@ -857,7 +1309,7 @@ MMKV::doAppendDataWithKey(const MMBuffer &data, const MMBuffer &keyData, bool is
 
 #ifndef MMKV_DISABLE_CRYPT
     if (m_crypter) {
-        if (KeyValueHolderCrypt::isValueStoredAsOffset(valueLength)) {
+        if (KeyValueHolderCrypt::isValueStoredAsOffset(valueLength, isLazyDecrypt())) {
             m_crypter->getCurStatus(t_status);
         }
     }
@@ -912,18 +1364,18 @@ KVHolderRet_t MMKV::doOverrideDataWithKey(const MMBuffer &data,
         return doAppendDataWithKey(data, keyData, isDataHolder, originKeyLength);
     }
 
-    // we don't not support override in multi-process mode
-    // SCOPED_LOCK(m_exclusiveProcessLock);
+    // other processes only expect appending, rewriting from the beginning must bump the sequence (see below)
+    SCOPED_LOCK(m_exclusiveProcessLock);
 
 #ifndef MMKV_DISABLE_CRYPT
+    // never encrypt different data with the same keystream, just like doFullWriteBack()
+    uint8_t newIV[AES_KEY_LEN];
     if (m_crypter) {
-        if (m_metaInfo->m_version >= MMKVVersionRandomIV) {
-            m_crypter->resetIV(m_metaInfo->m_vector, sizeof(m_metaInfo->m_vector));
-        } else {
-            m_crypter->resetIV();
-        }
+        AESCrypt::fillRandomIV(newIV);
+        m_crypter->resetIV(newIV, sizeof(newIV));
     }
 #endif
+    detachSnapshots();
     try {
         // write ItemSizeHolder
         m_output->setPosition(0);
@@ -933,7 +1385,7 @@ KVHolderRet_t MMKV::doOverrideDataWithKey(const MMBuffer &data,
         if (m_crypter) {
             auto ptr = (uint8_t *) m_file->getMemory() + Fixed32Size;
             m_crypter->encrypt(ptr, ptr, m_actualSize);
-            if (KeyValueHolderCrypt::isValueStoredAsOffset(valueLength)) {
+            if (KeyValueHolderCrypt::isValueStoredAsOffset(valueLength, isLazyDecrypt())) {
                 m_crypter->getCurStatus(t_status);
             }
         }
@@ -963,7 +1415,13 @@ KVHolderRet_t MMKV::doOverrideDataWithKey(const MMBuffer &data,
         m_crypter->encrypt(ptr, ptr, size);
     }
 #endif
-    recalculateCRCDigestOnly();
+    // it's rewritten from the beginning, a new sequence tells the peers & the cursors of changesSince()
+    // it happens on every set of a one-key instance, too often for an Info log
+#ifndef MMKV_DISABLE_CRYPT
+    recalculateCRCDigestWithIV(m_crypter ? newIV : nullptr, m_crypter, 0, false);
+#else
+    recalculateCRCDigestWithIV(nullptr, nullptr, 0, false);
+#endif
 
     return make_pair(true, KeyValueHolder(originKeyLength, valueLength, offset));
 }
@@ -1030,8 +1488,7 @@ KVHolderRet_t MMKV::appendDataWithKey(const MMBuffer &data, const KeyValueHolder
 
 // only one key in dict, do not append, just rewrite from beginning
 KVHolderRet_t MMKV::overrideDataWithKey(const MMBuffer &data, const KeyValueHolder &kvHolder, bool isDataHolder) {
-    // we don't not support override in multi-process mode
-    // SCOPED_LOCK(m_exclusiveProcessLock);
+    SCOPED_LOCK(m_exclusiveProcessLock);
 
     uint32_t keyLength = kvHolder.keySize;
     // size needed to encode the key
@@ -1100,11 +1557,14 @@ bool MMKV::fullWriteback(AESCrypt *newCrypter, bool onlyWhileExpire) {
 }
 
 // we don't need to really serialize the dictionary, just reuse what's already in the file
-static void
-memmoveDictionary(MMKVMap &dic, CodedOutputData *output, uint8_t *ptr, AESCrypt *encrypter, size_t totalSize) {
+// return the size of the leading items that stay where they were (including the item size holder)
+// relocations: filled with pairs of (old offset, new offset) sorted by the old offset if not nullptr
+static size_t memmoveDictionary(MMKVMap &dic, CodedOutputData *output, uint8_t *ptr, AESCrypt *encrypter, size_t totalSize,
+                                vector<pair<uint32_t, uint32_t>> *relocations = nullptr) {
     auto originOutputPtr = output->curWritePointer();
     // make space to hold the fake size of dictionary's serialization result
     auto writePtr = originOutputPtr + ItemSizeHolderSize;
+    auto unchangedPtr = writePtr;
     // reuse what's already in the file
     if (!dic.empty()) {
         // sort by offset
@@ -1131,13 +1591,23 @@ memmoveDictionary(MMKVMap &dic, CodedOutputData *output, uint8_t *ptr, AESCrypt
         auto basePtr = ptr + Fixed32Size;
         for (auto &section : dataSections) {
             // memmove() should handle this well: src == dst
+            auto isInPlace = (writePtr == basePtr + section.first);
             memmove(writePtr, basePtr + section.first, section.second);
             writePtr += section.second;
+            if (isInPlace && unchangedPtr + section.second == writePtr) {
+                unchangedPtr = writePtr;
+            }
         }
         // update offset
         if (!encrypter) {
             auto offset = ItemSizeHolderSize;
+            if (relocations) {
+                relocations->reserve(vec.size());
+            }
             for (auto kvHolder : vec) {
+                if (relocations) {
+                    relocations->emplace_back(kvHolder->offset, offset);
+                }
                 kvHolder->offset = offset;
                 offset += kvHolder->computedKVSize + kvHolder->valueSize;
             }
@@ -1153,6 +1623,7 @@ memmoveDictionary(MMKVMap &dic, CodedOutputData *output, uint8_t *ptr, AESCrypt
 #endif
     assert(writtenSize == totalSize);
     output->seek(writtenSize - ItemSizeHolderSize);
+    return static_cast<size_t>(unchangedPtr - originOutputPtr);
 }
 
 #ifndef MMKV_DISABLE_CRYPT
@@ -1265,6 +1736,10 @@ static void fullWriteBackWholeData(MMBuffer allData, size_t totalSize, CodedOutp
 bool MMKV::doFullWriteBack(pair<MMBuffer, size_t> prepared, AESCrypt *newCrypter, bool needSync) {
     auto ptr = (uint8_t *) m_file->getMemory();
     auto totalSize = prepared.second;
+    auto oldActualSize = m_actualSize;
+    auto oldCRCDigest = m_crcDigest;
+    auto oldSequence = m_metaInfo->m_sequence;
+    adviseDataAccess(AccessHint::Sequential, max(oldActualSize, totalSize));
 
     uint8_t newIV[AES_KEY_LEN];
     auto encrypter = (newCrypter == InvalidCryptPtr) ? nullptr : (newCrypter ? newCrypter : m_crypter);
@@ -1273,8 +1748,12 @@ bool MMKV::doFullWriteBack(pair<MMBuffer, size_t> prepared, AESCrypt *newCrypter
         encrypter->resetIV(newIV, sizeof(newIV));
     }
 
+    detachSnapshots();
     delete m_output;
     m_output = new CodedOutputData(ptr + Fixed32Size, m_file->getFileSize() - Fixed32Size);
+    size_t unchangedSize = 0;
+    bool needJournal = false;
+    vector<pair<uint32_t, uint32_t>> relocations;
     if (m_crypter) {
         auto decrypter = m_crypter;
         memmoveDictionary(*m_dicCrypt, m_output, ptr, decrypter, encrypter, prepared);
@@ -1285,16 +1764,22 @@ bool MMKV::doFullWriteBack(pair<MMBuffer, size_t> prepared, AESCrypt *newCrypter
             encrypter->encrypt(ptr + Fixed32Size, ptr + Fixed32Size, totalSize);
         }
     } else {
-        memmoveDictionary(*m_dic, m_output, ptr, encrypter, totalSize);
+        needJournal = !encrypter && hasCompactionJournal();
+        unchangedSize = memmoveDictionary(*m_dic, m_output, ptr, encrypter, totalSize, needJournal ? &relocations : nullptr);
     }
 
     m_actualSize = totalSize;
     if (encrypter) {
-        recalculateCRCDigestWithIV(newIV);
+        recalculateCRCDigestWithIV(newIV, encrypter);
     } else {
-        recalculateCRCDigestWithIV(nullptr);
+        recalculateCRCDigestWithIV(nullptr, nullptr, unchangedSize);
+    }
+    if (needJournal) {
+        writeCompactionJournal(relocations, oldSequence, oldActualSize, oldCRCDigest);
     }
     m_hasFullWriteback = true;
+    adviseDataAccess(AccessHint::Normal, max(oldActualSize, totalSize));
+    adviseDataAccess(AccessHint::Random, m_actualSize);
     // make sure lastConfirmedMetaInfo is saved if needed
     if (needSync) {
         sync(MMKV_SYNC);
@@ -1307,20 +1792,34 @@ bool MMKV::doFullWriteBack(pair<MMBuffer, size_t> prepared, AESCrypt *newCrypter
 bool MMKV::doFullWriteBack(pair<MMBuffer, size_t> prepared, AESCrypt *, bool needSync) {
     auto ptr = (uint8_t *) m_file->getMemory();
     auto totalSize = prepared.second;
+    auto oldActualSize = m_actualSize;
+    auto oldCRCDigest = m_crcDigest;
+    auto oldSequence = m_metaInfo->m_sequence;
+    adviseDataAccess(AccessHint::Sequential, max(oldActualSize, totalSize));
 
+    detachSnapshots();
     delete m_output;
     m_output = new CodedOutputData(ptr + Fixed32Size, m_file->getFileSize() - Fixed32Size);
+    size_t unchangedSize = 0;
+    bool needJournal = false;
+    vector<pair<uint32_t, uint32_t>> relocations;
     if (prepared.first.length() != 0) {
         auto &preparedData = prepared.first;
         fullWriteBackWholeData(std::move(preparedData), totalSize, m_output);
     } else {
         constexpr AESCrypt *encrypter = nullptr;
-        memmoveDictionary(*m_dic, m_output, ptr, encrypter, totalSize);
+        needJournal = hasCompactionJournal();
+        unchangedSize = memmoveDictionary(*m_dic, m_output, ptr, encrypter, totalSize, needJournal ? &relocations : nullptr);
     }
 
     m_actualSize = totalSize;
-    recalculateCRCDigestWithIV(nullptr);
+    recalculateCRCDigestWithIV(nullptr, nullptr, unchangedSize);
+    if (needJournal) {
+        writeCompactionJournal(relocations, oldSequence, oldActualSize, oldCRCDigest);
+    }
     m_hasFullWriteback = true;
+    adviseDataAccess(AccessHint::Normal, max(oldActualSize, totalSize));
+    adviseDataAccess(AccessHint::Random, m_actualSize);
     // make sure lastConfirmedMetaInfo is saved if needed
     if (needSync) {
         sync(MMKV_SYNC);
@@ -1331,6 +1830,11 @@ bool MMKV::doFullWriteBack(pair<MMBuffer, size_t> prepared, AESCrypt *, bool nee
 
 #ifndef MMKV_DISABLE_CRYPT
 bool MMKV::reKey(const string &cryptKey) {
+    SCOPED_LOCK(m_lock);
+    return reKey(cryptKey, m_crypter ? m_crypter->cryptMode() : MMKVCryptCFB);
+}
+
+bool MMKV::reKey(const string &cryptKey, MMKVCryptMode mode) {
     if (isReadOnly()) {
         MMKVWarning("[%s] file readonly", m_mmapID.c_str());
         return false;
@@ -1343,16 +1847,28 @@ bool MMKV::reKey(const string &cryptKey) {
         return false;
     }
 
+    // the crypt mode is saved in meta flags, written together with the new IV by the full writeback
+    auto oldVersion = m_metaInfo->m_version;
+    auto oldFlags = m_metaInfo->m_flags;
+    if (cryptKey.length() > 0 && mode == MMKVCryptCTR) {
+        m_metaInfo->setFlag(MMKVMetaInfo::EnableCryptCTR);
+        if (m_metaInfo->m_version < MMKVVersionFlag) {
+            m_metaInfo->m_version = MMKVVersionFlag;
+        }
+    } else {
+        m_metaInfo->unsetFlag(MMKVMetaInfo::EnableCryptCTR);
+    }
+
     bool ret = false;
     if (m_crypter) {
         if (cryptKey.length() > 0) {
             string oldKey = this->cryptKey();
-            if (cryptKey == oldKey) {
+            if (cryptKey == oldKey && mode == m_crypter->cryptMode()) {
                 return true;
             } else {
-                // change encryption key
-                MMKVInfo("reKey with new aes key");
-                auto newCrypt = new AESCrypt(cryptKey.data(), cryptKey.length());
+                // change encryption key or mode
+                MMKVInfo("reKey with new aes key, crypt mode %u", mode);
+                auto newCrypt = new AESCrypt(cryptKey.data(), cryptKey.length(), nullptr, 0, mode);
                 m_hasFullWriteback = false;
                 ret = fullWriteback(newCrypt);
                 if (ret) {
@@ -1378,9 +1894,9 @@ bool MMKV::reKey(const string &cryptKey) {
     } else {
         if (cryptKey.length() > 0) {
             // transform plain text to encrypted text
-            MMKVInfo("reKey to a aes key");
+            MMKVInfo("reKey to a aes key, crypt mode %u", mode);
             m_hasFullWriteback = false;
-            auto newCrypt = new AESCrypt(cryptKey.data(), cryptKey.length());
+            auto newCrypt = new AESCrypt(cryptKey.data(), cryptKey.length(), nullptr, 0, mode);
             ret = fullWriteback(newCrypt);
             if (ret) {
                 m_crypter = newCrypt;
@@ -1396,7 +1912,15 @@ bool MMKV::reKey(const string &cryptKey) {
     }
     // m_dic or m_dicCrypt is not valid after reKey
     if (ret) {
-        clearMemoryCache();
+        if (m_metaInfo->m_flags != oldFlags && m_metaFile->isFileValid()) {
+            // an empty file is not written back at all, save the new crypt mode anyway
+            m_metaInfo->write(m_metaFile->getMemory());
+            m_metaFile->msync(MMKV_SYNC);
+        }
+        doClearMemoryCache();
+    } else {
+        m_metaInfo->m_version = oldVersion;
+        m_metaInfo->m_flags = oldFlags;
     }
     return ret;
 }
@@ -1437,6 +1961,7 @@ void MMKV::trim() {
 
     MMKVInfo("trimming %s from %zu to %zu, actualSize %zu", m_mmapID.c_str(), oldSize, fileSize, m_actualSize);
 
+    detachSnapshots();
     if (!m_file->truncate(fileSize)) {
         return;
     }
@@ -1467,6 +1992,7 @@ void MMKV::clearAll(bool keepSpace) {
         MMKVInfo("nothing to clear for [%s]", m_mmapID.c_str());
         return;
     }
+    detachSnapshots();
 
     if (!keepSpace) {
         m_file->truncate(m_expectedCapacity);
@@ -1485,7 +2011,7 @@ void MMKV::clearAll(bool keepSpace) {
 
     m_metaFile->msync(MMKV_SYNC);
 
-    clearMemoryCache(keepSpace);
+    doClearMemoryCache(keepSpace);
     loadFromFile();
 }
 
@@ -1511,6 +2037,13 @@ size_t MMKV::importFrom(MMKV *src) {
         return 0;
     }
 
+#ifndef MMKV_APPLE
+    if (src == this) {
+        // nothing would change
+        return count(true);
+    }
+    return importRecordsFrom(src);
+#else
     size_t count = 0;
     bool notAutoExpire = !m_enableKeyExpire;
     auto time = UInt32ToInt32((m_expiredInSeconds != ExpireNever) ? getCurrentTimeInSecond() + m_expiredInSeconds : ExpireNever);
@@ -1533,8 +2066,540 @@ size_t MMKV::importFrom(MMKV *src) {
 
     MMKVInfo("imported %llu from [%s] to [%s]", count, src->m_mmapID.c_str(), m_mmapID.c_str());
     return count;
+#endif
+}
+
+#ifndef MMKV_APPLE
+
+// an item to append, the value is in the format of this instance (with the expire date if it's enabled)
+struct MMKV::BatchItem {
+    string_view key;
+    MMBuffer value;
+    // the whole encoded record somewhere else, if it can be copied as it is
+    const uint8_t *record;
+    size_t recordSize;
+
+    static size_t encodedSize(size_t keyLength, size_t valueLength);
+};
+
+size_t MMKV::BatchItem::encodedSize(size_t keyLength, size_t valueLength) {
+    return keyLength + pbRawVarint32Size(static_cast<uint32_t>(keyLength)) + valueLength +
+           pbRawVarint32Size(static_cast<uint32_t>(valueLength));
+}
+
+// records are copied as they are if no encryption or expire date is involved
+size_t MMKV::importRecordsFrom(MMKV *src) {
+    auto srcBasePtr = (const uint8_t *) src->m_file->getMemory() + Fixed32Size;
+    auto now = getCurrentTimeInSecond();
+    auto time = (m_expiredInSeconds != ExpireNever) ? now + m_expiredInSeconds : ExpireNever;
+    bool copyRecord = !m_crypter && !src->m_crypter && !m_enableKeyExpire && !src->m_enableKeyExpire;
+
+    vector<BatchItem> items;
+    size_t totalSize = 0;
+    auto collect = [&](const string &key, MMBuffer &&raw, const uint8_t *record, size_t recordSize) {
+        if (src->m_enableKeyExpire && raw.length() >= Fixed32Size) {
+            auto newLength = raw.length() - Fixed32Size;
+            uint32_t expireTime = 0;
+            memcpy(&expireTime, (const uint8_t *) raw.getPtr() + newLength, Fixed32Size);
+            if (expireTime != ExpireNever && expireTime <= now) {
+                return;
+            }
+            raw = MMBuffer(std::move(raw), newLength);
+        }
+        if (raw.length() == 0) {
+            return;
+        }
+        if (m_enableKeyExpire) {
+            MMBuffer value(raw.length() + Fixed32Size);
+            memcpy(value.getPtr(), raw.getPtr(), raw.length());
+            memcpy((uint8_t *) value.getPtr() + raw.length(), &time, Fixed32Size);
+            raw = std::move(value);
+        }
+        totalSize += BatchItem::encodedSize(key.length(), raw.length());
+        items.push_back({key, std::move(raw), record, recordSize});
+    };
+#    ifndef MMKV_DISABLE_CRYPT
+    if (src->m_crypter) {
+        items.reserve(src->m_dicCrypt->size());
+        for (auto &itr : *src->m_dicCrypt) {
+            collect(itr.first, itr.second.toMMBuffer(srcBasePtr, src->m_crypter), nullptr, 0);
+        }
+    } else
+#    endif
+    {
+        items.reserve(src->m_dic->size());
+        for (auto &itr : *src->m_dic) {
+            auto &kvHolder = itr.second;
+            auto record = copyRecord ? srcBasePtr + kvHolder.offset : nullptr;
+            auto recordSize = static_cast<size_t>(kvHolder.computedKVSize) + kvHolder.valueSize;
+            collect(itr.first, kvHolder.toMMBuffer(srcBasePtr), record, recordSize);
+        }
+    }
+    auto count = appendBatch(items, totalSize);
+    MMKVInfo("imported %zu from [%s] to [%s]", count, src->m_mmapID.c_str(), m_mmapID.c_str());
+    return count;
+}
+
+// append the items at once, instead of space checking & checksumming & writing meta for each of them
+// return the count of items appended
+size_t MMKV::appendBatch(vector<BatchItem> &items, size_t totalSize) {
+    if (items.empty()) {
+        return 0;
+    }
+    if (!ensureMemorySize(totalSize) || !isFileValid()) {
+        return 0;
+    }
+    auto startSize = m_actualSize;
+#    ifndef MMKV_DISABLE_CRYPT
+    auto lazyDecrypt = isLazyDecrypt();
+    if (m_crypter) {
+        m_dicCrypt->reserve(m_dicCrypt->size() + items.size());
+    } else
+#    endif
+    {
+        m_dic->reserve(m_dic->size() + items.size());
+    }
+    size_t count = 0;
+    try {
+        for (auto &item : items) {
+            auto key = item.key;
+            auto offset = static_cast<uint32_t>(m_actualSize);
+            auto keyLength = static_cast<uint32_t>(key.length());
+            auto valueLength = static_cast<uint32_t>(item.value.length());
+#    ifndef MMKV_DISABLE_CRYPT
+            bool storeAsOffset = m_crypter && KeyValueHolderCrypt::isValueStoredAsOffset(valueLength, lazyDecrypt);
+            if (storeAsOffset) {
+                m_crypter->getCurStatus(t_status);
+            }
+#    endif
+            if (item.record) {
+                m_output->writeRawData(MMBuffer((void *) item.record, item.recordSize, MMBufferNoCopy));
+            } else {
+                m_output->writeData(MMBuffer((void *) key.data(), key.length(), MMBufferNoCopy));
+                m_output->writeData(item.value);
+            }
+            auto size = m_output->getPosition() - m_actualSize;
+#    ifndef MMKV_DISABLE_CRYPT
+            if (m_crypter) {
+                auto ptr = (uint8_t *) m_file->getMemory() + Fixed32Size + m_actualSize;
+                m_crypter->encrypt(ptr, ptr, size);
+                eraseDecryptedValue(key);
+                KeyValueHolderCrypt kvHolder;
+                if (storeAsOffset) {
+                    kvHolder = KeyValueHolderCrypt(keyLength, valueLength, offset);
+                    memcpy(&kvHolder.cryptStatus, &t_status, sizeof(t_status));
+                } else {
+                    kvHolder = KeyValueHolderCrypt(item.value.getPtr(), item.value.length());
+                }
+                auto itr = m_dicCrypt->find(key);
+                if (itr != m_dicCrypt->end()) {
+                    itr->second = std::move(kvHolder);
+                } else {
+                    m_dicCrypt->emplace(key, std::move(kvHolder));
+                }
+            } else
+#    endif
+            {
+                auto itr = m_dic->find(key);
+                if (itr != m_dic->end()) {
+                    itr->second = KeyValueHolder(keyLength, valueLength, offset);
+                } else {
+                    m_dic->emplace(key, KeyValueHolder(keyLength, valueLength, offset));
+                }
+            }
+            m_actualSize += size;
+            count++;
+        }
+    } catch (std::exception &e) {
+        MMKVError("%s", e.what());
+    } catch (...) {
+        MMKVError("import fail");
+    }
+
+    if (m_actualSize > startSize) {
+        updateCRCDigest((const uint8_t *) m_file->getMemory() + Fixed32Size + startSize, m_actualSize - startSize);
+        m_hasFullWriteback = false;
+        if (m_enableKeyExpire) {
+            clearExpireIndex();
+        }
+    }
+    return count;
+}
+
+// the stream of dumpTo() & loadFrom(), made of little-endian uint32s & raw bytes:
+// header: magic, version
+// record: key size (never 0), value size, expire date (ExpireNever if none), key, value, crc32 of all the above
+// end: 0, record count, crc32 of the two
+constexpr char StreamMagic[8] = {'M', 'M', 'K', 'V', 'D', 'U', 'M', 'P'};
+constexpr uint32_t StreamVersion = 1;
+constexpr uint32_t StreamMaxKeySize = UINT16_MAX;
+constexpr uint32_t StreamMaxValueSize = 1u << 30;
+// writes are gathered into chunks of that size
+constexpr size_t StreamChunkSize = 64 * 1024;
+// loaded items are appended in batches of about that size
+constexpr size_t StreamBatchSize = 1024 * 1024;
+
+class StreamDumpOutput {
+    const MMKV::StreamWriter &m_writer;
+    vector<uint8_t> m_buffer;
+    bool m_failed = false;
+
+public:
+    explicit StreamDumpOutput(const MMKV::StreamWriter &writer) : m_writer(writer) { m_buffer.reserve(StreamChunkSize); }
+
+    bool write(const void *ptr, size_t size) {
+        if (m_buffer.size() + size > StreamChunkSize) {
+            flush();
+            // large values don't need gathering
+            if (size >= StreamChunkSize) {
+                m_failed = m_failed || !m_writer(ptr, size);
+                return !m_failed;
+            }
+        }
+        auto bytes = (const uint8_t *) ptr;
+        m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+        return !m_failed;
+    }
+
+    bool flush() {
+        if (!m_buffer.empty()) {
+            m_failed = m_failed || !m_writer(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+        return !m_failed;
+    }
+};
+
+static bool readFully(const MMKV::StreamReader &reader, void *buffer, size_t size) {
+    auto ptr = (uint8_t *) buffer;
+    while (size > 0) {
+        auto bytes = reader(ptr, size);
+        if (bytes == 0 || bytes > size) {
+            return false;
+        }
+        ptr += bytes;
+        size -= bytes;
+    }
+    return true;
+}
+
+// the sizes of a record are not verified until its crc, the buffer only grows with what's actually read
+static bool readFullyInto(const MMKV::StreamReader &reader, vector<uint8_t> &buffer, size_t size) {
+    while (size > 0) {
+        auto chunkSize = min(size, StreamChunkSize);
+        auto offset = buffer.size();
+        buffer.resize(offset + chunkSize);
+        if (!readFully(reader, buffer.data() + offset, chunkSize)) {
+            return false;
+        }
+        size -= chunkSize;
+    }
+    return true;
+}
+
+// the uint32s of the stream are little-endian whatever the host is
+static void encodeLittleEndian(const uint32_t *values, size_t count, uint8_t *bytes) {
+    for (size_t index = 0; index < count; index++) {
+        for (uint32_t shift = 0; shift < 32; shift += 8) {
+            *bytes++ = static_cast<uint8_t>(values[index] >> shift);
+        }
+    }
+}
+
+static void decodeLittleEndian(const uint8_t *bytes, size_t count, uint32_t *values) {
+    for (size_t index = 0; index < count; index++) {
+        values[index] = 0;
+        for (uint32_t shift = 0; shift < 32; shift += 8) {
+            values[index] |= static_cast<uint32_t>(*bytes++) << shift;
+        }
+    }
+}
+
+static uint32_t streamRecordCRC(const uint8_t (&header)[3 * sizeof(uint32_t)], const void *ptr, size_t size) {
+    auto crc = static_cast<uint32_t>(CRC32(0, header, sizeof(header)));
+    return static_cast<uint32_t>(CRC32(crc, (const uint8_t *) ptr, size));
+}
+
+bool MMKV::dumpTo(const StreamWriter &writer) {
+    if (!writer) {
+        return false;
+    }
+    SCOPED_LOCK(m_lock);
+    SCOPED_LOCK(m_sharedProcessLock);
+    checkLoadData();
+    if (!isFileValid()) {
+        MMKVWarning("[%s] file not valid", m_mmapID.c_str());
+        return false;
+    }
+
+    StreamDumpOutput output(writer);
+    output.write(StreamMagic, sizeof(StreamMagic));
+    uint8_t versionBytes[sizeof(StreamVersion)];
+    encodeLittleEndian(&StreamVersion, 1, versionBytes);
+    output.write(versionBytes, sizeof(versionBytes));
+
+    auto basePtr = (const uint8_t *) m_file->getMemory() + Fixed32Size;
+    auto now = m_enableKeyExpire ? getCurrentTimeInSecond() : 0;
+    uint32_t count = 0;
+    bool oversized = false;
+    auto dumpOne = [&](const string &key, const MMBuffer &raw) {
+        auto valueSize = raw.length();
+        uint32_t expireTime = ExpireNever;
+        if (m_enableKeyExpire) {
+            if (valueSize < Fixed32Size) {
+                return true;
+            }
+            valueSize -= Fixed32Size;
+            memcpy(&expireTime, (const uint8_t *) raw.getPtr() + valueSize, Fixed32Size);
+            if (expireTime != ExpireNever && expireTime <= now) {
+                return true;
+            }
+        }
+        if (valueSize == 0) {
+            return true;
+        }
+        // loadFrom() would reject it
+        if (key.length() > StreamMaxKeySize || valueSize > StreamMaxValueSize) {
+            MMKVError("[%s] too large to dump, key size %zu, value size %zu", m_mmapID.c_str(), key.length(), valueSize);
+            oversized = true;
+            return false;
+        }
+        uint32_t header[3] = {static_cast<uint32_t>(key.length()), static_cast<uint32_t>(valueSize), expireTime};
+        uint8_t headerBytes[sizeof(header)];
+        encodeLittleEndian(header, 3, headerBytes);
+        auto crc = streamRecordCRC(headerBytes, key.data(), key.length());
+        crc = static_cast<uint32_t>(CRC32(crc, (const uint8_t *) raw.getPtr(), valueSize));
+        uint8_t crcBytes[sizeof(crc)];
+        encodeLittleEndian(&crc, 1, crcBytes);
+        count++;
+        return output.write(headerBytes, sizeof(headerBytes)) && output.write(key.data(), key.length()) &&
+               output.write(raw.getPtr(), valueSize) && output.write(crcBytes, sizeof(crcBytes));
+    };
+#    ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        for (const auto &itr : *m_dicCrypt) {
+            if (!dumpOne(itr.first, itr.second.toMMBuffer(basePtr, m_crypter))) {
+                break;
+            }
+        }
+    } else
+#    endif
+    {
+        for (const auto &itr : *m_dic) {
+            if (!dumpOne(itr.first, itr.second.toMMBuffer(basePtr))) {
+                break;
+            }
+        }
+    }
+    // without the end, the stream reads as a truncated one
+    if (!oversized) {
+        uint32_t end[3] = {0, count, 0};
+        uint8_t endBytes[sizeof(end)];
+        encodeLittleEndian(end, 2, endBytes);
+        end[2] = static_cast<uint32_t>(CRC32(0, endBytes, sizeof(uint32_t) * 2));
+        encodeLittleEndian(end, 3, endBytes);
+        output.write(endBytes, sizeof(endBytes));
+    }
+
+    auto ret = output.flush() && !oversized;
+    MMKVInfo("dumped %u items of [%s], ret %d", count, m_mmapID.c_str(), ret);
+    return ret;
 }
 
+bool MMKV::loadFrom(const StreamReader &reader, size_t *loadedCount) {
+    if (loadedCount) {
+        *loadedCount = 0;
+    }
+    if (!reader) {
+        return false;
+    }
+    if (isReadOnly()) {
+        MMKVWarning("[%s] file readonly", m_mmapID.c_str());
+        return false;
+    }
+    char magic[sizeof(StreamMagic)];
+    uint8_t versionBytes[sizeof(StreamVersion)];
+    uint32_t version = 0;
+    auto valid = readFully(reader, magic, sizeof(magic)) && memcmp(magic, StreamMagic, sizeof(magic)) == 0 &&
+                 readFully(reader, versionBytes, sizeof(versionBytes));
+    if (valid) {
+        decodeLittleEndian(versionBytes, 1, &version);
+        valid = (version > 0 && version <= StreamVersion);
+    }
+    if (!valid) {
+        MMKVError("[%s] not a valid stream to load, version %u", m_mmapID.c_str(), version);
+        return false;
+    }
+
+    // key, value & a spare room for the expire date of each record, one batch at a time
+    struct PendingRecord {
+        size_t offset;
+        uint32_t keySize;
+        uint32_t valueSize;
+        uint32_t expireTime;
+    };
+    vector<uint8_t> arena;
+    vector<PendingRecord> pending;
+    size_t count = 0;
+    // the reader is never called with the lock held
+    auto flushPending = [&] {
+        SCOPED_LOCK(m_lock);
+        SCOPED_LOCK(m_exclusiveProcessLock);
+        checkLoadData();
+
+        auto now = getCurrentTimeInSecond();
+        auto defaultTime = (m_expiredInSeconds != ExpireNever) ? now + m_expiredInSeconds : ExpireNever;
+        vector<BatchItem> items;
+        items.reserve(pending.size());
+        size_t totalSize = 0;
+        for (auto &record : pending) {
+            if (record.expireTime != ExpireNever && record.expireTime <= now) {
+                continue;
+            }
+            auto keyPtr = arena.data() + record.offset;
+            auto valuePtr = keyPtr + record.keySize;
+            size_t valueSize = record.valueSize;
+            if (m_enableKeyExpire) {
+                auto time = (record.expireTime != ExpireNever) ? record.expireTime : defaultTime;
+                memcpy(valuePtr + valueSize, &time, Fixed32Size);
+                valueSize += Fixed32Size;
+            }
+            totalSize += BatchItem::encodedSize(record.keySize, valueSize);
+            items.push_back({string_view((const char *) keyPtr, record.keySize), MMBuffer(valuePtr, valueSize, MMBufferNoCopy), nullptr, 0});
+        }
+        auto appended = appendBatch(items, totalSize);
+        count += appended;
+        arena.clear();
+        pending.clear();
+        return appended == items.size();
+    };
+
+    bool ret = false;
+    uint32_t recordCount = 0;
+    while (true) {
+        uint8_t headerBytes[3 * sizeof(uint32_t)];
+        if (!readFully(reader, headerBytes, sizeof(headerBytes))) {
+            MMKVError("[%s] stream truncated after %u records", m_mmapID.c_str(), recordCount);
+            break;
+        }
+        uint32_t header[3];
+        decodeLittleEndian(headerBytes, 3, header);
+        auto keySize = header[0], valueSize = header[1];
+        if (keySize == 0) {
+            auto crc = static_cast<uint32_t>(CRC32(0, headerBytes, sizeof(uint32_t) * 2));
+            ret = (header[1] == recordCount && header[2] == crc);
+            if (!ret) {
+                MMKVError("[%s] stream end mismatch, %u records, expected %u", m_mmapID.c_str(), recordCount, header[1]);
+            }
+            break;
+        }
+        if (keySize > StreamMaxKeySize || valueSize == 0 || valueSize > StreamMaxValueSize) {
+            MMKVError("[%s] invalid stream record, key size %u, value size %u", m_mmapID.c_str(), keySize, valueSize);
+            break;
+        }
+        auto offset = arena.size();
+        uint8_t crcBytes[sizeof(uint32_t)];
+        if (!readFullyInto(reader, arena, keySize + valueSize) || !readFully(reader, crcBytes, sizeof(crcBytes))) {
+            MMKVError("[%s] stream truncated after %u records", m_mmapID.c_str(), recordCount);
+            arena.resize(offset);
+            break;
+        }
+        uint32_t crc = 0;
+        decodeLittleEndian(crcBytes, 1, &crc);
+        if (crc != streamRecordCRC(headerBytes, arena.data() + offset, keySize + valueSize)) {
+            MMKVError("[%s] stream record crc mismatch after %u records", m_mmapID.c_str(), recordCount);
+            arena.resize(offset);
+            break;
+        }
+        arena.resize(arena.size() + Fixed32Size);
+        recordCount++;
+        pending.push_back({offset, keySize, valueSize, header[2]});
+        if (arena.size() >= StreamBatchSize && !flushPending()) {
+            break;
+        }
+    }
+    // records before a broken one are kept
+    if (!pending.empty() && !flushPending()) {
+        ret = false;
+    }
+
+    if (loadedCount) {
+        *loadedCount = count;
+    }
+    MMKVInfo("loaded %zu items into [%s], ret %d", count, m_mmapID.c_str(), ret);
+    return ret;
+}
+
+bool MMKV::changesSince(ChangeCursor &cursor, const ChangeVisitor &visitor) {
+    SCOPED_LOCK(m_lock);
+    SCOPED_LOCK(m_sharedProcessLock);
+    checkLoadData();
+    if (!isFileValid()) {
+        MMKVWarning("[%s] file not valid", m_mmapID.c_str());
+        return false;
+    }
+
+    // the log is only appended within a sequence, anything else rewrites it
+    auto sequence = m_metaInfo->m_sequence;
+    if (cursor.offset > 0 && (cursor.sequence != sequence || cursor.offset > m_actualSize)) {
+        MMKVInfo("[%s] cursor (%u, %u) invalidated by sequence %u, actualSize %zu", m_mmapID.c_str(),
+                 cursor.sequence, cursor.offset, sequence, m_actualSize);
+        cursor = {sequence, 0};
+        return false;
+    }
+    cursor.sequence = sequence;
+    if (!visitor || cursor.offset >= m_actualSize) {
+        return true;
+    }
+
+    size_t offset = cursor.offset;
+    auto basePtr = (uint8_t *) m_file->getMemory() + Fixed32Size;
+    MMBuffer inputBuffer(basePtr + offset, m_actualSize - offset, MMBufferNoCopy);
+#ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        AESCryptStatus status;
+        m_crypter->statusAtPosition(offset, status, basePtr);
+        auto decrypter = m_crypter->cloneWithStatus(status);
+        MMBuffer decryptedBuffer(inputBuffer.length());
+        decrypter.decrypt(inputBuffer.getPtr(), decryptedBuffer.getPtr(), inputBuffer.length());
+        inputBuffer = std::move(decryptedBuffer);
+    }
+#endif
+    size_t count = 0;
+    try {
+        CodedInputData input(inputBuffer.getPtr(), inputBuffer.length());
+        if (offset == 0) {
+            // the item size holder
+            input.readInt32();
+            cursor.offset = static_cast<uint32_t>(input.getPosition());
+        }
+        KeyValueHolder kvHolder;
+        string_view key;
+        while (!input.isAtEnd() && input.readKeyValueHolder(kvHolder, key)) {
+            auto valueSize = kvHolder.valueSize;
+            auto valuePtr = (uint8_t *) inputBuffer.getPtr() + kvHolder.offset + kvHolder.computedKVSize;
+            if (m_enableKeyExpire && valueSize >= Fixed32Size) {
+                valueSize -= Fixed32Size;
+            }
+            // an empty value is a removal
+            MMBuffer value(valuePtr, valueSize, MMBufferNoCopy);
+            cursor.offset = static_cast<uint32_t>(offset + input.getPosition());
+            if (!key.empty()) {
+                count++;
+                if (!visitor(string(key), value)) {
+                    break;
+                }
+            }
+        }
+    } catch (std::exception &exception) {
+        MMKVError("%s", exception.what());
+    }
+    MMKVDebug("[%s] visited %zu changes, cursor (%u, %u)", m_mmapID.c_str(), count, cursor.sequence, cursor.offset);
+    return true;
+}
+
+#endif // !MMKV_APPLE
+
 static std::pair<MMKVPath_t, MMKVPath_t> getStorage(const std::string &mmapID, const MMKVPath_t *relatePath, std::string& realID, std::string& mmapKey) {
 #ifdef MMKV_ANDROID
     auto migrateStatus = tryMigrateLegacyMMKVFile(mmapID, relatePath);
@@ -1633,6 +2698,7 @@ bool MMKV::removeStorage(const std::string &mmapID, const MMKVPath_t *relatePath
         return false;
     }
     MMKVInfo("remove storage [%s]", realID.c_str());
+    waitForIdleInstancePath(kvPath);
 
     if (crcPath.empty()) {
         deleteFile(kvPath);
@@ -1656,6 +2722,10 @@ bool MMKV::removeStorage(const std::string &mmapID, const MMKVPath_t *relatePath
 
     deleteFile(kvPath);
     deleteFile(crcPath);
+    auto journalPath = compactionJournalPathWithPath(kvPath);
+    if (isFileExist(journalPath)) {
+        deleteFile(journalPath);
+    }
 
     return true;
 }
@@ -1687,6 +2757,7 @@ bool MMKV::doFullWriteBack(MMKVVector &&vec) {
     } else {
         clearDictionary(m_dic);
     }
+    clearExpireIndex();
 
     bool ret = false;
     auto sizeOfDic = preparedData.second;
@@ -1699,7 +2770,7 @@ bool MMKV::doFullWriteBack(MMKVVector &&vec) {
         ret = expandAndWriteBack(newSize, std::move(preparedData));
     }
 
-    clearMemoryCache();
+    doClearMemoryCache();
     return ret;
 }
 
@@ -1734,7 +2805,9 @@ bool MMKV::enableAutoKeyExpire(uint32_t expiredInSeconds) {
     auto time = autoRecordExpireTime ? getCurrentTimeInSecond() + m_expiredInSeconds : 0;
     MMKVInfo("turn on recording expire date for all keys inside [%s] from now %u", m_mmapID.c_str(), time);
     m_metaInfo->setFlag(MMKVMetaInfo::EnableKeyExipre);
-    m_metaInfo->m_version = MMKVVersionFlag;
+    if (m_metaInfo->m_version < MMKVVersionFlag) {
+        m_metaInfo->m_version = MMKVVersionFlag;
+    }
 
     if (m_file->getFileSize() == m_expectedCapacity && m_actualSize == 0) {
         MMKVInfo("file is new, don't need a full writeback [%s], just update meta file", m_mmapID.c_str());
@@ -1796,7 +2869,9 @@ bool MMKV::disableAutoKeyExpire() {
 
     MMKVInfo("erase previous recorded expire date for all keys inside [%s]", m_mmapID.c_str());
     m_metaInfo->unsetFlag(MMKVMetaInfo::EnableKeyExipre);
-    m_metaInfo->m_version = MMKVVersionFlag;
+    if (m_metaInfo->m_version < MMKVVersionFlag) {
+        m_metaInfo->m_version = MMKVVersionFlag;
+    }
 
     if (m_file->getFileSize() == m_expectedCapacity && m_actualSize == 0) {
         MMKVInfo("file is new, don't need a full write-back [%s], just update meta file", m_mmapID.c_str());
@@ -1913,10 +2988,27 @@ size_t MMKV::filterExpiredKeys() {
     SCOPED_LOCK(m_sharedProcessLock);
 
     auto now = getCurrentTimeInSecond();
-    MMKVInfo("filtering expired keys inside [%s] now: %u, m_expiredInSeconds: %u", m_mmapID.c_str(), now,
-             m_expiredInSeconds);
+    MMKVDebug("filtering expired keys inside [%s] now: %u, m_expiredInSeconds: %u", m_mmapID.c_str(), now,
+              m_expiredInSeconds);
 
     size_t count = 0;
+#ifndef MMKV_APPLE
+    string key;
+    uint32_t time = 0;
+    while (popExpiredKey(now, key, time)) {
+#    ifndef MMKV_DISABLE_CRYPT
+        if (m_crypter) {
+            eraseDecryptedValue(key);
+            m_dicCrypt->erase(m_dicCrypt->find(key));
+        } else
+#    endif
+        {
+            m_dic->erase(m_dic->find(key));
+        }
+        MMKVInfo("deleting expired key [%s], due date %u", key.c_str(), time);
+        count++;
+    }
+#else
     auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
 #ifndef MMKV_DISABLE_CRYPT
     if (m_crypter) {
@@ -1983,12 +3075,168 @@ size_t MMKV::filterExpiredKeys() {
             }
         }
     }
+#endif // !MMKV_APPLE
     if (count != 0) {
         MMKVInfo("deleted %zu expired keys inside [%s]", count, m_mmapID.c_str());
     }
     return count;
 }
 
+void MMKV::clearExpireIndex() {
+#ifndef MMKV_APPLE
+    m_expireIndex.clear();
+    m_expireIndexValid = false;
+#endif
+}
+
+bool MMKV::isLazyDecrypt() const {
+#ifndef MMKV_APPLE
+    return m_valueCache != nullptr;
+#else
+    return false;
+#endif
+}
+
+void MMKV::eraseDecryptedValue(MMKVKey_t key) {
+#ifndef MMKV_APPLE
+    if (m_valueCache) {
+        m_valueCache->erase(key);
+    }
+#else
+    unused(key);
+#endif
+}
+
+void MMKV::clearDecryptedValueCache() {
+#ifndef MMKV_APPLE
+    if (m_valueCache) {
+        m_valueCache->clear();
+    }
+#endif
+}
+
+#ifndef MMKV_DISABLE_CRYPT
+MMBuffer MMKV::decryptValue(MMKVKey_t key, const KeyValueHolderCrypt &kvHolder, const uint8_t *basePtr) {
+#    ifndef MMKV_APPLE
+    // values kept in memory are cheap enough
+    if (m_valueCache && kvHolder.type == KeyValueHolderType_Offset) {
+        bool found = false;
+        auto data = m_valueCache->get(key, found);
+        if (!found) {
+            data = kvHolder.toMMBuffer(basePtr, m_crypter);
+            m_valueCache->put(key, data);
+        }
+        return data;
+    }
+#    else
+    unused(key);
+#    endif
+    return kvHolder.toMMBuffer(basePtr, m_crypter);
+}
+#endif // MMKV_DISABLE_CRYPT
+
+#ifndef MMKV_APPLE
+
+// drop the index if stale entries pile up, e.g. the same keys been renewed again and again
+constexpr size_t ExpireIndexMinRebuildSize = 1024;
+
+void MMKV::buildExpireIndex() {
+    m_expireIndex.clear();
+    auto indexKey = [this](const string &key, const uint8_t *value, size_t length) {
+        if (length < Fixed32Size) {
+            MMKVWarning("key [%s] has invalid value size %zu", key.c_str(), length);
+            return;
+        }
+        uint32_t time = 0;
+        memcpy(&time, value + length - Fixed32Size, Fixed32Size);
+        if (time != ExpireNever) {
+            m_expireIndex.emplace_back(time, key);
+        }
+    };
+
+    auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
+#    ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        for (const auto &itr : *m_dicCrypt) {
+            auto buffer = itr.second.toMMBuffer(basePtr, m_crypter);
+            indexKey(itr.first, (const uint8_t *) buffer.getPtr(), buffer.length());
+        }
+    } else
+#    endif
+    {
+        for (const auto &itr : *m_dic) {
+            auto &kvHolder = itr.second;
+            indexKey(itr.first, basePtr + kvHolder.offset + kvHolder.computedKVSize, kvHolder.valueSize);
+        }
+    }
+    make_heap(m_expireIndex.begin(), m_expireIndex.end(), std::greater<>());
+    m_expireIndexValid = true;
+    MMKVInfo("built expire index of [%s] with %zu keys", m_mmapID.c_str(), m_expireIndex.size());
+}
+
+void MMKV::indexExpireTime(MMKVKey_t key, const MMBuffer &data) {
+    if (!m_expireIndexValid || data.length() < Fixed32Size) {
+        return;
+    }
+    uint32_t time = 0;
+    memcpy(&time, (const uint8_t *) data.getPtr() + data.length() - Fixed32Size, Fixed32Size);
+    if (time == ExpireNever) {
+        return;
+    }
+    auto dicSize = m_crypter ? m_dicCrypt->size() : m_dic->size();
+    if (m_expireIndex.size() >= ExpireIndexMinRebuildSize && m_expireIndex.size() > dicSize * 2) {
+        clearExpireIndex();
+        return;
+    }
+    m_expireIndex.emplace_back(time, key);
+    push_heap(m_expireIndex.begin(), m_expireIndex.end(), std::greater<>());
+}
+
+bool MMKV::getExpireTimeInDictionary(string_view key, uint32_t &time) {
+    auto basePtr = (uint8_t *) (m_file->getMemory()) + Fixed32Size;
+    MMBuffer raw;
+#    ifndef MMKV_DISABLE_CRYPT
+    if (m_crypter) {
+        auto itr = m_dicCrypt->find(key);
+        if (itr == m_dicCrypt->end()) {
+            return false;
+        }
+        raw = itr->second.toMMBuffer(basePtr, m_crypter);
+    } else
+#    endif
+    {
+        auto itr = m_dic->find(key);
+        if (itr == m_dic->end()) {
+            return false;
+        }
+        raw = itr->second.toMMBuffer(basePtr);
+    }
+    if (raw.length() < Fixed32Size) {
+        return false;
+    }
+    memcpy(&time, (const uint8_t *) raw.getPtr() + raw.length() - Fixed32Size, Fixed32Size);
+    return true;
+}
+
+bool MMKV::popExpiredKey(uint32_t now, string &key, uint32_t &time) {
+    if (!m_expireIndexValid) {
+        buildExpireIndex();
+    }
+    while (!m_expireIndex.empty() && m_expireIndex.front().first <= now) {
+        pop_heap(m_expireIndex.begin(), m_expireIndex.end(), std::greater<>());
+        auto entry = std::move(m_expireIndex.back());
+        m_expireIndex.pop_back();
+        // skip the key if it has been removed or updated since then
+        if (getExpireTimeInDictionary(entry.second, time) && time == entry.first) {
+            key = std::move(entry.second);
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // !MMKV_APPLE
+
 bool MMKV::enableCompareBeforeSet() {
     MMKVInfo("enableCompareBeforeSet for [%s]", m_mmapID.c_str());
     SCOPED_LOCK(m_lock);
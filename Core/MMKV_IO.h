@@ -34,6 +34,11 @@ MMKVPath_t mappedKVPathWithID(const std::string &mmapID, const MMKVPath_t *rootP
 MMKVPath_t mappedKVPathWithID(const std::string &mmapID, const MMKVPath_t *rootPath, MMKVMode mode = MMKV_MULTI_PROCESS);
 #endif
 MMKVPath_t crcPathWithPath(const MMKVPath_t &kvPath);
+// where a multi-process instance tells the others how the items are moved by the last compaction
+MMKVPath_t compactionJournalPathWithPath(const MMKVPath_t &kvPath);
+
+// wait until the file is not being backed up, restored or swept, g_instanceLock must be held
+void waitForIdleInstancePath(const MMKVPath_t &path);
 
 MMKVRecoverStrategic onMMKVCRCCheckFail(const std::string &mmapID);
 MMKVRecoverStrategic onMMKVFileLengthError(const std::string &mmapID);
@@ -45,6 +45,16 @@ namespace mmkv {
 
 static bool getFileSize(const char *path, size_t &size);
 
+#    ifdef MMKV_LINUX
+static inline bool isMemfdFile(const File &file) {
+    return file.m_isMemfd;
+}
+#    else
+static inline bool isMemfdFile(const File &) {
+    return false;
+}
+#    endif
+
 #    ifdef MMKV_ANDROID
 extern size_t ASharedMemory_getSize(int fd);
 #    else
@@ -54,10 +64,36 @@ File::File(MMKVPath_t path, OpenFlag flag) : m_path(std::move(path)), m_fd(-1),
 
 MemoryFile::MemoryFile(MMKVPath_t path, size_t expectedCapacity, bool readOnly, bool mayflyFD)
     : m_diskFile(std::move(path), readOnly ? OpenFlag::ReadOnly : (OpenFlag::ReadWrite | OpenFlag::Create))
-    , m_ptr(nullptr), m_size(0), m_readOnly(readOnly), m_isMayflyFD(mayflyFD)
+    , m_ptr(nullptr), m_size(0), m_readOnly(readOnly), m_isMayflyFD(mayflyFD), m_trackDirty(false), m_hugePage(false)
+    , m_backend(StorageBackend::MMap), m_pendingWriteBack(0)
 {
     reloadFromFile(expectedCapacity);
 }
+
+#        ifdef MMKV_LINUX
+File::File(MMKVFileHandle_t memfd) : m_path(), m_fd(memfd), m_flag(OpenFlag::ReadWrite), m_isMemfd(true) {
+    if (isFileValid()) {
+        // something like "/memfd:name (deleted)", for logging only
+        char path[PATH_MAX] = {};
+        auto link = "/proc/self/fd/" + to_string(m_fd);
+        if (::readlink(link.c_str(), path, sizeof(path) - 1) > 0) {
+            m_path = path;
+        }
+    }
+}
+
+MemoryFile::MemoryFile(MMKVFileHandle_t memfd)
+    : m_diskFile(memfd)
+    , m_ptr(nullptr), m_size(0), m_readOnly(false), m_isMayflyFD(false), m_trackDirty(false), m_hugePage(false)
+    , m_backend(StorageBackend::MMap), m_pendingWriteBack(0)
+{
+    if (!m_diskFile.isFileValid()) {
+        MMKVError("memfd %d invalid", memfd);
+    } else {
+        reloadFromFile();
+    }
+}
+#        endif // MMKV_LINUX
 #    endif // !defined(MMKV_ANDROID)
 
 #    ifdef MMKV_IOS
@@ -183,6 +219,11 @@ bool MemoryFile::truncate(size_t size, FileLock *fileLock) {
     }
 #    endif // MMKV_ANDROID
 
+    if (isMemfdFile(m_diskFile) && size < m_size) {
+        MMKVInfo("no way to trim memfd %s from %zu to smaller size %zu", m_diskFile.m_path.c_str(), m_size, size);
+        return false;
+    }
+
     auto oldSize = m_size;
     m_size = size;
     // round up to (n * pagesize)
@@ -195,7 +236,8 @@ bool MemoryFile::truncate(size_t size, FileLock *fileLock) {
         m_size = oldSize;
         return false;
     }
-    if (m_size > oldSize) {
+    // the expanded part of a memfd reads as zero without taking any memory
+    if (m_size > oldSize && !isMemfdFile(m_diskFile)) {
         if (!zeroFillFile(m_diskFile.m_fd, oldSize, m_size - oldSize)) {
             MMKVError("fail to zeroFile [%s] to size %zu, %s", m_diskFile.m_path.c_str(), m_size, strerror(errno));
             m_size = oldSize;
@@ -213,6 +255,20 @@ bool MemoryFile::truncate(size_t size, FileLock *fileLock) {
         }
     }
 
+    if (m_backend == StorageBackend::Buffered && m_ptr) {
+        // resize the buffer in place, what's not written back yet is kept
+        auto ptr = realloc(m_ptr, m_size);
+        if (!ptr) {
+            MMKVError("fail to realloc [%s] to size %zu", m_diskFile.m_path.c_str(), m_size);
+            m_size = oldSize;
+            return false;
+        }
+        m_ptr = ptr;
+        if (m_size > oldSize) {
+            memset((uint8_t *) m_ptr + oldSize, 0, m_size - oldSize);
+        }
+        return true;
+    }
     if (m_ptr) {
         if (munmap(m_ptr, oldSize) != 0) {
             MMKVError("fail to munmap [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
@@ -226,28 +282,129 @@ bool MemoryFile::msync(SyncFlag syncFlag) {
         // there's no point in msync() readonly memory
         return true;
     }
+    if (m_backend == StorageBackend::Buffered) {
+        if (!m_ptr || !writeBack()) {
+            return false;
+        }
+        // what's written back is in the page cache now, which is as far as msync(MS_ASYNC) goes
+        if (syncFlag == MMKV_SYNC && openIfNeeded() && ::fdatasync(m_diskFile.m_fd) != 0) {
+            MMKVError("fail to fdatasync [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+            return false;
+        }
+        return true;
+    }
     if (m_ptr) {
-        auto ret = ::msync(m_ptr, m_size, syncFlag ? MS_SYNC : MS_ASYNC);
-        if (ret == 0) {
-            return true;
+        auto ranges = getSyncRanges(syncFlag);
+#    ifdef MMKV_LINUX
+        // msync(MS_ASYNC) is a no-op on Linux, start writing back the dirty pages without waiting for it
+        if (syncFlag == MMKV_ASYNC && !ranges.empty() && openIfNeeded()) {
+            bool ret = true;
+            for (auto &range : ranges) {
+                if (::sync_file_range(m_diskFile.m_fd, static_cast<off_t>(range.first), static_cast<off_t>(range.second),
+                                      SYNC_FILE_RANGE_WRITE) != 0) {
+                    MMKVWarning("fail to sync_file_range [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+                    ret = false;
+                    break;
+                }
+            }
+            cleanMayflyFD();
+            if (ret) {
+                onSyncFinished(syncFlag);
+                return true;
+            }
+        }
+        if (syncFlag == MMKV_SYNC && ranges.size() > 1) {
+            // every msync(MS_SYNC) ends up with a journal commit on Linux, while the clean pages in between are
+            // skipped cheaply, so one call over the whole span is faster
+            auto end = ranges.back().first + ranges.back().second;
+            ranges.assign(1, {ranges.front().first, end - ranges.front().first});
         }
-        MMKVError("fail to msync [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+#    endif
+        for (auto &range : ranges) {
+            if (::msync((char *) m_ptr + range.first, range.second, syncFlag ? MS_SYNC : MS_ASYNC) != 0) {
+                MMKVError("fail to msync [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+                return false;
+            }
+        }
+        onSyncFinished(syncFlag);
+        return true;
     }
     return false;
 }
 
+#    ifdef MADV_HUGEPAGE
+static size_t hugePageSize() {
+    static const size_t size = [] {
+        size_t result = 2 * 1024 * 1024;
+        if (auto file = fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r")) {
+            unsigned long long value = 0;
+            if (fscanf(file, "%llu", &value) == 1 && value >= DEFAULT_MMAP_SIZE) {
+                result = static_cast<size_t>(value);
+            }
+            fclose(file);
+        }
+        return result;
+    }();
+    return size;
+}
+
+// reserve [size] bytes of address space starting at a multiple of [alignment]
+static void *reserveAlignedAddress(size_t size, size_t alignment) {
+    auto ptr = (uint8_t *) ::mmap(nullptr, size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    auto aligned = (uint8_t *) roundUp<uintptr_t>((uintptr_t) ptr, alignment);
+    if (aligned > ptr) {
+        ::munmap(ptr, aligned - ptr);
+    }
+    auto end = ptr + size + alignment;
+    if (end > aligned + size) {
+        ::munmap(aligned + size, end - (aligned + size));
+    }
+    return aligned;
+}
+#    endif // MADV_HUGEPAGE
+
 bool MemoryFile::mmapOrCleanup(FileLock *fileLock) {
+    if (m_backend == StorageBackend::Buffered) {
+        return readOrCleanup(fileLock);
+    }
     auto oldPtr = m_ptr;
     auto mode = m_readOnly ? PROT_READ : (PROT_READ | PROT_WRITE);
-    m_ptr = (char *) ::mmap(m_ptr, m_size, mode, MAP_SHARED, m_diskFile.m_fd, 0);
+    auto flags = MAP_SHARED;
+#    ifdef MADV_HUGEPAGE
+    void *reserved = nullptr;
+    if (m_hugePage) {
+        // a file page can only be mapped as part of a huge page if the address is aligned the same as the file offset
+        reserved = reserveAlignedAddress(m_size, hugePageSize());
+        if (reserved) {
+            m_ptr = reserved;
+            flags |= MAP_FIXED;
+        }
+    }
+#    endif
+    m_ptr = (char *) ::mmap(m_ptr, m_size, mode, flags, m_diskFile.m_fd, 0);
     if (m_ptr == MAP_FAILED) {
         MMKVError("fail to mmap [%s], mode 0x%x, %s", m_diskFile.m_path.c_str(), mode, strerror(errno));
         m_ptr = nullptr;
+#    ifdef MADV_HUGEPAGE
+        if (reserved) {
+            ::munmap(reserved, m_size);
+        }
+#    endif
 
         doCleanMemoryCache(true);
         return false;
     }
     MMKVInfo("mmap to address [%p], oldPtr [%p], [%s]", m_ptr, oldPtr, m_diskFile.m_path.c_str());
+#    ifdef MADV_HUGEPAGE
+    if (m_hugePage && ::madvise(m_ptr, m_size, MADV_HUGEPAGE) != 0) {
+        MMKVWarning("fail to madvise huge page [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+    }
+#    endif
+    m_dirtyRanges.add(0, m_size);
+    m_flushingRanges.clear();
 
     if (m_isMayflyFD && fileLock) {
         fileLock->destroyAndUnLock();
@@ -257,6 +414,114 @@ bool MemoryFile::mmapOrCleanup(FileLock *fileLock) {
     return true;
 }
 
+// the fd is kept open for writing back, no matter it's mayfly or not
+bool MemoryFile::readOrCleanup(FileLock *) {
+    auto ptr = (uint8_t *) malloc(m_size);
+    if (!ptr) {
+        MMKVError("fail to malloc %zu bytes for [%s]", m_size, m_diskFile.m_path.c_str());
+        m_ptr = nullptr;
+        doCleanMemoryCache(true);
+        return false;
+    }
+    size_t offset = 0;
+    while (offset < m_size) {
+        auto sizeRead = ::pread(m_diskFile.m_fd, ptr + offset, m_size - offset, static_cast<off_t>(offset));
+        if (sizeRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sizeRead <= 0) {
+            MMKVError("fail to pread [%s] at %zu, %s", m_diskFile.m_path.c_str(), offset,
+                      sizeRead < 0 ? strerror(errno) : "unexpected end of file");
+            free(ptr);
+            m_ptr = nullptr;
+            doCleanMemoryCache(true);
+            return false;
+        }
+        offset += static_cast<size_t>(sizeRead);
+    }
+    m_ptr = ptr;
+    MMKVInfo("read %zu bytes into buffer [%p], [%s]", m_size, m_ptr, m_diskFile.m_path.c_str());
+    // the buffer is the same as the file
+    m_dirtyRanges.clear();
+    m_flushingRanges.clear();
+    m_pendingWriteBack = 0;
+    return true;
+}
+
+bool MemoryFile::writeBack() {
+    m_pendingWriteBack = 0;
+    if (!m_ptr || m_readOnly) {
+        return false;
+    }
+    auto ranges = getSyncRanges(MMKV_SYNC);
+    if (ranges.empty()) {
+        return true;
+    }
+    if (!openIfNeeded()) {
+        return false;
+    }
+    for (auto &range : ranges) {
+        auto ptr = (const uint8_t *) m_ptr + range.first;
+        size_t written = 0;
+        while (written < range.second) {
+            auto sizeWrite = ::pwrite(m_diskFile.m_fd, ptr + written, range.second - written,
+                                      static_cast<off_t>(range.first + written));
+            if (sizeWrite < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sizeWrite < 0) {
+                MMKVError("fail to pwrite [%s] at %zu, %s", m_diskFile.m_path.c_str(), range.first + written, strerror(errno));
+                return false;
+            }
+            written += static_cast<size_t>(sizeWrite);
+        }
+    }
+    m_dirtyRanges.clear();
+    m_flushingRanges.clear();
+    return true;
+}
+
+void MemoryFile::releaseMemory() {
+    if (m_backend == StorageBackend::Buffered) {
+        if (m_ptr) {
+            if (!m_readOnly) {
+                writeBack();
+            }
+            free(m_ptr);
+        }
+    } else if (m_ptr && m_ptr != MAP_FAILED) {
+        if (munmap(m_ptr, m_size) != 0) {
+            MMKVError("fail to munmap [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+        }
+    }
+    m_ptr = nullptr;
+}
+
+bool MemoryFile::setBackend(StorageBackend backend) {
+    if (backend == m_backend) {
+        return true;
+    }
+    if (isMemfdFile(m_diskFile)) {
+        return false;
+    }
+#    ifdef MMKV_ANDROID
+    if (m_diskFile.m_fileType == MMFILE_TYPE_ASHMEM) {
+        return false;
+    }
+#    endif
+    auto loaded = (m_ptr != nullptr);
+    releaseMemory();
+    m_backend = backend;
+    if (!loaded) {
+        return true;
+    }
+    if (!openIfNeeded()) {
+        doCleanMemoryCache(true);
+        return false;
+    }
+    return mmapOrCleanup(nullptr);
+}
+
 void MemoryFile::reloadFromFile(size_t expectedCapacity) {
 #    ifdef MMKV_ANDROID
     if (m_fileType == MMFILE_TYPE_ASHMEM) {
@@ -301,17 +566,93 @@ void MemoryFile::doCleanMemoryCache(bool forceClean) {
         return;
     }
 #    endif
-    if (m_ptr && m_ptr != MAP_FAILED) {
-        if (munmap(m_ptr, m_size) != 0) {
-            MMKVError("fail to munmap [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
-        }
-    }
-    m_ptr = nullptr;
+    releaseMemory();
 
+    // the content of a memfd is gone with its last fd
+    if (!forceClean && isMemfdFile(m_diskFile)) {
+        m_size = 0;
+        return;
+    }
     m_diskFile.close();
     m_size = 0;
 }
 
+bool MemoryFile::enableHugePage() {
+#    ifdef MADV_HUGEPAGE
+#        ifdef MMKV_ANDROID
+    if (m_diskFile.m_fileType == MMFILE_TYPE_ASHMEM) {
+        return false;
+    }
+#        endif
+    if (m_backend == StorageBackend::Buffered) {
+        return false;
+    }
+    if (m_hugePage) {
+        return true;
+    }
+    m_hugePage = true;
+    if (!m_ptr) {
+        return true;
+    }
+    // remap it at an aligned address, nothing should be pointing into the old mapping yet
+    if (!openIfNeeded()) {
+        return false;
+    }
+    if (::munmap(m_ptr, m_size) != 0) {
+        MMKVError("fail to munmap [%s], %s", m_diskFile.m_path.c_str(), strerror(errno));
+    }
+    m_ptr = nullptr;
+    return mmapOrCleanup(nullptr);
+#    else
+    MMKVWarning("huge page of file mapping not supported [%s]", m_diskFile.m_path.c_str());
+    return false;
+#    endif
+}
+
+static int AccessHint2NativeAdvice(AccessHint hint) {
+    switch (hint) {
+        case AccessHint::WillNeed:
+            return MADV_WILLNEED;
+        case AccessHint::Sequential:
+            return MADV_SEQUENTIAL;
+        case AccessHint::Random:
+            return MADV_RANDOM;
+#    ifdef MADV_COLD
+        case AccessHint::Cold:
+            return MADV_COLD;
+#    endif
+#    ifdef MADV_PAGEOUT
+        case AccessHint::PageOut:
+            return MADV_PAGEOUT;
+#    endif
+        default:
+            return MADV_NORMAL;
+    }
+}
+
+void MemoryFile::adviseAccess(AccessHint hint, size_t offset, size_t length) {
+#    ifdef MMKV_ANDROID
+    if (m_diskFile.m_fileType == MMFILE_TYPE_ASHMEM) {
+        return;
+    }
+#    endif
+    if (!m_ptr || offset >= m_size || m_backend != StorageBackend::MMap) {
+        return;
+    }
+    auto advice = AccessHint2NativeAdvice(hint);
+    if (advice == MADV_NORMAL && hint != AccessHint::Normal) {
+        // not supported by this kernel header, just leave it as it is
+        return;
+    }
+    auto start = offset / DEFAULT_MMAP_SIZE * DEFAULT_MMAP_SIZE;
+    auto end = roundUp<size_t>(std::min(m_size - offset, length) + offset, DEFAULT_MMAP_SIZE);
+    end = std::min(end, m_size);
+    if (::madvise((char *) m_ptr + start, end - start, advice) != 0) {
+        // EINVAL for a kernel older than the header, nothing to worry about
+        MMKVDebug("fail to madvise [%s] with %d, %s", m_diskFile.m_path.c_str(), advice, strerror(errno));
+    }
+}
+
 bool isFileExist(const string &nsFilePath) {
     if (nsFilePath.empty()) {
         return false;
@@ -625,6 +966,34 @@ bool copyFileContent(const MMKVPath_t &srcPath, MMKVFileHandle_t dstFD) {
 
 #endif // !defined(MMKV_APPLE)
 
+#if !defined(MMKV_APPLE) && !defined(MMKV_ANDROID) && !defined(MMKV_LINUX)
+
+bool copyFileRange(MMKVFileHandle_t srcFD, MMKVFileHandle_t dstFD, size_t offset, size_t length) {
+    auto bufferSize = getPageSize();
+    MMBuffer buffer(bufferSize);
+    auto ptr = (char *) buffer.getPtr();
+    while (length > 0) {
+        auto sizeRead = pread(srcFD, ptr, std::min(bufferSize, length), static_cast<off_t>(offset));
+        if (sizeRead <= 0) {
+            MMKVError("fail to read fd [%d] at %zu, %d(%s)", srcFD, offset, errno, strerror(errno));
+            return false;
+        }
+        for (ssize_t totalWrite = 0; totalWrite < sizeRead;) {
+            auto sizeWrite = pwrite(dstFD, ptr + totalWrite, sizeRead - totalWrite, static_cast<off_t>(offset + totalWrite));
+            if (sizeWrite < 0) {
+                MMKVError("fail to write fd [%d], %d(%s)", dstFD, errno, strerror(errno));
+                return false;
+            }
+            totalWrite += sizeWrite;
+        }
+        offset += sizeRead;
+        length -= sizeRead;
+    }
+    return true;
+}
+
+#endif // !defined(MMKV_APPLE) && !defined(MMKV_ANDROID) && !defined(MMKV_LINUX)
+
 void walkInDir(const MMKVPath_t &dirPath, WalkType type, const function<void(const MMKVPath_t&, WalkType)> &walker) {
     auto folderPathStr = dirPath.data();
     DIR *dir = opendir(folderPathStr);
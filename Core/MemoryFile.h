@@ -23,8 +23,11 @@
 #ifdef __cplusplus
 
 #include "MMKVPredef.h"
+#include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <utility>
+#include <vector>
 
 #ifdef MMKV_ANDROID
 MMKVPath_t ashmemMMKVPathWithID(const MMKVPath_t &mmapID);
@@ -63,6 +66,25 @@ static inline OpenFlag operator & (OpenFlag left, uint32_t right) {
     return static_cast<OpenFlag>(static_cast<uint32_t>(left) & right);
 }
 
+// how the mapped memory is going to be accessed, it's only a hint for the kernel's readahead & reclaim
+enum class AccessHint : uint8_t {
+    Normal,
+    WillNeed,   // going to be read soon, start reading it in now
+    Sequential, // read ahead aggressively, and the pages can be dropped soon after being read
+    Random,     // no readahead
+    Cold,       // not needed in the near future, reclaim it first on memory pressure
+    PageOut,    // not needed in the near future, reclaim it now
+};
+
+// how the content of a file is kept in memory
+enum class StorageBackend : uint8_t {
+    // mapped with mmap(), changes reach the page cache (and other processes) right away
+    MMap,
+    // read into a heap buffer with pread(), changes are written back with pwrite() by msync() or on release,
+    // those not written back yet are lost on a crash
+    Buffered,
+};
+
 template <typename T>
 T roundUp(T numToRound, T multiple) {
     return ((numToRound + multiple - 1) / multiple) * multiple;
@@ -70,6 +92,55 @@ T roundUp(T numToRound, T multiple) {
 
 class FileLock;
 
+// page aligned byte ranges [start, end) of a mapping, sorted & disjoint
+// the closest ones are merged once there are too many of them
+class DirtyRanges {
+    std::vector<std::pair<size_t, size_t>> m_ranges;
+
+public:
+    static constexpr size_t MaxRangeCount = 8;
+
+    bool empty() const { return m_ranges.empty(); }
+    void clear() { m_ranges.clear(); }
+    const std::vector<std::pair<size_t, size_t>> &ranges() const { return m_ranges; }
+
+    void add(size_t start, size_t end) {
+        if (start >= end) {
+            return;
+        }
+        start = start / DEFAULT_MMAP_SIZE * DEFAULT_MMAP_SIZE;
+        end = roundUp(end, DEFAULT_MMAP_SIZE);
+        // merge with the ranges that overlap or touch it
+        auto first = std::lower_bound(m_ranges.begin(), m_ranges.end(), start,
+                                      [](const std::pair<size_t, size_t> &range, size_t value) { return range.second < value; });
+        auto last = first;
+        for (; last != m_ranges.end() && last->first <= end; last++) {
+            start = std::min(start, last->first);
+            end = std::max(end, last->second);
+        }
+        first = m_ranges.erase(first, last);
+        m_ranges.emplace(first, start, end);
+
+        if (m_ranges.size() > MaxRangeCount) {
+            size_t closest = 0;
+            for (size_t index = 1; index + 1 < m_ranges.size(); index++) {
+                if (m_ranges[index + 1].first - m_ranges[index].second <
+                    m_ranges[closest + 1].first - m_ranges[closest].second) {
+                    closest = index;
+                }
+            }
+            m_ranges[closest].second = m_ranges[closest + 1].second;
+            m_ranges.erase(m_ranges.begin() + static_cast<std::ptrdiff_t>(closest) + 1);
+        }
+    }
+
+    void add(const DirtyRanges &other) {
+        for (auto &range : other.m_ranges) {
+            add(range.first, range.second);
+        }
+    }
+};
+
 class File {
     MMKVPath_t m_path;
     MMKVFileHandle_t m_fd;
@@ -77,6 +148,12 @@ public:
     const OpenFlag m_flag;
 #ifndef MMKV_ANDROID
     explicit File(MMKVPath_t path, OpenFlag flag);
+#    ifdef MMKV_LINUX
+    // take the ownership of a memfd, it can't be opened again once closed
+    explicit File(MMKVFileHandle_t memfd);
+
+    const bool m_isMemfd = false;
+#    endif
 #else
     File(MMKVPath_t path, OpenFlag flag, size_t size = 0, FileType fileType = MMFILE_TYPE_FILE);
     explicit File(MMKVFileHandle_t ashmemFD);
@@ -121,7 +198,53 @@ class MemoryFile {
     const bool m_readOnly;
     const bool m_isMayflyFD;
 
+    // modified since the last msync()
+    DirtyRanges m_dirtyRanges;
+    // write back started by msync(MMKV_ASYNC) but not waited for yet
+    DirtyRanges m_flushingRanges;
+    bool m_trackDirty;
+    // map at an address aligned to the huge page size & madvise(MADV_HUGEPAGE), see enableHugePage()
+    bool m_hugePage;
+    StorageBackend m_backend;
+    // bytes marked dirty since the last write back of the Buffered backend
+    size_t m_pendingWriteBack;
+
     bool mmapOrCleanup(FileLock *fileLock);
+    bool readOrCleanup(FileLock *fileLock);
+    // unmap or free the memory, the Buffered backend writes back what's dirty first
+    void releaseMemory();
+    // pwrite() the dirty ranges of the Buffered backend
+    bool writeBack();
+
+    // the (offset, length) ranges for msync() to write back
+    std::vector<std::pair<size_t, size_t>> getSyncRanges(SyncFlag syncFlag) const {
+        std::vector<std::pair<size_t, size_t>> result;
+        if (!m_trackDirty) {
+            result.emplace_back(0, m_size);
+            return result;
+        }
+        auto ranges = m_dirtyRanges;
+        if (syncFlag == MMKV_SYNC) {
+            // wait for what the previous msync(MMKV_ASYNC) has started
+            ranges.add(m_flushingRanges);
+        }
+        for (auto &range : ranges.ranges()) {
+            auto end = std::min(range.second, m_size);
+            if (range.first < end) {
+                result.emplace_back(range.first, end - range.first);
+            }
+        }
+        return result;
+    }
+
+    void onSyncFinished(SyncFlag syncFlag) {
+        if (syncFlag == MMKV_SYNC) {
+            m_flushingRanges.clear();
+        } else {
+            m_flushingRanges.add(m_dirtyRanges);
+        }
+        m_dirtyRanges.clear();
+    }
 
     void doCleanMemoryCache(bool forceClean);
 
@@ -130,6 +253,12 @@ class MemoryFile {
 public:
 #ifndef MMKV_ANDROID
     explicit MemoryFile(MMKVPath_t path, size_t expectedCapacity = 0, bool readOnly = false, bool mayflyFD = false);
+#    ifdef MMKV_LINUX
+    // take the ownership of a memfd, the mapping is released by clearMemoryCache() but the memfd is kept
+    explicit MemoryFile(MMKVFileHandle_t memfd);
+
+    bool isMemfd() const { return m_diskFile.m_isMemfd; }
+#    endif
 #else
     MemoryFile(MMKVPath_t path, size_t size, FileType fileType, size_t expectedCapacity = 0, bool readOnly = false, bool mayflyFD = false);
     explicit MemoryFile(MMKVFileHandle_t ashmemFD);
@@ -155,13 +284,46 @@ public:
     // the newly expanded file content will be zeroed
     bool truncate(size_t size, FileLock *fileLock = nullptr);
 
+    // only write back the pages that have been marked dirty, or all of them if dirty tracking is not enabled
     bool msync(SyncFlag syncFlag);
 
+    // once enabled, every modification must be reported by markDirty(), or it won't be written back by msync()
+    // the whole file is considered dirty after each mmap
+    void enableDirtyTracking() { m_trackDirty = true; }
+
+    void markDirty(size_t offset, size_t length) {
+        m_dirtyRanges.add(offset, offset + length);
+        if (m_backend == StorageBackend::Buffered) {
+            m_pendingWriteBack += length;
+        }
+    }
+
+    // bytes marked dirty but not written back yet by the Buffered backend, always 0 for MMap
+    size_t getPendingWriteBackSize() const { return m_pendingWriteBack; }
+
+    // the owner is expected to msync() once there are this many bytes pending
+    static constexpr size_t BufferedWriteBackSize = 1024 * 1024;
+
+    // switch the way the file content is kept in memory, it's reloaded if already loaded
+    // Buffered is not supported on Windows & for ashmem, return false
+    bool setBackend(StorageBackend backend);
+
+    StorageBackend getBackend() const { return m_backend; }
+
+    // map the file with transparent huge pages from now on, it's remapped if already mapped
+    // only works with a kernel that supports huge pages of file mappings (Linux file THP), return false otherwise
+    bool enableHugePage();
+
+    bool isHugePageEnabled() const { return m_hugePage; }
+
     // call this if clearMemoryCache() has been called
     void reloadFromFile(size_t expectedCapacity = 0);
 
     void clearMemoryCache() { doCleanMemoryCache(false); }
 
+    // [offset, offset + length) is clamped to the mapping & rounded to pages, a no-op if the kernel doesn't support it
+    void adviseAccess(AccessHint hint, size_t offset, size_t length);
+
 #ifndef MMKV_WIN32
     bool isFileValid() { return (m_isMayflyFD || m_diskFile.isFileValid()) && m_size > 0 && m_ptr; }
 #else
@@ -194,6 +356,21 @@ extern bool copyFileContent(const MMKVPath_t &srcPath, const MMKVPath_t &dstPath
 extern bool copyFileContent(const MMKVPath_t &srcPath, MMKVFileHandle_t dstFD);
 extern bool copyFileContent(const MMKVPath_t &srcPath, MMKVFileHandle_t dstFD, bool needTruncate);
 
+#ifndef MMKV_APPLE
+// copy [offset, offset + length) of the source file to the same position of the target file
+extern bool copyFileRange(MMKVFileHandle_t srcFD, MMKVFileHandle_t dstFD, size_t offset, size_t length);
+#endif
+
+#ifdef MMKV_LINUX
+// create a memfd of [size] bytes, sealed against shrinking, so that no process can pull the pages from under the mapping
+// of another process, return -1 on failure
+extern MMKVFileHandle_t createMemfd(const std::string &name, size_t size);
+
+// open a new file description of a memfd passed from another process, so that flock() works between them
+// the passed fd is left to the caller, return -1 if it's not a memfd
+extern MMKVFileHandle_t reopenMemfd(MMKVFileHandle_t memfd);
+#endif
+
 //#if defined(MMKV_APPLE) || defined(MMKV_WIN32)
 bool isDiskOfMMAPFileCorrupted(MemoryFile *file, bool &needReportReadFail);
 //#endif
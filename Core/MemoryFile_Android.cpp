@@ -72,7 +72,8 @@ File::File(MMKVFileHandle_t ashmemFD)
 
 MemoryFile::MemoryFile(string path, size_t size, FileType fileType, size_t expectedCapacity, bool isReadOnly, bool mayflyFD)
     : m_diskFile(std::move(path), isReadOnly ? OpenFlag::ReadOnly : (OpenFlag::ReadWrite | OpenFlag::Create), size, fileType),
-    m_ptr(nullptr), m_size(0), m_fileType(fileType), m_readOnly(isReadOnly), m_isMayflyFD(mayflyFD) {
+    m_ptr(nullptr), m_size(0), m_fileType(fileType), m_readOnly(isReadOnly), m_isMayflyFD(mayflyFD), m_trackDirty(false), m_hugePage(false),
+    m_backend(StorageBackend::MMap), m_pendingWriteBack(0) {
     if (m_fileType == MMFILE_TYPE_FILE) {
         reloadFromFile(expectedCapacity);
     } else {
@@ -85,7 +86,8 @@ MemoryFile::MemoryFile(string path, size_t size, FileType fileType, size_t expec
 
 MemoryFile::MemoryFile(int ashmemFD)
     : m_diskFile(ashmemFD), m_ptr(nullptr), m_size(0), m_fileType(MMFILE_TYPE_ASHMEM), m_readOnly(false),
-    m_isMayflyFD(false) {
+    m_isMayflyFD(false), m_trackDirty(false), m_hugePage(false),
+    m_backend(StorageBackend::MMap), m_pendingWriteBack(0) {
     if (!m_diskFile.isFileValid()) {
         MMKVError("fd %d invalid", ashmemFD);
     } else {
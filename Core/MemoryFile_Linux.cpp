@@ -34,8 +34,12 @@
 #    include <sys/file.h>
 #    include <dirent.h>
 #    include <cstring>
+#    include <sys/ioctl.h>
 #    include <sys/sendfile.h>
 #    include <sys/syscall.h>
+#    ifdef MMKV_LINUX
+#        include <linux/fs.h>
+#    endif
 
 #ifdef MMKV_ANDROID
 #include <dlfcn.h>
@@ -86,7 +90,52 @@ bool tryAtomicRename(const MMKVPath_t &srcPath, const MMKVPath_t &dstPath) {
     return true;
 }
 
-// do it by sendfile()
+// do it by copy_file_range() or sendfile()
+bool copyFileRange(MMKVFileHandle_t srcFD, MMKVFileHandle_t dstFD, size_t offset, size_t length) {
+    auto srcOffset = static_cast<off_t>(offset);
+#    ifdef MMKV_LINUX
+    // it's done inside the kernel, some file systems (btrfs, xfs, nfs...) even share the extents instead of copying
+    auto dstOffset = static_cast<off_t>(offset);
+    while (length > 0) {
+        auto copied = ::copy_file_range(srcFD, &srcOffset, dstFD, &dstOffset, length, 0);
+        if (copied > 0) {
+            length -= static_cast<size_t>(copied);
+            continue;
+        }
+        if (copied == 0) {
+            MMKVError("fail to copy_file_range() from fd[%d] to fd[%d], %zu bytes beyond the end", srcFD, dstFD, length);
+            return false;
+        }
+        if (errno != EXDEV && errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP) {
+            MMKVError("fail to copy_file_range() from fd[%d] to fd[%d], %d(%s)", srcFD, dstFD, errno, strerror(errno));
+            return false;
+        }
+        // not supported between these two files, fall back to sendfile()
+        break;
+    }
+    if (length == 0) {
+        return true;
+    }
+#    endif
+    if (lseek(dstFD, srcOffset, SEEK_SET) < 0) {
+        MMKVError("fail to lseek fd[%d], %d(%s)", dstFD, errno, strerror(errno));
+        return false;
+    }
+    while (length > 0) {
+        auto writtenSize = ::sendfile(dstFD, srcFD, &srcOffset, length);
+        if (writtenSize <= 0) {
+            if (writtenSize < 0) {
+                MMKVError("fail to sendfile() from fd[%d] to fd[%d], %d(%s)", srcFD, dstFD, errno, strerror(errno));
+            } else {
+                MMKVError("sendfile() from fd[%d] to fd[%d], %zu bytes beyond the end", srcFD, dstFD, length);
+            }
+            return false;
+        }
+        length -= static_cast<size_t>(writtenSize);
+    }
+    return true;
+}
+
 bool copyFileContent(const MMKVPath_t &srcPath, MMKVFileHandle_t dstFD, bool needTruncate) {
     if (dstFD < 0) {
         return false;
@@ -97,15 +146,19 @@ bool copyFileContent(const MMKVPath_t &srcPath, MMKVFileHandle_t dstFD, bool nee
     }
     auto srcFileSize = srcFile.getActualFileSize();
 
-    lseek(dstFD, 0, SEEK_SET);
-    auto writtenSize = ::sendfile(dstFD, srcFile.getFd(), nullptr, srcFileSize);
-    auto ret = (writtenSize == srcFileSize);
+#    if defined(MMKV_LINUX) && defined(FICLONE)
+    // a reflink shares the extents without copying any data, the target ends up with the same size as the source
+    size_t targetSize = 0;
+    getFileSize(dstFD, targetSize);
+    if ((needTruncate || targetSize <= srcFileSize) && ::ioctl(dstFD, FICLONE, srcFile.getFd()) == 0) {
+        MMKVInfo("clone content from %s to fd[%d] finish", srcPath.c_str(), dstFD);
+        return true;
+    }
+#    endif
+
+    auto ret = copyFileRange(srcFile.getFd(), dstFD, 0, srcFileSize);
     if (!ret) {
-        if (writtenSize < 0) {
-            MMKVError("fail to sendfile() %s to fd[%d], %d(%s)", srcPath.c_str(), dstFD, errno, strerror(errno));
-        } else {
-            MMKVError("sendfile() %s to fd[%d], written %lld < %zu", srcPath.c_str(), dstFD, writtenSize, srcFileSize);
-        }
+        MMKVError("fail to copy content from %s to fd[%d]", srcPath.c_str(), dstFD);
     } else if (needTruncate) {
         size_t dstFileSize = 0;
         getFileSize(dstFD, dstFileSize);
@@ -121,6 +174,51 @@ bool copyFileContent(const MMKVPath_t &srcPath, MMKVFileHandle_t dstFD, bool nee
     return ret;
 }
 
+
+#    ifdef MMKV_LINUX
+
+MMKVFileHandle_t createMemfd(const std::string &name, size_t size) {
+    auto fd = ::memfd_create(name.c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        MMKVError("fail to memfd_create [%s], %d(%s)", name.c_str(), errno, strerror(errno));
+        return -1;
+    }
+    size = roundUp<size_t>(std::max<size_t>(size, 1), DEFAULT_MMAP_SIZE);
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        MMKVError("fail to truncate memfd [%s] to size %zu, %d(%s)", name.c_str(), size, errno, strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+    // other processes map the same pages, they must never be cut off from under their mapping
+    if (::fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) != 0) {
+        MMKVWarning("fail to seal memfd [%s], %d(%s)", name.c_str(), errno, strerror(errno));
+    }
+    return fd;
+}
+
+MMKVFileHandle_t reopenMemfd(MMKVFileHandle_t memfd) {
+    auto seals = ::fcntl(memfd, F_GET_SEALS);
+    if (seals < 0) {
+        MMKVError("fd[%d] is not a memfd, %d(%s)", memfd, errno, strerror(errno));
+        return -1;
+    }
+    if (!(seals & F_SEAL_SHRINK)) {
+        MMKVWarning("memfd fd[%d] is not sealed against shrinking", memfd);
+        if (!(seals & F_SEAL_SEAL)) {
+            ::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK);
+        }
+    }
+    // a new open file description, so that flock() tells us apart from whoever shared the fd
+    auto path = "/proc/self/fd/" + std::to_string(memfd);
+    auto fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        MMKVError("fail to reopen memfd fd[%d], %d(%s)", memfd, errno, strerror(errno));
+    }
+    return fd;
+}
+
+#    endif // MMKV_LINUX
+
 } // namespace mmkv
 
 #endif // defined(MMKV_ANDROID) || defined(MMKV_LINUX)
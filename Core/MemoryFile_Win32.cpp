@@ -107,7 +107,11 @@ MemoryFile::MemoryFile(MMKVPath_t path, size_t expectedCapacity, bool readOnly,
     , m_ptr(nullptr)
     , m_size(0)
     , m_readOnly(readOnly)
-    , m_isMayflyFD(mayflyFD) {
+    , m_isMayflyFD(mayflyFD)
+    , m_trackDirty(false)
+    , m_hugePage(false)
+    , m_backend(StorageBackend::MMap)
+    , m_pendingWriteBack(0) {
     reloadFromFile(expectedCapacity);
 }
 
@@ -176,19 +180,25 @@ bool MemoryFile::msync(SyncFlag syncFlag) {
         return true;
     }
     if (m_ptr) {
-        if (FlushViewOfFile(m_ptr, m_size)) {
-            if (syncFlag == MMKV_SYNC && openIfNeeded()) {
-                auto ret = FlushFileBuffers(m_diskFile.getFd());
-                if (!ret) {
-                    MMKVError("fail to FlushFileBuffers [%ls]:%d", m_diskFile.m_path.c_str(), GetLastError());
-                }
-                cleanMayflyFD();
-                return ret;
+        auto ranges = getSyncRanges(syncFlag);
+        for (auto &range : ranges) {
+            if (!FlushViewOfFile((char *) m_ptr + range.first, range.second)) {
+                MMKVError("fail to FlushViewOfFile [%ls]:%d", m_diskFile.m_path.c_str(), GetLastError());
+                return false;
             }
-            return true;
         }
-        MMKVError("fail to FlushViewOfFile [%ls]:%d", m_diskFile.m_path.c_str(), GetLastError());
-        return false;
+        if (syncFlag == MMKV_SYNC && !ranges.empty() && openIfNeeded()) {
+            auto ret = FlushFileBuffers(m_diskFile.getFd());
+            if (!ret) {
+                MMKVError("fail to FlushFileBuffers [%ls]:%d", m_diskFile.m_path.c_str(), GetLastError());
+            } else {
+                onSyncFinished(syncFlag);
+            }
+            cleanMayflyFD();
+            return ret;
+        }
+        onSyncFinished(syncFlag);
+        return true;
     }
     return false;
 }
@@ -209,6 +219,8 @@ bool MemoryFile::mmapOrCleanup(FileLock *fileLock) {
             return false;
         }
         MMKVInfo("mmap to address [%p], [%ls]", m_ptr, m_diskFile.m_path.c_str());
+        m_dirtyRanges.add(0, m_size);
+        m_flushingRanges.clear();
 
         if (m_isMayflyFD && fileLock) {
             fileLock->destroyAndUnLock();
@@ -258,6 +270,23 @@ void MemoryFile::doCleanMemoryCache(bool forceClean) {
     m_diskFile.close();
 }
 
+// only the MMap backend is implemented on Windows
+bool MemoryFile::setBackend(StorageBackend backend) {
+    return backend == StorageBackend::MMap;
+}
+
+bool MemoryFile::writeBack() {
+    return false;
+}
+
+// large pages can't back a file mapping on Windows
+bool MemoryFile::enableHugePage() {
+    return false;
+}
+
+// the access pattern is left to the system's default prefetching on Windows
+void MemoryFile::adviseAccess(AccessHint, size_t, size_t) {}
+
 bool MemoryFile::openIfNeeded() {
     if (!m_diskFile.isFileValid()) {
         return m_diskFile.open();
@@ -524,6 +553,30 @@ errorOut:
     return ret;
 }
 
+bool copyFileRange(MMKVFileHandle_t srcFD, MMKVFileHandle_t dstFD, size_t offset, size_t length) {
+    auto bufferSize = getPageSize();
+    MMBuffer buffer(bufferSize);
+    auto ptr = (char *) buffer.getPtr();
+    while (length > 0) {
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(static_cast<uint64_t>(offset) >> 32);
+        DWORD sizeRead = 0;
+        if (!ReadFile(srcFD, ptr, (DWORD) std::min(bufferSize, length), &sizeRead, &position) || sizeRead == 0) {
+            MMKVError("fail to read fd [%p] at %zu: %d", srcFD, offset, GetLastError());
+            return false;
+        }
+        DWORD sizeWrite = 0;
+        if (!WriteFile(dstFD, ptr, sizeRead, &sizeWrite, &position) || sizeWrite != sizeRead) {
+            MMKVError("fail to write fd [%p] at %zu: %d", dstFD, offset, GetLastError());
+            return false;
+        }
+        offset += sizeRead;
+        length -= sizeRead;
+    }
+    return true;
+}
+
 // copy to a temp file then rename it
 // this is the best we can do on Win32
 bool copyFile(const MMKVPath_t &srcPath, const MMKVPath_t &dstPath) {
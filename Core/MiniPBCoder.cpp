@@ -25,6 +25,7 @@
 #include "PBEncodeItem.hpp"
 #include "PBUtility.h"
 #include "MMKVLog.h"
+#include <stdexcept>
 
 #ifdef MMKV_APPLE
 #    if __has_feature(objc_arc)
@@ -39,11 +40,12 @@ namespace mmkv {
 MiniPBCoder::MiniPBCoder() : m_encodeItems(new std::vector<PBEncodeItem>()) {
 }
 
-MiniPBCoder::MiniPBCoder(const MMBuffer *inputBuffer, AESCrypt *crypter) : MiniPBCoder() {
+MiniPBCoder::MiniPBCoder(const MMBuffer *inputBuffer, AESCrypt *crypter, bool lazyDecrypt) : MiniPBCoder() {
     m_inputBuffer = inputBuffer;
 #ifndef MMKV_DISABLE_CRYPT
     if (crypter) {
-        m_inputDataDecrpt = new CodedInputDataCrypt(m_inputBuffer->getPtr(), m_inputBuffer->length(), *crypter);
+        m_inputDataDecrpt =
+            new CodedInputDataCrypt(m_inputBuffer->getPtr(), m_inputBuffer->length(), *crypter, lazyDecrypt);
     } else {
         m_inputData = new CodedInputData(m_inputBuffer->getPtr(), m_inputBuffer->length());
     }
@@ -501,25 +503,43 @@ bool MiniPBCoder::decodeOneVector(std::vector<double> &result) {
 #endif // MMKV_HAS_CPP20
 
 #ifndef MMKV_APPLE
+// count the records ahead, it's an upper bound of the key count for the file may contain duplicated keys
+static size_t countKeyValueHolders(CodedInputData input) {
+    size_t count = 0;
+    KeyValueHolder kvHolder;
+    string_view key;
+    while (!input.isAtEnd() && input.readKeyValueHolder(kvHolder, key)) {
+        count++;
+    }
+    return count;
+}
+
 void MiniPBCoder::decodeOneMap(MMKVMap &dic, size_t position, bool greedy) {
     auto block = [position, this](MMKVMap &dictionary) {
         if (position) {
             m_inputData->seek(position);
         } else {
             m_inputData->readInt32();
+            // scanning is way cheaper than rehashing the whole map again and again
+            dictionary.reserve(dictionary.size() + countKeyValueHolders(*m_inputData));
         }
         while (!m_inputData->isAtEnd()) {
             KeyValueHolder kvHolder;
-            const auto &key = m_inputData->readString(kvHolder);
+            string_view key;
+            if (!m_inputData->readKeyValueHolder(kvHolder, key)) {
+                throw out_of_range("InvalidProtocolBuffer truncatedMessage");
+            }
             if (key.length() > 0) {
-                m_inputData->readData(kvHolder);
+                // only copy the key when it's new
+                auto itr = dictionary.find(key);
                 if (kvHolder.valueSize > 0) {
-                    dictionary[key] = std::move(kvHolder);
-                } else {
-                    auto itr = dictionary.find(key);
                     if (itr != dictionary.end()) {
-                        dictionary.erase(itr);
+                        itr->second = kvHolder;
+                    } else {
+                        dictionary.emplace(string(key), kvHolder);
                     }
+                } else if (itr != dictionary.end()) {
+                    dictionary.erase(itr);
                 }
             }
         }
@@ -651,18 +671,82 @@ void MiniPBCoder::greedyDecodeMap(MMKVMap &dic, const MMBuffer &oData, size_t po
     oCoder.decodeOneMap(dic, position, true);
 }
 
+vector<uint32_t> MiniPBCoder::decodeItemOffsets(const MMBuffer &oData, size_t position) {
+    vector<uint32_t> offsets;
+    try {
+        CodedInputData input(oData.getPtr(), oData.length());
+        if (position) {
+            input.seek(position);
+        } else {
+            input.readInt32();
+        }
+        KeyValueHolder kvHolder;
+        string_view key;
+        while (!input.isAtEnd() && input.readKeyValueHolder(kvHolder, key)) {
+            offsets.push_back(kvHolder.offset);
+        }
+    } catch (std::exception &exception) {
+        MMKVError("%s", exception.what());
+    }
+    return offsets;
+}
+
+#ifndef MMKV_APPLE
+vector<string> MiniPBCoder::decodeItemKeys(const MMBuffer &oData, size_t position) {
+    vector<string> keys;
+    try {
+        CodedInputData input(oData.getPtr(), oData.length());
+        if (position) {
+            input.seek(position);
+        } else {
+            input.readInt32();
+        }
+        KeyValueHolder kvHolder;
+        string_view key;
+        while (!input.isAtEnd() && input.readKeyValueHolder(kvHolder, key)) {
+            keys.emplace_back(key);
+        }
+    } catch (std::exception &exception) {
+        MMKVError("%s", exception.what());
+    }
+    return keys;
+}
+#endif
+
 #ifndef MMKV_DISABLE_CRYPT
 
-void MiniPBCoder::decodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position) {
-    MiniPBCoder oCoder(&oData, crypter);
+void MiniPBCoder::decodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position,
+                            bool lazyDecrypt) {
+    MiniPBCoder oCoder(&oData, crypter, lazyDecrypt);
     oCoder.decodeOneMap(dic, position, false);
 }
 
-void MiniPBCoder::greedyDecodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position) {
-    MiniPBCoder oCoder(&oData, crypter);
+void MiniPBCoder::greedyDecodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position,
+                                  bool lazyDecrypt) {
+    MiniPBCoder oCoder(&oData, crypter, lazyDecrypt);
     oCoder.decodeOneMap(dic, position, true);
 }
 
+vector<uint32_t> MiniPBCoder::decodeItemOffsets(const MMBuffer &oData, AESCrypt *crypter) {
+    vector<uint32_t> offsets;
+    try {
+        // values are skipped rather than decrypted whenever possible
+        CodedInputDataCrypt input(oData.getPtr(), oData.length(), *crypter, true);
+        input.readInt32();
+        while (!input.isAtEnd()) {
+            KeyValueHolderCrypt kvHolder;
+            const auto &key = input.readString(kvHolder);
+            offsets.push_back(kvHolder.offset);
+            if (key.length() > 0) {
+                input.readData(kvHolder);
+            }
+        }
+    } catch (std::exception &exception) {
+        MMKVError("%s", exception.what());
+    }
+    return offsets;
+}
+
 #endif
 
 } // namespace mmkv
@@ -52,7 +52,7 @@ class MMKV_EXPORT MiniPBCoder {
     std::vector<PBEncodeItem> *m_encodeItems = nullptr;
 
     MiniPBCoder();
-    explicit MiniPBCoder(const MMBuffer *inputBuffer, AESCrypt *crypter = nullptr);
+    explicit MiniPBCoder(const MMBuffer *inputBuffer, AESCrypt *crypter = nullptr, bool lazyDecrypt = false);
     ~MiniPBCoder();
 
     void writeRootObject();
@@ -117,12 +117,26 @@ public:
     // decode as much data as possible before any error happens
     static void greedyDecodeMap(MMKVMap &dic, const MMBuffer &oData, size_t position = 0);
 
+    // the offsets of the items in ascending order, stop at the first error
+    static std::vector<uint32_t> decodeItemOffsets(const MMBuffer &oData, size_t position = 0);
+
+#ifndef MMKV_APPLE
+    // the keys of the items in the order they are written, removed ones included, stop at the first error
+    static std::vector<std::string> decodeItemKeys(const MMBuffer &oData, size_t position = 0);
+#endif
+
 #ifndef MMKV_DISABLE_CRYPT
     // return empty result if there's any error
-    static void decodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position = 0);
+    // with lazyDecrypt, values larger than KeyValueHolderCrypt::SmallBufferSize() are decrypted on demand
+    static void decodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position = 0,
+                          bool lazyDecrypt = false);
 
     // decode as much data as possible before any error happens
-    static void greedyDecodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position = 0);
+    static void greedyDecodeMap(MMKVMapCrypt &dic, const MMBuffer &oData, AESCrypt *crypter, size_t position = 0,
+                                bool lazyDecrypt = false);
+
+    // the crypter must be at the beginning of the data
+    static std::vector<uint32_t> decodeItemOffsets(const MMBuffer &oData, AESCrypt *crypter);
 #endif // MMKV_DISABLE_CRYPT
 
     static std::vector<std::string> decodeVector(const MMBuffer &oData);
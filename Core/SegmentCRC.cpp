@@ -0,0 +1,278 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SegmentCRC.h"
+
+#ifndef MMKV_APPLE
+
+#    include "crc32/Checksum.h"
+#    include <algorithm>
+#    include <limits>
+
+using namespace std;
+
+namespace mmkv {
+
+// GF(2) polynomial arithmetic of the reflected crc32 polynomial, the same as zlib's crc32_combine()
+constexpr uint32_t CRC32Polynomial = 0xedb88320;
+
+// a * b mod p
+static uint32_t multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31, p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0) {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC32Polynomial : b >> 1;
+    }
+    return p;
+}
+
+// x^(2^n) mod p
+struct X2NTable {
+    uint32_t table[32];
+
+    X2NTable() {
+        uint32_t p = 1u << 30; // x^1
+        table[0] = p;
+        for (int n = 1; n < 32; n++) {
+            table[n] = p = multmodp(p, p);
+        }
+    }
+};
+
+// x^(8 * length) mod p, the operator to shift a crc over [length] zero bytes
+static uint32_t shiftOperator(size_t length) {
+    static const X2NTable x2n;
+    uint32_t p = 1u << 31; // x^0
+    unsigned k = 3;
+    while (length) {
+        if (length & 1) {
+            p = multmodp(x2n.table[k & 31], p);
+        }
+        length >>= 1;
+        k++;
+    }
+    return p;
+}
+
+uint32_t SegmentCRCTable::combine(uint32_t crcA, uint32_t crcB, size_t lengthB) {
+    return multmodp(shiftOperator(lengthB), crcA) ^ crcB;
+}
+
+static size_t segmentCountOf(size_t actualSize, uint32_t shift) {
+    return (actualSize + (static_cast<size_t>(1) << shift) - 1) >> shift;
+}
+
+SegmentCRCTable::SegmentCRCTable(void *metaPtr) {
+    auto ptr = (uint8_t *) metaPtr + TableOffset;
+    m_header = (Header *) ptr;
+    m_entries = (Entry *) (ptr + sizeof(Header));
+}
+
+bool SegmentCRCTable::isValid(size_t actualSize, uint32_t crcDigest) const {
+    auto shift = m_header->segmentShift;
+    if (m_header->actualSize != actualSize || m_header->crcDigest != crcDigest) {
+        return false;
+    }
+    if (shift < MinSegmentShift || shift >= 32) {
+        return false;
+    }
+    auto count = m_header->segmentCount;
+    return count <= Capacity && count == segmentCountOf(actualSize, shift);
+}
+
+void SegmentCRCTable::invalidate() {
+    m_header->actualSize = numeric_limits<uint32_t>::max();
+}
+
+void SegmentCRCTable::confirm(size_t actualSize, uint32_t crcDigest) {
+    m_header->crcDigest = crcDigest;
+    m_header->actualSize = static_cast<uint32_t>(actualSize);
+}
+
+size_t SegmentCRCTable::segmentLength(size_t index, size_t actualSize) const {
+    auto start = index << m_header->segmentShift;
+    return min(segmentSize(), actualSize - start);
+}
+
+// merge every two segments into one, segments beyond the first [count] are dropped
+// dataSize is the size of data that the segments cover, the last one of them might not be full
+void SegmentCRCTable::coarsen(size_t count, size_t dataSize) {
+    auto shift = m_header->segmentShift;
+    size_t index = 0;
+    for (; index * 2 + 1 < count; index++) {
+        auto left = m_entries[index * 2];
+        auto right = m_entries[index * 2 + 1];
+        auto leftEnd = (index * 2 + 1) << shift;
+        m_entries[index].crcDigest = combine(left.crcDigest, right.crcDigest, segmentLength(index * 2 + 1, dataSize));
+        m_entries[index].firstItem = (left.firstItem < leftEnd) ? left.firstItem : right.firstItem;
+    }
+    if (index * 2 < count) {
+        m_entries[index] = m_entries[index * 2];
+        index++;
+    }
+    m_header->segmentShift = shift + 1;
+    m_header->segmentCount = static_cast<uint32_t>(index);
+}
+
+uint32_t SegmentCRCTable::combineSegments(size_t count) const {
+    auto shiftSegment = shiftOperator(segmentSize());
+    uint32_t crc = 0;
+    for (size_t index = 0; index < count; index++) {
+        crc = multmodp(shiftSegment, crc) ^ m_entries[index].crcDigest;
+    }
+    return crc;
+}
+
+uint32_t SegmentCRCTable::lastSegmentCRC(size_t actualSize, uint32_t crcDigest) const {
+    auto index = m_header->segmentCount - 1;
+    auto before = m_entries[index].crcDigest;
+    return crcDigest ^ multmodp(shiftOperator(segmentLength(index, actualSize)), before);
+}
+
+uint32_t SegmentCRCTable::rebuild(const uint8_t *ptr, size_t actualSize, const vector<uint32_t> &itemOffsets) {
+    invalidate();
+    uint32_t shift = MinSegmentShift;
+    while (segmentCountOf(actualSize, shift) > Capacity) {
+        shift++;
+    }
+    m_header->segmentShift = shift;
+    m_header->segmentCount = 0;
+    return update(ptr, actualSize, 0, itemOffsets);
+}
+
+uint32_t SegmentCRCTable::update(const uint8_t *ptr, size_t actualSize, size_t dirtyStart,
+                                 const vector<uint32_t> &itemOffsets) {
+    if (m_header->segmentCount > 0 && m_header->actualSize != numeric_limits<uint32_t>::max()) {
+        // the last segment might stay clean without being the last one any more
+        auto &last = m_entries[m_header->segmentCount - 1];
+        last.crcDigest = lastSegmentCRC(m_header->actualSize, m_header->crcDigest);
+    }
+    auto cleanCount = min<size_t>(dirtyStart >> m_header->segmentShift, m_header->segmentCount);
+    // the first item of the segment that dirtyStart lies in, if it starts before dirtyStart
+    auto pending = numeric_limits<uint32_t>::max();
+    if (cleanCount < m_header->segmentCount && m_entries[cleanCount].firstItem < dirtyStart) {
+        pending = m_entries[cleanCount].firstItem;
+    }
+    invalidate();
+    while (segmentCountOf(actualSize, m_header->segmentShift) > Capacity) {
+        if (cleanCount & 1) {
+            auto &last = m_entries[cleanCount - 1];
+            if (last.firstItem < (cleanCount << m_header->segmentShift)) {
+                pending = last.firstItem;
+            }
+        }
+        coarsen(cleanCount & ~static_cast<size_t>(1), dirtyStart);
+        cleanCount /= 2;
+    }
+
+    auto shift = m_header->segmentShift;
+    auto count = segmentCountOf(actualSize, shift);
+    m_header->segmentCount = static_cast<uint32_t>(count);
+    auto itr = itemOffsets.begin();
+    for (auto index = cleanCount; index < count; index++) {
+        auto start = index << shift;
+        auto &entry = m_entries[index];
+        entry.crcDigest = static_cast<uint32_t>(CRC32(0, ptr + start, segmentLength(index, actualSize)));
+        while (itr != itemOffsets.end() && *itr < start) {
+            itr++;
+        }
+        auto firstItem = (itr != itemOffsets.end()) ? *itr : static_cast<uint32_t>(actualSize);
+        entry.firstItem = (index == cleanCount) ? min(firstItem, pending) : firstItem;
+    }
+    if (cleanCount > 0) {
+        // the item size holder always changes
+        m_entries[0].crcDigest = static_cast<uint32_t>(CRC32(0, ptr, segmentLength(0, actualSize)));
+    }
+    if (count == 0) {
+        return 0;
+    }
+    auto &last = m_entries[count - 1];
+    auto lastCRC = last.crcDigest;
+    last.crcDigest = combineSegments(count - 1);
+    return combine(last.crcDigest, lastCRC, segmentLength(count - 1, actualSize));
+}
+
+uint32_t SegmentCRCTable::append(const uint8_t *ptr, size_t oldActualSize, size_t actualSize, uint32_t crcDigest) {
+    invalidate();
+    if (segmentCountOf(actualSize, m_header->segmentShift) > Capacity) {
+        // coarsening combines the crc of every segment, the last one included
+        auto &last = m_entries[m_header->segmentCount - 1];
+        last.crcDigest = lastSegmentCRC(oldActualSize, crcDigest);
+        while (segmentCountOf(actualSize, m_header->segmentShift) > Capacity) {
+            coarsen(m_header->segmentCount, oldActualSize);
+        }
+        auto &newLast = m_entries[m_header->segmentCount - 1];
+        newLast.crcDigest = combineSegments(m_header->segmentCount - 1);
+    }
+
+    // every appended byte is checksummed once, into the whole digest, or into a segment that is full already
+    auto shift = m_header->segmentShift;
+    size_t count = m_header->segmentCount;
+    if (count > 0) {
+        auto end = min(count << shift, actualSize);
+        if (end > oldActualSize) {
+            crcDigest = static_cast<uint32_t>(CRC32(crcDigest, ptr + oldActualSize, end - oldActualSize));
+        }
+        if (end < actualSize) {
+            // it's full & no longer the last one
+            auto &last = m_entries[count - 1];
+            last.crcDigest = lastSegmentCRC(end, crcDigest);
+        }
+    }
+    auto newCount = segmentCountOf(actualSize, shift);
+    for (auto index = count; index < newCount; index++) {
+        auto start = index << shift;
+        auto &entry = m_entries[index];
+        auto length = segmentLength(index, actualSize);
+        // any item that points to the old end now points to the appended one
+        entry.firstItem = static_cast<uint32_t>((start == oldActualSize) ? oldActualSize : actualSize);
+        if (index + 1 < newCount) {
+            entry.crcDigest = static_cast<uint32_t>(CRC32(0, ptr + start, length));
+            crcDigest = combine(crcDigest, entry.crcDigest, length);
+        } else {
+            entry.crcDigest = crcDigest;
+            crcDigest = static_cast<uint32_t>(CRC32(crcDigest, ptr + start, length));
+        }
+    }
+    m_header->segmentCount = static_cast<uint32_t>(newCount);
+    return crcDigest;
+}
+
+vector<bool> SegmentCRCTable::damagedSegments(const uint8_t *ptr, size_t actualSize) const {
+    auto shift = m_header->segmentShift;
+    size_t count = m_header->segmentCount;
+    vector<bool> result(count, false);
+    for (size_t index = 0; index < count; index++) {
+        auto crc = static_cast<uint32_t>(CRC32(0, ptr + (index << shift), segmentLength(index, actualSize)));
+        auto expected = (index + 1 < count) ? m_entries[index].crcDigest : lastSegmentCRC(actualSize, m_header->crcDigest);
+        result[index] = (crc != expected);
+    }
+    return result;
+}
+
+} // namespace mmkv
+
+#endif // !MMKV_APPLE
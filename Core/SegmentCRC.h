@@ -0,0 +1,113 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MMKV_SEGMENTCRC_H
+#define MMKV_SEGMENTCRC_H
+#ifdef __cplusplus
+
+#include "MMKVPredef.h"
+
+#ifndef MMKV_APPLE
+
+#    include <cstdint>
+#    include <vector>
+
+namespace mmkv {
+
+// crc32 of every fixed-size segment of the data, saved in the spare space of the meta file (after MMKVMetaInfo)
+// the crc of the whole data is combined from the segments, so that a rewrite only checksums the segments it touches,
+// and a corrupted file can be partly recovered from the segments that are still good
+// the table is trusted only when its header matches the actual size & crc digest of the meta info
+// not thread-safe, it works on the meta file memory directly & the owner instance guards it with its own lock
+class SegmentCRCTable {
+    struct Header {
+        uint32_t crcDigest;
+        uint32_t actualSize;
+        uint32_t segmentShift;
+        uint32_t segmentCount;
+    };
+    struct Entry {
+        // crc32 of the segment, while the last one keeps the crc32 of all the data before it:
+        // an append within the last segment is then checksummed only once, for the whole digest
+        uint32_t crcDigest;
+        // offset of the first item that starts in this segment, or of the next item after it (or the actual size)
+        uint32_t firstItem;
+    };
+
+    Header *m_header;
+    Entry *m_entries;
+
+    size_t segmentLength(size_t index, size_t actualSize) const;
+    void coarsen(size_t count, size_t dataSize);
+    // the crc of the first [count] segments, which are all full
+    uint32_t combineSegments(size_t count) const;
+    // the crc of the last segment, derived from the crc digest of the whole data
+    uint32_t lastSegmentCRC(size_t actualSize, uint32_t crcDigest) const;
+
+public:
+    static constexpr size_t TableOffset = 1024;
+    static constexpr size_t TableSize = 3 * 1024;
+    static constexpr uint32_t MinSegmentShift = 16;
+    static constexpr size_t Capacity = (TableSize - sizeof(Header)) / sizeof(Entry);
+
+    // metaPtr is the memory of the meta file, which must be no less than (TableOffset + TableSize) bytes
+    explicit SegmentCRCTable(void *metaPtr);
+
+    bool isValid(size_t actualSize, uint32_t crcDigest) const;
+
+    // call it before changing any entry, so that a crash in the middle leaves the table untrusted
+    void invalidate();
+
+    // call it after the meta info has been written
+    void confirm(size_t actualSize, uint32_t crcDigest);
+
+    size_t segmentSize() const { return static_cast<size_t>(1) << m_header->segmentShift; }
+    size_t segmentCount() const { return m_header->segmentCount; }
+    uint32_t firstItem(size_t index) const { return m_entries[index].firstItem; }
+
+    // checksum everything from scratch, itemOffsets are the offsets of all items in ascending order
+    // return the crc digest of the whole data
+    uint32_t rebuild(const uint8_t *ptr, size_t actualSize, const std::vector<uint32_t> &itemOffsets);
+
+    // only the first segment & the bytes since dirtyStart have been changed, dirtyStart is the start of an item (or the
+    // end of data), itemOffsets are the offsets of items since dirtyStart
+    // return the crc digest of the whole data
+    uint32_t update(const uint8_t *ptr, size_t actualSize, size_t dirtyStart, const std::vector<uint32_t> &itemOffsets);
+
+    // items of [oldActualSize, actualSize) have been appended, only the first one of them is indexed
+    // crcDigest is the crc digest of the data before appending, return the one after
+    uint32_t append(const uint8_t *ptr, size_t oldActualSize, size_t actualSize, uint32_t crcDigest);
+
+    // segments whose crc don't match what's in the table
+    std::vector<bool> damagedSegments(const uint8_t *ptr, size_t actualSize) const;
+
+    // the crc32 of (A + B) from the crc32 of A & B, lengthB is the length of B
+    static uint32_t combine(uint32_t crcA, uint32_t crcB, size_t lengthB);
+
+    // just forbid it for possibly misuse
+    explicit SegmentCRCTable(const SegmentCRCTable &other) = delete;
+    SegmentCRCTable &operator=(const SegmentCRCTable &other) = delete;
+};
+
+} // namespace mmkv
+
+#endif // !MMKV_APPLE
+#endif // __cplusplus
+#endif // MMKV_SEGMENTCRC_H
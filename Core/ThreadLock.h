@@ -50,6 +50,8 @@ class ThreadLock {
 #else
     CRITICAL_SECTION m_lock;
 #endif
+    // how many times the owner thread holds it, only touched by the owner
+    size_t m_depth = 0;
 
 public:
     ThreadLock();
@@ -60,6 +62,11 @@ public:
     void lock();
     void unlock();
 
+    // let go of it however many times the calling thread holds it, return the count for relock()
+    // condition_variable_any only unlocks it once, which is not enough for a recursive lock
+    size_t unlockFully();
+    void relock(size_t depth);
+
 #ifndef MMKV_WIN32
     bool try_lock();
 #endif
@@ -44,12 +44,28 @@ void ThreadLock::initialize() {
 
 void ThreadLock::lock() {
     EnterCriticalSection(&m_lock);
+    m_depth++;
 }
 
 void ThreadLock::unlock() {
+    m_depth--;
     LeaveCriticalSection(&m_lock);
 }
 
+size_t ThreadLock::unlockFully() {
+    auto depth = m_depth;
+    for (size_t index = 0; index < depth; index++) {
+        unlock();
+    }
+    return depth;
+}
+
+void ThreadLock::relock(size_t depth) {
+    for (size_t index = 0; index < depth; index++) {
+        lock();
+    }
+}
+
 void ThreadLock::ThreadOnce(ThreadOnceToken_t *onceToken, void (*callback)()) {
     if (!onceToken || !callback) {
         assert(onceToken);
@@ -24,9 +24,15 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <mutex>
+#include <random>
 #include "../MMKVLog.h"
 #include "../MemoryFile.h"
 
+#ifdef MMKV_POSIX
+#    include <unistd.h>
+#endif
+
 namespace mmkv {
 
 // assuming size in [1, 5]
@@ -46,7 +52,8 @@ uint32_t AESCrypt::randomItemSizeHolder(uint32_t size) {
 
 using namespace openssl;
 
-AESCrypt::AESCrypt(const void *key, size_t keyLength, const void *iv, size_t ivLength) {
+AESCrypt::AESCrypt(const void *key, size_t keyLength, const void *iv, size_t ivLength, MMKVCryptMode mode)
+    : m_mode(mode) {
     if (key && keyLength > 0) {
         memcpy(m_key, key, (keyLength > AES_KEY_LEN) ? AES_KEY_LEN : keyLength);
 
@@ -59,8 +66,11 @@ AESCrypt::AESCrypt(const void *key, size_t keyLength, const void *iv, size_t ivL
     }
 }
 
-AESCrypt::AESCrypt(const AESCrypt &other, const AESCryptStatus &status) : m_isClone(true), m_number(status.m_number) {
-    //memcpy(m_key, other.m_key, sizeof(m_key));
+AESCrypt::AESCrypt(const AESCrypt &other, const AESCryptStatus &status)
+    : m_isClone(true), m_mode(other.m_mode), m_number(status.m_number) {
+    // the key is needed if the clone ever rolls back in CFB mode, see statusBeforeDecrypt()
+    memcpy(m_key, other.m_key, sizeof(m_key));
+    memcpy(m_initVector, other.m_initVector, sizeof(m_initVector));
     memcpy(m_vector, status.m_vector, sizeof(m_vector));
     m_aesKey = other.m_aesKey;
 }
@@ -68,8 +78,9 @@ AESCrypt::AESCrypt(const AESCrypt &other, const AESCryptStatus &status) : m_isCl
 AESCrypt::~AESCrypt() {
     if (!m_isClone) {
         delete m_aesKey;
-        delete m_aesRollbackKey;
     }
+    // never shared with clones
+    delete m_aesRollbackKey;
 }
 
 void AESCrypt::resetIV(const void *iv, size_t ivLength) {
@@ -79,6 +90,13 @@ void AESCrypt::resetIV(const void *iv, size_t ivLength) {
     } else {
         memcpy(m_vector, m_key, AES_KEY_LEN);
     }
+    memcpy(m_initVector, m_vector, AES_KEY_LEN);
+}
+
+void AESCrypt::setCryptMode(MMKVCryptMode mode) {
+    m_mode = mode;
+    m_number = 0;
+    memcpy(m_vector, m_initVector, AES_KEY_LEN);
 }
 
 void AESCrypt::resetStatus(const AESCryptStatus &status) {
@@ -96,6 +114,10 @@ void AESCrypt::encrypt(const void *input, void *output, size_t length) {
     if (!input || !output || length == 0) {
         return;
     }
+    if (m_mode == MMKVCryptCTR) {
+        AES_ctr128_encrypt((const uint8_t *) input, (uint8_t *) output, length, m_aesKey, m_vector, &m_number);
+        return;
+    }
     AES_cfb128_encrypt((const uint8_t *) input, (uint8_t *) output, length, m_aesKey, m_vector, &m_number);
 }
 
@@ -103,18 +125,67 @@ void AESCrypt::decrypt(const void *input, void *output, size_t length) {
     if (!input || !output || length == 0) {
         return;
     }
+    if (m_mode == MMKVCryptCTR) {
+        AES_ctr128_encrypt((const uint8_t *) input, (uint8_t *) output, length, m_aesKey, m_vector, &m_number);
+        return;
+    }
     AES_cfb128_decrypt((const uint8_t *) input, (uint8_t *) output, length, m_aesKey, m_vector, &m_number);
 }
 
+static inline int64_t currentProcessID() {
+#ifdef MMKV_WIN32
+    return static_cast<int64_t>(GetCurrentProcessId());
+#else
+    return static_cast<int64_t>(getpid());
+#endif
+}
+
+// every IV has to be unique, rand() seeded by time() repeats within a second,
+// while constructing a std::random_device on each call costs about 10 us.
+// so the random source is read once per process, to key an AES-128 in counter mode
+class RandomIVGenerator {
+    std::mutex m_lock;
+    AES_KEY m_key = {};
+    uint8_t m_counter[AES_KEY_LEN] = {};
+    // a forked child reseeds, or it repeats the IVs of its parent
+    int64_t m_pid = -1;
+
+    void reseedIfNeeded() {
+        auto pid = currentProcessID();
+        if (pid == m_pid) {
+            return;
+        }
+        std::random_device device;
+        uint32_t seed[AES_KEY_LEN * 2 / sizeof(uint32_t)];
+        for (auto &word : seed) {
+            word = static_cast<uint32_t>(device());
+        }
+        AES_set_encrypt_key((const uint8_t *) seed, AES_KEY_BITSET_LEN, &m_key);
+        memcpy(m_counter, (const uint8_t *) seed + AES_KEY_LEN, AES_KEY_LEN);
+        m_pid = pid;
+    }
+
+public:
+    void fill(void *vector) {
+        std::lock_guard<std::mutex> lock(m_lock);
+        reseedIfNeeded();
+        AES_encrypt(m_counter, (uint8_t *) vector, &m_key);
+        // a big-endian counter never repeats within a process
+        for (auto i = AES_KEY_LEN; i > 0; i--) {
+            if (++m_counter[i - 1] != 0) {
+                break;
+            }
+        }
+    }
+};
+
 void AESCrypt::fillRandomIV(void *vector) {
     if (!vector) {
         return;
     }
-    srand((unsigned) time(nullptr));
-    int *ptr = (int *) vector;
-    for (uint32_t i = 0; i < AES_KEY_LEN / sizeof(int); i++) {
-        ptr[i] = rand();
-    }
+    // never destructed, an IV might be filled during exit
+    static auto generator = new RandomIVGenerator();
+    generator->fill(vector);
 }
 
 static inline void
@@ -157,6 +228,18 @@ void AESCrypt::statusBeforeDecrypt(const void *input, const void *output, size_t
     if (length == 0) {
         return;
     }
+    if (m_mode == MMKVCryptCTR) {
+        // no need to decrypt anything, just rewind the counter
+        getCurStatus(status);
+        if (length <= m_number) {
+            status.m_number = static_cast<uint8_t>(m_number - length);
+        } else {
+            auto rollback = length - m_number;
+            AES_ctr128_sub(status.m_vector, (rollback + AES_KEY_LEN - 1) / AES_KEY_LEN);
+            status.m_number = static_cast<uint8_t>((AES_KEY_LEN - rollback % AES_KEY_LEN) % AES_KEY_LEN);
+        }
+        return;
+    }
     if (!m_aesRollbackKey) {
         m_aesRollbackKey = new AES_KEY;
         memset(m_aesRollbackKey, 0, sizeof(AES_KEY));
@@ -176,6 +259,31 @@ AESCrypt AESCrypt::cloneWithStatus(const AESCryptStatus &status) const {
     return AESCrypt(*this, status);
 }
 
+void AESCrypt::statusAtPosition(size_t position, AESCryptStatus &status, const void *cipherText) const {
+    auto block = position / AES_KEY_LEN;
+    status.m_number = static_cast<uint8_t>(position % AES_KEY_LEN);
+    if (isRandomAccess()) {
+        memcpy(status.m_vector, m_initVector, sizeof(status.m_vector));
+        AES_ctr128_add(status.m_vector, block);
+        return;
+    }
+    // CFB: the vector is the previous ciphertext block, encrypted & partly replaced once the block has been started
+    MMKV_ASSERT(cipherText || position == 0);
+    auto cipher = (const uint8_t *) cipherText;
+    auto previous = (block == 0) ? m_initVector : cipher + (block - 1) * AES_KEY_LEN;
+    if (status.m_number == 0) {
+        memcpy(status.m_vector, previous, sizeof(status.m_vector));
+    } else {
+        AES_encrypt(previous, status.m_vector, m_aesKey);
+        memcpy(status.m_vector, cipher + block * AES_KEY_LEN, status.m_number);
+    }
+}
+
+void AESCrypt::skipBlocks(size_t blocks) {
+    MMKV_ASSERT(isRandomAccess() && m_number == 0);
+    AES_ctr128_add(m_vector, blocks);
+}
+
 #    ifdef MMKV_DEBUG
 
 void testRandomPlaceHolder() {
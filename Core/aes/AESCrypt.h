@@ -54,13 +54,17 @@ struct AESCryptStatus {
 
 class CodedInputDataCrypt;
 
-// a AES CFB-128 encrypt-decrypt full-duplex wrapper
+// a AES CFB-128 (or CTR-128) encrypt-decrypt full-duplex wrapper
+// in CTR mode, m_vector is the counter of the current block, and m_number is the position inside it
 class AESCrypt {
     bool m_isClone = false;
+    MMKVCryptMode m_mode = MMKVCryptCFB;
     uint32_t m_number = 0;
     openssl::AES_KEY *m_aesKey = nullptr;
     openssl::AES_KEY *m_aesRollbackKey = nullptr;
     uint8_t m_key[AES_KEY_LEN] = {};
+    // the initial counter of CTR mode
+    uint8_t m_initVector[AES_KEY_LEN] = {};
 
 public:
     uint8_t m_vector[AES_KEY_LEN] = {};
@@ -70,7 +74,8 @@ private:
     AESCrypt(const AESCrypt &other, const AESCryptStatus &status);
 
 public:
-    AESCrypt(const void *key, size_t keyLength, const void *iv = nullptr, size_t ivLength = 0);
+    AESCrypt(const void *key, size_t keyLength, const void *iv = nullptr, size_t ivLength = 0,
+             MMKVCryptMode mode = MMKVCryptCFB);
     AESCrypt(AESCrypt &&other) = default;
 
     ~AESCrypt();
@@ -84,6 +89,18 @@ public:
 
     AESCrypt cloneWithStatus(const AESCryptStatus &status) const;
 
+    MMKVCryptMode cryptMode() const { return m_mode; }
+    // the mode can only be changed before any encryption/decryption, it also resets IV
+    void setCryptMode(MMKVCryptMode mode);
+
+    // whether any position can be decrypted without decrypting anything before it
+    bool isRandomAccess() const { return m_mode == MMKVCryptCTR; }
+    // the status of [position] bytes after the IV
+    // CFB mode needs the ciphertext (from the very beginning) of the previous block & the current partial block
+    void statusAtPosition(size_t position, AESCryptStatus &status, const void *cipherText = nullptr) const;
+    // random access only, skip some blocks without decrypting them, must be aligned to a block
+    void skipBlocks(size_t blocks);
+
     void resetIV(const void *iv = nullptr, size_t ivLength = 0);
     void resetStatus(const AESCryptStatus &status);
 
@@ -41,8 +41,23 @@ struct AES_KEY {
 void AES_cfb128_encrypt(const uint8_t *in, uint8_t *out, size_t length, const AES_KEY *key, uint8_t *ivec, uint32_t *num);
 void AES_cfb128_decrypt(const uint8_t *in, uint8_t *out, size_t length, const AES_KEY *key, uint8_t *ivec, uint32_t *num);
 
+/*
+ * ivec is the counter of the current block, num is the position inside it.
+ * Encryption & decryption are the same, and ivec is increased by 1 (as a big endian number) per block.
+ */
+void AES_ctr128_encrypt(const uint8_t *in, uint8_t *out, size_t length, const AES_KEY *key, uint8_t *ivec, uint32_t *num);
+// ivec += blocks, as a 128 bits big endian number
+void AES_ctr128_add(uint8_t *ivec, uint64_t blocks);
+// ivec -= blocks, as a 128 bits big endian number
+void AES_ctr128_sub(uint8_t *ivec, uint64_t blocks);
+
 } // namespace openssl
 
+// AES-NI (and VAES where available) on x86-64, selected by cpuid at runtime, not for Apple yet
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(MMKV_APPLE) && !defined(MMKV_DISABLE_AES_NI)
+#define MMKV_USE_AES_NI
+#endif
+
 #if __ARM_MAX_ARCH__ > 7
 
 extern "C" int openssl_aes_arm_set_encrypt_key(const uint8_t *userKey, const int bits, void *key);
@@ -80,7 +95,51 @@ extern aes_decrypt_t AES_decrypt;
 
 #endif // __linux__ && !MMKV_OHOS
 
-#else // __ARM_MAX_ARCH__ <= 7
+#elif defined(MMKV_USE_AES_NI)
+
+typedef int (*aes_set_encrypt_t)(const uint8_t *userKey, const int bits, void *key);
+typedef int (*aes_set_decrypt_t)(const uint8_t *userKey, const int bits, void *key);
+typedef void (*aes_encrypt_t)(const uint8_t *in, uint8_t *out, const void *key);
+typedef void (*aes_decrypt_t)(const uint8_t *in, uint8_t *out, const void *key);
+// decrypt whole blocks in cfb128 mode, ivec is updated to the last cipher block
+typedef void (*aes_cfb128_decrypt_blocks_t)(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec);
+// encrypt/decrypt whole blocks in ctr128 mode, ivec is increased by blocks
+typedef void (*aes_ctr128_encrypt_blocks_t)(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec);
+
+namespace openssl {
+
+int AES_C_set_encrypt_key(const uint8_t *userKey, const int bits, void *key);
+int AES_C_set_decrypt_key(const uint8_t *userKey, const int bits, void *key);
+void AES_C_encrypt(const uint8_t *in, uint8_t *out, const void *key);
+void AES_C_decrypt(const uint8_t *in, uint8_t *out, const void *key);
+
+enum AESNICapability : int {
+    AESNINotSupported = 0,
+    AESNISupported = 1,
+    AESNIWithVAESSupported = 2,
+};
+AESNICapability AES_NI_capability();
+
+int AES_NI_set_encrypt_key(const uint8_t *userKey, const int bits, void *key);
+int AES_NI_set_decrypt_key(const uint8_t *userKey, const int bits, void *key);
+void AES_NI_encrypt(const uint8_t *in, uint8_t *out, const void *key);
+void AES_NI_decrypt(const uint8_t *in, uint8_t *out, const void *key);
+void AES_NI_cfb128_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec);
+void AES_VAES_cfb128_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec);
+void AES_NI_ctr128_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec);
+void AES_VAES_ctr128_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec);
+
+extern aes_set_encrypt_t AES_set_encrypt_key;
+extern aes_set_decrypt_t AES_set_decrypt_key;
+extern aes_encrypt_t AES_encrypt;
+extern aes_decrypt_t AES_decrypt;
+// nullptr if there's no multi-block implementation
+extern aes_cfb128_decrypt_blocks_t AES_cfb128_decrypt_blocks;
+extern aes_ctr128_encrypt_blocks_t AES_ctr128_encrypt_blocks;
+
+} // namespace openssl
+
+#else // __ARM_MAX_ARCH__ <= 7 && !MMKV_USE_AES_NI
 
 namespace openssl {
 
@@ -91,7 +150,7 @@ void AES_decrypt(const uint8_t *in, uint8_t *out, const AES_KEY *key);
 
 } // namespace openssl
 
-#endif // __ARM_MAX_ARCH__ <= 7
+#endif // __ARM_MAX_ARCH__ <= 7 && !MMKV_USE_AES_NI
 
 #endif // MMKV_DISABLE_CRYPT
 #endif // __cplusplus
@@ -54,6 +54,17 @@ aes_encrypt_t AES_decrypt = openssl::AES_C_decrypt;
 
 #endif // (__ARM_MAX_ARCH__ > 7 && defined(__linux__) && !defined(MMKV_OHOS)
 
+#if (__ARM_MAX_ARCH__ <= 7) && defined(MMKV_USE_AES_NI)
+
+aes_set_encrypt_t AES_set_encrypt_key = openssl::AES_C_set_encrypt_key;
+aes_set_decrypt_t AES_set_decrypt_key = openssl::AES_C_set_decrypt_key;
+aes_encrypt_t AES_encrypt = openssl::AES_C_encrypt;
+aes_decrypt_t AES_decrypt = openssl::AES_C_decrypt;
+aes_cfb128_decrypt_blocks_t AES_cfb128_decrypt_blocks = nullptr;
+aes_ctr128_encrypt_blocks_t AES_ctr128_encrypt_blocks = nullptr;
+
+#endif // (__ARM_MAX_ARCH__ <= 7) && defined(MMKV_USE_AES_NI)
+
 #if (__ARM_MAX_ARCH__ <= 7) || (defined(__linux__) && !defined(MMKV_OHOS))
 
 /*-
@@ -640,7 +651,7 @@ static const u32 rcon[] = {
 /**
  * Expand the cipher key into the encryption key schedule.
  */
-#if (__ARM_MAX_ARCH__ <= 7)
+#if (__ARM_MAX_ARCH__ <= 7) && !defined(MMKV_USE_AES_NI)
 int AES_set_encrypt_key(const uint8_t *userKey, const int bits, AES_KEY *key) {
 #else
 int AES_C_set_encrypt_key(const uint8_t *userKey, const int bits, void *k) {
@@ -744,7 +755,7 @@ int AES_C_set_encrypt_key(const uint8_t *userKey, const int bits, void *k) {
 /**
  * Expand the cipher key into the decryption key schedule.
  */
-#if (__ARM_MAX_ARCH__ <= 7)
+#if (__ARM_MAX_ARCH__ <= 7) && !defined(MMKV_USE_AES_NI)
 int AES_set_decrypt_key(const uint8_t *userKey, const int bits, AES_KEY *key) {
 #else
 int AES_C_set_decrypt_key(const uint8_t *userKey, const int bits, void *k) {
@@ -800,7 +811,7 @@ int AES_C_set_decrypt_key(const uint8_t *userKey, const int bits, void *k) {
  * Encrypt a single block
  * in and out can overlap
  */
-#if (__ARM_MAX_ARCH__ <= 7)
+#if (__ARM_MAX_ARCH__ <= 7) && !defined(MMKV_USE_AES_NI)
 void AES_encrypt(const uint8_t *in, uint8_t *out, const AES_KEY *key) {
 #else
 void AES_C_encrypt(const uint8_t *in, uint8_t *out, const void *k) {
@@ -920,7 +931,7 @@ void AES_C_encrypt(const uint8_t *in, uint8_t *out, const void *k) {
  * Decrypt a single block
  * in and out can overlap
  */
-#if (__ARM_MAX_ARCH__ <= 7)
+#if (__ARM_MAX_ARCH__ <= 7) && !defined(MMKV_USE_AES_NI)
 void AES_decrypt(const uint8_t *in, uint8_t *out, const AES_KEY *key) {
 #else
 void AES_C_decrypt(const uint8_t *in, uint8_t *out, const void *k) {
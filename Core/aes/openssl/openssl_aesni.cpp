@@ -0,0 +1,384 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "openssl_aes.h"
+
+#if !defined(MMKV_DISABLE_CRYPT) && defined(MMKV_USE_AES_NI) && (__ARM_MAX_ARCH__ <= 7)
+
+#    include <immintrin.h>
+#    include <wmmintrin.h>
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#        define MMKV_TARGET(features)
+#    else
+#        include <cpuid.h>
+#        define MMKV_TARGET(features) __attribute__((target(features)))
+#    endif
+
+namespace openssl {
+
+static inline uint32_t byteSwap32(uint32_t value) {
+    return ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00) | (value >> 24);
+}
+
+// the round keys are stored as plain bytes in AES_KEY::rd_key, the same layout aesenc/aesdec takes
+static inline const __m128i *roundKeys(const void *key) {
+    return (const __m128i *) ((const AES_KEY *) key)->rd_key;
+}
+
+AESNICapability AES_NI_capability() {
+    uint32_t eax = 0, ebx = 0, ecx = 0, edx = 0;
+#    ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    auto maxLeaf = (uint32_t) regs[0];
+    __cpuid(regs, 1);
+    ecx = (uint32_t) regs[2];
+#    else
+    auto maxLeaf = __get_cpuid_max(0, nullptr);
+    if (maxLeaf < 1 || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return AESNINotSupported;
+    }
+#    endif
+    constexpr uint32_t AESBit = 1u << 25, OSXSaveBit = 1u << 27, AVXBit = 1u << 28;
+    if (!(ecx & AESBit)) {
+        return AESNINotSupported;
+    }
+    if (maxLeaf < 7 || (ecx & (OSXSaveBit | AVXBit)) != (OSXSaveBit | AVXBit)) {
+        return AESNISupported;
+    }
+    // the OS must save the YMM registers on context switching
+#    ifdef _MSC_VER
+    auto xcr0 = (uint32_t) _xgetbv(0);
+    __cpuidex(regs, 7, 0);
+    ebx = (uint32_t) regs[1];
+    ecx = (uint32_t) regs[2];
+#    else
+    uint32_t xcr0 = 0, xcr0High = 0;
+    __asm__ volatile("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+#    endif
+    constexpr uint32_t AVX2Bit = 1u << 5, VAESBit = 1u << 9;
+    if ((xcr0 & 0x6) == 0x6 && (ebx & AVX2Bit) && (ecx & VAESBit)) {
+        return AESNIWithVAESSupported;
+    }
+    return AESNISupported;
+}
+
+#    define AES_128_KEY_EXPAND(rk, i, rcon) rk[i] = expandKey128(rk[i - 1], _mm_aeskeygenassist_si128(rk[i - 1], rcon))
+
+MMKV_TARGET("aes")
+static inline __m128i expandKey128(__m128i key, __m128i keygened) {
+    keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3, 3, 3, 3));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, keygened);
+}
+
+MMKV_TARGET("aes")
+int AES_NI_set_encrypt_key(const uint8_t *userKey, const int bits, void *k) {
+    if (!userKey || !k) {
+        return -1;
+    }
+    auto key = (AES_KEY *) k;
+    if (bits != 128) {
+        // MMKV only uses 128 bits keys, the others are converted from the C key schedule,
+        // whose round key words are stored in big endian
+        int ret = AES_C_set_encrypt_key(userKey, bits, key);
+        if (ret == 0) {
+            for (int i = 0; i < 4 * (key->rounds + 1); i++) {
+                key->rd_key[i] = byteSwap32(key->rd_key[i]);
+            }
+        }
+        return ret;
+    }
+    __m128i rk[11];
+    rk[0] = _mm_loadu_si128((const __m128i *) userKey);
+    AES_128_KEY_EXPAND(rk, 1, 0x01);
+    AES_128_KEY_EXPAND(rk, 2, 0x02);
+    AES_128_KEY_EXPAND(rk, 3, 0x04);
+    AES_128_KEY_EXPAND(rk, 4, 0x08);
+    AES_128_KEY_EXPAND(rk, 5, 0x10);
+    AES_128_KEY_EXPAND(rk, 6, 0x20);
+    AES_128_KEY_EXPAND(rk, 7, 0x40);
+    AES_128_KEY_EXPAND(rk, 8, 0x80);
+    AES_128_KEY_EXPAND(rk, 9, 0x1b);
+    AES_128_KEY_EXPAND(rk, 10, 0x36);
+    auto output = (__m128i *) key->rd_key;
+    for (int i = 0; i <= 10; i++) {
+        _mm_storeu_si128(output + i, rk[i]);
+    }
+    key->rounds = 10;
+    return 0;
+}
+
+// the equivalent inverse cipher: round keys in reverse order, InvMixColumns applied to all but the first & last
+MMKV_TARGET("aes")
+int AES_NI_set_decrypt_key(const uint8_t *userKey, const int bits, void *k) {
+    AES_KEY encryptKey;
+    int ret = AES_NI_set_encrypt_key(userKey, bits, &encryptKey);
+    if (ret != 0) {
+        return ret;
+    }
+    auto key = (AES_KEY *) k;
+    auto rounds = encryptKey.rounds;
+    auto input = roundKeys(&encryptKey);
+    auto output = (__m128i *) key->rd_key;
+    _mm_storeu_si128(output, _mm_loadu_si128(input + rounds));
+    for (int i = 1; i < rounds; i++) {
+        _mm_storeu_si128(output + i, _mm_aesimc_si128(_mm_loadu_si128(input + rounds - i)));
+    }
+    _mm_storeu_si128(output + rounds, _mm_loadu_si128(input));
+    key->rounds = rounds;
+    return 0;
+}
+
+MMKV_TARGET("aes")
+void AES_NI_encrypt(const uint8_t *in, uint8_t *out, const void *key) {
+    auto rk = roundKeys(key);
+    auto rounds = ((const AES_KEY *) key)->rounds;
+    auto block = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in), _mm_loadu_si128(rk));
+    for (int i = 1; i < rounds; i++) {
+        block = _mm_aesenc_si128(block, _mm_loadu_si128(rk + i));
+    }
+    block = _mm_aesenclast_si128(block, _mm_loadu_si128(rk + rounds));
+    _mm_storeu_si128((__m128i *) out, block);
+}
+
+MMKV_TARGET("aes")
+void AES_NI_decrypt(const uint8_t *in, uint8_t *out, const void *key) {
+    auto rk = roundKeys(key);
+    auto rounds = ((const AES_KEY *) key)->rounds;
+    auto block = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in), _mm_loadu_si128(rk));
+    for (int i = 1; i < rounds; i++) {
+        block = _mm_aesdec_si128(block, _mm_loadu_si128(rk + i));
+    }
+    block = _mm_aesdeclast_si128(block, _mm_loadu_si128(rk + rounds));
+    _mm_storeu_si128((__m128i *) out, block);
+}
+
+/*
+ * Unlike encryption, cfb128 decryption is parallelizable:
+ * the key stream of block i is AES(C[i-1]), and all the cipher blocks are known ahead.
+ * All the input of a batch is loaded before any output is stored, so decrypting in place is fine.
+ */
+constexpr size_t AESNIBatchBlocks = 8;
+
+MMKV_TARGET("aes")
+void AES_NI_cfb128_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec) {
+    auto rk = roundKeys(key);
+    auto rounds = ((const AES_KEY *) key)->rounds;
+    auto iv = _mm_loadu_si128((const __m128i *) ivec);
+    auto input = (const __m128i *) in;
+    auto output = (__m128i *) out;
+
+    for (; blocks >= AESNIBatchBlocks; blocks -= AESNIBatchBlocks) {
+        __m128i cipher[AESNIBatchBlocks], stream[AESNIBatchBlocks];
+        for (size_t i = 0; i < AESNIBatchBlocks; i++) {
+            cipher[i] = _mm_loadu_si128(input + i);
+        }
+        auto rk0 = _mm_loadu_si128(rk);
+        stream[0] = _mm_xor_si128(iv, rk0);
+        for (size_t i = 1; i < AESNIBatchBlocks; i++) {
+            stream[i] = _mm_xor_si128(cipher[i - 1], rk0);
+        }
+        for (int r = 1; r < rounds; r++) {
+            auto rki = _mm_loadu_si128(rk + r);
+            for (size_t i = 0; i < AESNIBatchBlocks; i++) {
+                stream[i] = _mm_aesenc_si128(stream[i], rki);
+            }
+        }
+        auto rkLast = _mm_loadu_si128(rk + rounds);
+        for (size_t i = 0; i < AESNIBatchBlocks; i++) {
+            stream[i] = _mm_aesenclast_si128(stream[i], rkLast);
+            _mm_storeu_si128(output + i, _mm_xor_si128(stream[i], cipher[i]));
+        }
+        iv = cipher[AESNIBatchBlocks - 1];
+        input += AESNIBatchBlocks;
+        output += AESNIBatchBlocks;
+    }
+    for (; blocks > 0; blocks--) {
+        auto cipher = _mm_loadu_si128(input);
+        auto stream = _mm_xor_si128(iv, _mm_loadu_si128(rk));
+        for (int r = 1; r < rounds; r++) {
+            stream = _mm_aesenc_si128(stream, _mm_loadu_si128(rk + r));
+        }
+        stream = _mm_aesenclast_si128(stream, _mm_loadu_si128(rk + rounds));
+        _mm_storeu_si128(output, _mm_xor_si128(stream, cipher));
+        iv = cipher;
+        input++;
+        output++;
+    }
+    _mm_storeu_si128((__m128i *) ivec, iv);
+}
+
+// whether the lower 64 bits of the counter won't overflow after [blocks] increments
+static inline bool isCounterAddFast(const uint8_t *ivec, size_t blocks) {
+    uint64_t low = 0;
+    for (int i = 8; i < 16; i++) {
+        low = (low << 8) | ivec[i];
+    }
+    return low + blocks >= low;
+}
+
+// all the counters of a batch are prepared ahead, so the blocks are pipelined just like cfb128 decryption
+// the counters are kept in little endian, with only the lower 64 bits increased
+MMKV_TARGET("aes,ssse3")
+void AES_NI_ctr128_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec) {
+    if (!isCounterAddFast(ivec, blocks)) {
+        for (; blocks > 0; blocks--, in += 16, out += 16) {
+            uint8_t ecount[16];
+            AES_NI_encrypt(ivec, ecount, key);
+            for (int i = 0; i < 16; i++) {
+                out[i] = in[i] ^ ecount[i];
+            }
+            AES_ctr128_add(ivec, 1);
+        }
+        return;
+    }
+    auto rk = roundKeys(key);
+    auto rounds = ((const AES_KEY *) key)->rounds;
+    auto input = (const __m128i *) in;
+    auto output = (__m128i *) out;
+    const auto byteSwap = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const auto one = _mm_set_epi64x(0, 1);
+    auto counter = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) ivec), byteSwap);
+
+    while (blocks > 0) {
+        auto batch = (blocks >= AESNIBatchBlocks) ? AESNIBatchBlocks : blocks;
+        __m128i stream[AESNIBatchBlocks];
+        auto rk0 = _mm_loadu_si128(rk);
+        for (size_t i = 0; i < batch; i++) {
+            stream[i] = _mm_xor_si128(_mm_shuffle_epi8(counter, byteSwap), rk0);
+            counter = _mm_add_epi64(counter, one);
+        }
+        for (int r = 1; r < rounds; r++) {
+            auto rki = _mm_loadu_si128(rk + r);
+            for (size_t i = 0; i < batch; i++) {
+                stream[i] = _mm_aesenc_si128(stream[i], rki);
+            }
+        }
+        auto rkLast = _mm_loadu_si128(rk + rounds);
+        for (size_t i = 0; i < batch; i++) {
+            stream[i] = _mm_aesenclast_si128(stream[i], rkLast);
+            _mm_storeu_si128(output + i, _mm_xor_si128(stream[i], _mm_loadu_si128(input + i)));
+        }
+        input += batch;
+        output += batch;
+        blocks -= batch;
+    }
+    _mm_storeu_si128((__m128i *) ivec, _mm_shuffle_epi8(counter, byteSwap));
+}
+
+// two blocks per YMM register, 16 blocks per batch
+constexpr size_t VAESBatchRegisters = 8;
+constexpr size_t VAESBatchBlocks = VAESBatchRegisters * 2;
+
+MMKV_TARGET("aes,avx2,vaes")
+void AES_VAES_cfb128_decrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec) {
+    auto rk = roundKeys(key);
+    auto rounds = ((const AES_KEY *) key)->rounds;
+
+    while (blocks >= VAESBatchBlocks) {
+        __m256i cipher[VAESBatchRegisters], stream[VAESBatchRegisters];
+        for (size_t i = 0; i < VAESBatchRegisters; i++) {
+            cipher[i] = _mm256_loadu_si256((const __m256i *) (in + i * 32));
+        }
+        auto rk0 = _mm256_broadcastsi128_si256(_mm_loadu_si128(rk));
+        // the previous cipher blocks of (C[0], C[1]) are (IV, C[0]), then they are just the input shifted by one block
+        auto previous = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) ivec)),
+                                                _mm_loadu_si128((const __m128i *) in), 1);
+        stream[0] = _mm256_xor_si256(previous, rk0);
+        for (size_t i = 1; i < VAESBatchRegisters; i++) {
+            previous = _mm256_loadu_si256((const __m256i *) (in + i * 32 - 16));
+            stream[i] = _mm256_xor_si256(previous, rk0);
+        }
+        for (int r = 1; r < rounds; r++) {
+            auto rki = _mm256_broadcastsi128_si256(_mm_loadu_si128(rk + r));
+            for (size_t i = 0; i < VAESBatchRegisters; i++) {
+                stream[i] = _mm256_aesenc_epi128(stream[i], rki);
+            }
+        }
+        auto lastCipher = _mm256_extracti128_si256(cipher[VAESBatchRegisters - 1], 1);
+        auto rkLast = _mm256_broadcastsi128_si256(_mm_loadu_si128(rk + rounds));
+        for (size_t i = 0; i < VAESBatchRegisters; i++) {
+            stream[i] = _mm256_aesenclast_epi128(stream[i], rkLast);
+            _mm256_storeu_si256((__m256i *) (out + i * 32), _mm256_xor_si256(stream[i], cipher[i]));
+        }
+        _mm_storeu_si128((__m128i *) ivec, lastCipher);
+        in += VAESBatchBlocks * 16;
+        out += VAESBatchBlocks * 16;
+        blocks -= VAESBatchBlocks;
+    }
+    if (blocks > 0) {
+        AES_NI_cfb128_decrypt_blocks(in, out, blocks, key, ivec);
+    }
+}
+
+MMKV_TARGET("aes,avx2,vaes")
+void AES_VAES_ctr128_encrypt_blocks(const uint8_t *in, uint8_t *out, size_t blocks, const void *key, uint8_t *ivec) {
+    if (blocks < VAESBatchBlocks || !isCounterAddFast(ivec, blocks)) {
+        AES_NI_ctr128_encrypt_blocks(in, out, blocks, key, ivec);
+        return;
+    }
+    auto rk = roundKeys(key);
+    auto rounds = ((const AES_KEY *) key)->rounds;
+    const auto byteSwap = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                           15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    const auto two = _mm256_set_epi64x(0, 2, 0, 2);
+    // (counter, counter + 1) in little endian
+    auto counter128 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) ivec),
+                                       _mm256_castsi256_si128(byteSwap));
+    auto counter = _mm256_add_epi64(_mm256_broadcastsi128_si256(counter128), _mm256_set_epi64x(0, 1, 0, 0));
+
+    while (blocks >= VAESBatchBlocks) {
+        __m256i stream[VAESBatchRegisters];
+        auto rk0 = _mm256_broadcastsi128_si256(_mm_loadu_si128(rk));
+        for (size_t i = 0; i < VAESBatchRegisters; i++) {
+            stream[i] = _mm256_xor_si256(_mm256_shuffle_epi8(counter, byteSwap), rk0);
+            counter = _mm256_add_epi64(counter, two);
+        }
+        for (int r = 1; r < rounds; r++) {
+            auto rki = _mm256_broadcastsi128_si256(_mm_loadu_si128(rk + r));
+            for (size_t i = 0; i < VAESBatchRegisters; i++) {
+                stream[i] = _mm256_aesenc_epi128(stream[i], rki);
+            }
+        }
+        auto rkLast = _mm256_broadcastsi128_si256(_mm_loadu_si128(rk + rounds));
+        for (size_t i = 0; i < VAESBatchRegisters; i++) {
+            stream[i] = _mm256_aesenclast_epi128(stream[i], rkLast);
+            auto input = _mm256_loadu_si256((const __m256i *) (in + i * 32));
+            _mm256_storeu_si256((__m256i *) (out + i * 32), _mm256_xor_si256(stream[i], input));
+        }
+        in += VAESBatchBlocks * 16;
+        out += VAESBatchBlocks * 16;
+        blocks -= VAESBatchBlocks;
+    }
+    // the lower lane is the next counter
+    _mm_storeu_si128((__m128i *) ivec, _mm_shuffle_epi8(_mm256_castsi256_si128(counter), _mm256_castsi256_si128(byteSwap)));
+    if (blocks > 0) {
+        AES_NI_ctr128_encrypt_blocks(in, out, blocks, key, ivec);
+    }
+}
+
+} // namespace openssl
+
+#endif // !MMKV_DISABLE_CRYPT && MMKV_USE_AES_NI && (__ARM_MAX_ARCH__ <= 7)
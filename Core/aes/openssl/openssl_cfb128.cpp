@@ -67,6 +67,16 @@ void AES_cfb128_decrypt(const uint8_t *in, uint8_t *out, size_t len, const AES_K
         --len;
         n = (n + 1) % 16;
     }
+#if defined(MMKV_USE_AES_NI) && (__ARM_MAX_ARCH__ <= 7)
+    // n is always 0 here unless len is 0
+    if (AES_cfb128_decrypt_blocks && len >= 16) {
+        auto blocks = len / 16;
+        AES_cfb128_decrypt_blocks(in, out, blocks, key, ivec);
+        len -= blocks * 16;
+        out += blocks * 16;
+        in += blocks * 16;
+    }
+#endif
     while (len >= 16) {
         AES_encrypt(ivec, ivec, key);
         for (; n < 16; n += sizeof(size_t)) {
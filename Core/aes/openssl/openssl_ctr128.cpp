@@ -0,0 +1,95 @@
+/*
+ * Copyright 2008-2016 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the OpenSSL license (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include "openssl_aes.h"
+#include "../../MMKVPredef.h"
+#include <cstring>
+
+#ifndef  MMKV_DISABLE_CRYPT
+
+namespace openssl {
+
+void AES_ctr128_add(uint8_t *ivec, uint64_t blocks)
+{
+    for (int n = 15; n >= 0 && blocks; --n) {
+        uint64_t c = ivec[n] + (blocks & 0xff);
+        ivec[n] = static_cast<uint8_t>(c);
+        blocks = (blocks >> 8) + (c >> 8);
+    }
+}
+
+void AES_ctr128_sub(uint8_t *ivec, uint64_t blocks)
+{
+    for (int n = 15; n >= 0 && blocks; --n) {
+        uint64_t b = blocks & 0xff;
+        uint64_t borrow = ivec[n] < b ? 1 : 0;
+        ivec[n] = static_cast<uint8_t>(ivec[n] - b);
+        blocks = (blocks >> 8) + borrow;
+    }
+}
+
+/*
+ * Unlike OpenSSL's CRYPTO_ctr128_encrypt(), the key stream of the current block is not kept,
+ * it's recalculated from ivec if we start in the middle of a block.
+ * That way the status is just (ivec, num), and it can be calculated from the position alone.
+ */
+void AES_ctr128_encrypt(const uint8_t *in, uint8_t *out, size_t len, const AES_KEY *key, uint8_t ivec[16], uint32_t *num)
+{
+    auto n = *num;
+    uint8_t ecount[16];
+
+    if (n && len) {
+        AES_encrypt(ivec, ecount, key);
+        while (n && len) {
+            *(out++) = *(in++) ^ ecount[n];
+            --len;
+            n = (n + 1) % 16;
+        }
+        if (n == 0) {
+            AES_ctr128_add(ivec, 1);
+        }
+    }
+#if defined(MMKV_USE_AES_NI) && (__ARM_MAX_ARCH__ <= 7)
+    if (AES_ctr128_encrypt_blocks && len >= 16) {
+        auto blocks = len / 16;
+        AES_ctr128_encrypt_blocks(in, out, blocks, key, ivec);
+        len -= blocks * 16;
+        out += blocks * 16;
+        in += blocks * 16;
+    }
+#endif
+    while (len >= 16) {
+        AES_encrypt(ivec, ecount, key);
+        for (n = 0; n < 16; n += sizeof(size_t)) {
+            size_t t, e;
+            memcpy(&t, in + n, sizeof(t));
+            memcpy(&e, ecount + n, sizeof(e));
+            t ^= e;
+            memcpy(out + n, &t, sizeof(t));
+        }
+        AES_ctr128_add(ivec, 1);
+        len -= 16;
+        out += 16;
+        in += 16;
+        n = 0;
+    }
+    if (len) {
+        AES_encrypt(ivec, ecount, key);
+        while (len--) {
+            out[n] = in[n] ^ ecount[n];
+            ++n;
+        }
+    }
+
+    *num = n;
+}
+
+} // namespace openssl
+
+#endif //  MMKV_DISABLE_CRYPT
@@ -66,6 +66,20 @@ typedef uint32_t (*CRC32_Func_t)(uint32_t crc, const uint8_t *buf, size_t len);
 extern CRC32_Func_t CRC32;
 #   endif
 
+#elif (defined(__x86_64__) || defined(_M_X64)) && !defined(MMKV_APPLE) && !defined(MMKV_DISABLE_PCLMUL_CRC32)
+
+#    define MMKV_USE_PCLMUL_CRC32
+
+namespace mmkv {
+// folding with carry-less multiplication, requires PCLMULQDQ & SSE4.1
+uint32_t pclmul_crc32(uint32_t crc, const uint8_t *buf, size_t len);
+bool pclmul_crc32_supported();
+}
+
+// have to check CPU's instruction set dynamically
+typedef uint32_t (*CRC32_Func_t)(uint32_t crc, const uint8_t *buf, size_t len);
+extern CRC32_Func_t CRC32;
+
 #else // defined(__aarch64__) && defined(__linux__)
 
 #    define CRC32(crc, buf, len) ZLIB_CRC32(crc, buf, len)
@@ -0,0 +1,157 @@
+/*
+ * Tencent is pleased to support the open source community by making
+ * MMKV available.
+ *
+ * Copyright (C) 2025 THL A29 Limited, a Tencent company.
+ * All rights reserved.
+ *
+ * Licensed under the BSD 3-Clause License (the "License"); you may not use
+ * this file except in compliance with the License. You may obtain a copy of
+ * the License at
+ *
+ *       https://opensource.org/licenses/BSD-3-Clause
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Checksum.h"
+
+#ifdef MMKV_USE_PCLMUL_CRC32
+
+#    include <immintrin.h>
+#    include <wmmintrin.h>
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#        define MMKV_TARGET(features)
+#    else
+#        include <cpuid.h>
+#        define MMKV_TARGET(features) __attribute__((target(features)))
+#    endif
+
+static inline uint32_t _crc32Wrap(uint32_t crc, const uint8_t *buf, size_t len) {
+    return static_cast<uint32_t>(ZLIB_CRC32(crc, buf, len));
+}
+
+CRC32_Func_t CRC32 = _crc32Wrap;
+
+namespace mmkv {
+
+bool pclmul_crc32_supported() {
+    uint32_t ecx = 0;
+#    ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 1) {
+        return false;
+    }
+    __cpuid(regs, 1);
+    ecx = (uint32_t) regs[2];
+#    else
+    uint32_t eax = 0, ebx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+#    endif
+    constexpr uint32_t PCLMULBit = 1u << 1, SSE41Bit = 1u << 19;
+    return (ecx & (PCLMULBit | SSE41Bit)) == (PCLMULBit | SSE41Bit);
+}
+
+MMKV_TARGET("pclmul,sse4.1") static inline __m128i fold128(__m128i x, __m128i next, __m128i k) {
+    auto lo = _mm_clmulepi64_si128(x, k, 0x00);
+    auto hi = _mm_clmulepi64_si128(x, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(hi, next), lo);
+}
+
+// fold 4 x 128 bits at a time, then reduce to 32 bits with Barrett reduction
+// constants of the bit-reflected polynomial 0x04C11DB7 are from Intel's paper:
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+// len must be a multiple of 16 and no less than 64, crc is not inverted here
+MMKV_TARGET("pclmul,sse4.1") static uint32_t pclmul_crc32_blocks(uint32_t crc, const uint8_t *buf, size_t len) {
+    const auto k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const auto k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const auto k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+    const auto poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const auto mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+    auto x1 = _mm_loadu_si128((const __m128i *) (buf + 0x00));
+    auto x2 = _mm_loadu_si128((const __m128i *) (buf + 0x10));
+    auto x3 = _mm_loadu_si128((const __m128i *) (buf + 0x20));
+    auto x4 = _mm_loadu_si128((const __m128i *) (buf + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int) crc));
+    buf += 64;
+    len -= 64;
+
+    // parallel folding 4 lanes of 128 bits
+    while (len >= 64) {
+        auto x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+        auto x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+        auto x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+        auto x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *) (buf + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *) (buf + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *) (buf + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *) (buf + 0x30)));
+
+        buf += 64;
+        len -= 64;
+    }
+
+    // fold the 4 lanes into one
+    x1 = fold128(x1, x2, k3k4);
+    x1 = fold128(x1, x3, k3k4);
+    x1 = fold128(x1, x4, k3k4);
+
+    // the rest 128 bits blocks
+    while (len >= 16) {
+        x1 = fold128(x1, _mm_loadu_si128((const __m128i *) buf), k3k4);
+        buf += 16;
+        len -= 16;
+    }
+
+    // 128 bits to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t) _mm_extract_epi32(x1, 1);
+}
+
+// short buffers are not worth the setup
+constexpr size_t PCLMULMinimalLength = 64;
+
+uint32_t pclmul_crc32(uint32_t crc, const uint8_t *buf, size_t len) {
+    if (len < PCLMULMinimalLength) {
+        return _crc32Wrap(crc, buf, len);
+    }
+    auto blockLength = len & ~(size_t) 15;
+    crc = ~pclmul_crc32_blocks(~crc, buf, blockLength);
+    if (len > blockLength) {
+        crc = _crc32Wrap(crc, buf + blockLength, len - blockLength);
+    }
+    return crc;
+}
+
+} // namespace mmkv
+
+#endif // MMKV_USE_PCLMUL_CRC32
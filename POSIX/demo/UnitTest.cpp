@@ -19,13 +19,28 @@
  */
 
 #include <MMKV/MMKV.h>
+#include <MMKV/MMKVSnapshot.h>
+// internal, for checking the accelerated paths against the reference ones
+#include "../../Core/aes/openssl/openssl_aes.h"
+#include "../../Core/MemoryFile.h"
+#include "../../Core/ThreadLock.h"
+#include "../../Core/aes/AESCrypt.h"
+#include "../../Core/crc32/Checksum.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <numeric>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <thread>
 #include <unistd.h>
 
 using namespace std;
@@ -246,6 +261,1674 @@ void testRemove(MMKV *mmkv) {
     printf("test remove: passed\n");
 }
 
+void testForEach(MMKV *mmkv) {
+    mmkv->set(numeric_limits<int32_t>::max(), "forEach-int32");
+    mmkv->set("forEach", "forEach-string");
+
+    size_t count = 0;
+    bool foundInt = false, foundString = false;
+    mmkv->forEach([&](const string &key, const MMBuffer &value) {
+        count++;
+        // values are the raw encoded data: varint for int32, length-prefixed for string
+        if (key == "forEach-int32") {
+            foundInt = (value.length() == 5);
+        } else if (key == "forEach-string") {
+            foundString = (value.length() == 8 && memcmp((const char *) value.getPtr() + 1, "forEach", 7) == 0);
+        }
+        return true;
+    });
+    assert(count == mmkv->count());
+    assert(foundInt && foundString);
+
+    count = 0;
+    mmkv->forEach([&](const string &, const MMBuffer &) {
+        count++;
+        return false;
+    });
+    assert(count == 1);
+
+    // values are decrypted for encrypted instances
+    string cryptKey = "forEach";
+    auto crypt = MMKV::mmkvWithID("unit_test_crypt", MMKV_SINGLE_PROCESS, &cryptKey);
+    crypt->clearAll();
+    string bigValue(1000, 'x');
+    crypt->set(bigValue, "big");
+    crypt->forEach([&](const string &key, const MMBuffer &value) {
+        foundString = (key == "big" && value.length() > bigValue.length() &&
+                       memcmp((const char *) value.getPtr() + value.length() - bigValue.length(), bigValue.data(), bigValue.length()) == 0);
+        return true;
+    });
+    assert(foundString);
+
+    printf("test forEach: passed\n");
+}
+
+void testGetMany(MMKV *mmkv) {
+    mmkv->set(numeric_limits<int32_t>::min(), "many-int32-0");
+    mmkv->set(numeric_limits<int32_t>::max(), "many-int32-1");
+    mmkv->set("many", "many-string");
+
+    vector<string> keys = {"many-int32-0", KeyNotExist, "many-int32-1"};
+    vector<int32_t> ints;
+    auto count = mmkv->getMany(keys, ints, -1);
+    assert(count == 2);
+    assert(ints.size() == 3);
+    assert(ints[0] == numeric_limits<int32_t>::min() && ints[1] == -1 && ints[2] == numeric_limits<int32_t>::max());
+
+    vector<string> strings;
+    count = mmkv->getMany({"many-string", KeyNotExist}, strings);
+    assert(count == 1 && strings[0] == "many" && strings[1].empty());
+
+    mmkv->set("", "many-empty");
+    count = mmkv->getMany({"many-string", "many-empty", KeyNotExist}, strings, "default");
+    assert(count == 2 && strings[0] == "many" && strings[1].empty() && strings[2] == "default");
+
+    char buffer1[16], buffer2[2], buffer3[16];
+    void *buffers[] = {buffer1, buffer2, buffer3};
+    int32_t sizes[] = {sizeof(buffer1), sizeof(buffer2), sizeof(buffer3)};
+    count = mmkv->writeValuesToBuffers({"many-string", "many-string", KeyNotExist}, buffers, sizes);
+    assert(count == 1);
+    assert(sizes[0] == 4 && memcmp(buffer1, "many", 4) == 0);
+    assert(sizes[1] == -1 && sizes[2] == -1);
+
+    printf("test getMany: passed\n");
+}
+
+static int g_decodeErrorCount = 0;
+
+static void countDecodeError(MMKVLogLevel level, const char * /*file*/, int /*line*/, const char * /*function*/,
+                             MMKVLog_t /*message*/) {
+    if (level == MMKVLogError) {
+        g_decodeErrorCount++;
+    }
+}
+
+void testTypeMismatch() {
+    string cryptKey = "mismatch";
+    for (auto key : {(string *) nullptr, &cryptKey}) {
+        auto mmkv = MMKV::mmkvWithID("unit_test_type_mismatch", MMKV_SINGLE_PROCESS, key);
+        mmkv->clearAll();
+        mmkv->set(true, "bool");
+
+        // a fixed-width read past a one-byte value fails on both the raw pointer and the decrypted paths
+        MMKV::registerLogHandler(countDecodeError);
+        g_decodeErrorCount = 0;
+        bool hasValue = true;
+        assert(EqualWithAccuracy(mmkv->getDouble("bool", -1.0, &hasValue), -1.0, 0.001) && !hasValue);
+        assert(g_decodeErrorCount == 1);
+        hasValue = true;
+        assert(EqualWithAccuracy(mmkv->getFloat("bool", -1.0f, &hasValue), -1.0f, 0.001f) && !hasValue);
+        assert(g_decodeErrorCount == 2);
+
+        // a missing key is not an error
+        assert(mmkv->getInt64(KeyNotExist, -1, &hasValue) == -1 && !hasValue);
+        assert(g_decodeErrorCount == 2);
+        MMKV::unRegisterLogHandler();
+
+        assert(mmkv->getBool("bool", false, &hasValue) && hasValue);
+        mmkv->close();
+    }
+    printf("test type mismatch: passed\n");
+}
+
+void testSnapshot() {
+    auto mmkv = MMKV::mmkvWithID("unit_test_snapshot");
+    mmkv->clearAll();
+    mmkv->set(true, "snapshot-bool");
+    mmkv->set(numeric_limits<int64_t>::min(), "snapshot-int64");
+    mmkv->set(3.14, "snapshot-double");
+    mmkv->set("snapshot", "snapshot-string");
+
+    auto snapshot = mmkv->snapshot();
+    assert(snapshot->actualSize() == mmkv->actualSize());
+
+    // writes after the snapshot are invisible to it
+    mmkv->set(false, "snapshot-bool");
+    mmkv->removeValueForKey("snapshot-double");
+    mmkv->set(1, "snapshot-new");
+    assert(!snapshot->isDetached());
+    assert(snapshot->getBool("snapshot-bool"));
+    assert(snapshot->getInt64("snapshot-int64") == numeric_limits<int64_t>::min());
+    assert(snapshot->getDouble("snapshot-double") == 3.14);
+    assert(!snapshot->containsKey("snapshot-new"));
+    assert(snapshot->count() == 4);
+
+    // rewriting the file detaches the snapshot, which still holds the old data
+    mmkv->trim();
+    mmkv->clearAll();
+    assert(snapshot->isDetached());
+    string str;
+    assert(snapshot->getString("snapshot-string", str) && str == "snapshot");
+    assert(snapshot->getBool("snapshot-bool"));
+    size_t count = 0;
+    snapshot->forEach([&](const string &, const MMBuffer &) {
+        count++;
+        return true;
+    });
+    assert(count == 4 && snapshot->allKeys().size() == 4);
+
+    string cryptKey = "snapshot";
+    auto crypt = MMKV::mmkvWithID("unit_test_crypt", MMKV_SINGLE_PROCESS, &cryptKey);
+    crypt->clearAll();
+    string bigValue(1000, 'x');
+    crypt->set(bigValue, "big");
+    crypt->set(numeric_limits<uint32_t>::max(), "uint32");
+    auto cryptSnapshot = crypt->snapshot();
+    crypt->set("small", "big");
+    assert(cryptSnapshot->getString("big", str) && str == bigValue);
+    assert(cryptSnapshot->getUInt32("uint32") == numeric_limits<uint32_t>::max());
+
+    printf("test snapshot: passed\n");
+}
+
+void testExpireIndex() {
+    auto mmkv = MMKV::mmkvWithID("unit_test_expire");
+    mmkv->clearAll();
+    mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
+    mmkv->set(1, "expire-never");
+    mmkv->set(2, "expire-1", 1);
+    mmkv->set(3, "expire-2", 1);
+    mmkv->set(4, "expire-renewed", 1);
+    mmkv->set(5, "expire-later", 3600);
+    assert(mmkv->count(true) == 5);
+    sleep(2);
+    mmkv->set(6, "expire-renewed", 3600);
+
+    assert(mmkv->sweepExpiredKeys(1) == 1);
+    assert(mmkv->count() == 4);
+
+    // filtering expired keys doesn't write back
+    auto actualSize = mmkv->actualSize();
+    assert(mmkv->count(true) == 3);
+    assert(mmkv->allKeys(true).size() == 3);
+    assert(mmkv->actualSize() == actualSize);
+    assert(mmkv->count() == 3);
+    assert(mmkv->sweepExpiredKeys() == 0);
+    assert(mmkv->getInt32("expire-renewed") == 6);
+
+    // the index is rebuilt after reloading
+    mmkv->set(7, "expire-3", 1);
+    mmkv->clearMemoryCache();
+    sleep(2);
+    // sweeping never loads the instance
+    assert(mmkv->sweepExpiredKeys() == 0);
+    // keys filtered only in memory come back from the file, still expired
+    assert(mmkv->count() == 5);
+    assert(mmkv->sweepExpiredKeys() == 2);
+    assert(mmkv->count(true) == 3);
+
+    mmkv->disableAutoKeyExpire();
+    printf("test expire index: passed\n");
+}
+
+void testCryptCTR() {
+    string cryptKey = "ctrKey";
+    auto mmkv = MMKV::mmkvWithID("unit_test_crypt_ctr", MMKV_SINGLE_PROCESS, &cryptKey);
+    mmkv->clearAll();
+    mmkv->reKey(cryptKey, MMKVCryptCFB);
+    assert(mmkv->cryptMode() == MMKVCryptCFB);
+
+    // values larger than 256 bytes are read back by offset
+    string small = "ctr", large(1000, 'L');
+    for (int i = 0; i < 100; i++) {
+        mmkv->set(i, "ctr-int-" + to_string(i));
+        mmkv->set(small + to_string(i), "ctr-small-" + to_string(i));
+        mmkv->set(large + to_string(i), "ctr-large-" + to_string(i));
+    }
+    auto check = [&](MMKV *kv) {
+        string result;
+        for (int i = 0; i < 100; i++) {
+            assert(kv->getInt32("ctr-int-" + to_string(i)) == i);
+            assert(kv->getString("ctr-small-" + to_string(i), result) && result == small + to_string(i));
+            assert(kv->getString("ctr-large-" + to_string(i), result) && result == large + to_string(i));
+        }
+    };
+
+    // migrate CFB to CTR with the same key
+    auto ret = mmkv->reKey(cryptKey, MMKVCryptCTR);
+    assert(ret);
+    assert(mmkv->cryptMode() == MMKVCryptCTR);
+    check(mmkv);
+
+    // appending & reloading
+    for (int i = 0; i < 100; i += 2) {
+        mmkv->set(large + to_string(i), "ctr-large-" + to_string(i));
+        mmkv->set(i, "ctr-int-" + to_string(i));
+    }
+    check(mmkv);
+    mmkv->clearMemoryCache();
+    check(mmkv);
+    assert(mmkv->cryptMode() == MMKVCryptCTR);
+    {
+        auto snapshot = mmkv->snapshot();
+        string result;
+        assert(snapshot->getString("ctr-large-99", result) && result == large + "99");
+        assert(snapshot->getInt32("ctr-int-98") == 98);
+    }
+
+    // the mode is kept when changing the key, and after reopening
+    string cryptKey2 = "ctrKey2";
+    ret = mmkv->reKey(cryptKey2);
+    assert(ret);
+    assert(mmkv->cryptMode() == MMKVCryptCTR);
+    mmkv->close();
+    mmkv = MMKV::mmkvWithID("unit_test_crypt_ctr", MMKV_SINGLE_PROCESS, &cryptKey2);
+    assert(mmkv->cryptMode() == MMKVCryptCTR);
+    check(mmkv);
+    mmkv->trim();
+    check(mmkv);
+
+    // back to CFB, to plain text, then straight to CTR again
+    ret = mmkv->reKey(cryptKey2, MMKVCryptCFB);
+    assert(ret && mmkv->cryptMode() == MMKVCryptCFB);
+    check(mmkv);
+    ret = mmkv->reKey("");
+    assert(ret);
+    check(mmkv);
+    ret = mmkv->reKey(cryptKey, MMKVCryptCTR);
+    assert(ret && mmkv->cryptMode() == MMKVCryptCTR);
+    mmkv->clearMemoryCache();
+    check(mmkv);
+
+    printf("test crypt CTR: passed\n");
+}
+
+void testDecryptedValueCache() {
+    string cryptKey = "cacheKey";
+    auto mmkv = MMKV::mmkvWithID("unit_test_value_cache", MMKV_SINGLE_PROCESS, &cryptKey);
+    mmkv->clearAll();
+
+    string medium(100, 'M'), large(1000, 'L');
+    for (int i = 0; i < 100; i++) {
+        mmkv->set(i, "cache-int-" + to_string(i));
+        mmkv->set(medium + to_string(i), "cache-medium-" + to_string(i));
+        mmkv->set(large + to_string(i), "cache-large-" + to_string(i));
+    }
+    auto check = [&](MMKV *kv) {
+        string result;
+        for (int i = 0; i < 100; i++) {
+            assert(kv->getInt32("cache-int-" + to_string(i)) == i);
+            assert(kv->getString("cache-medium-" + to_string(i), result) && result == medium + to_string(i));
+            assert(kv->getString("cache-large-" + to_string(i), result) && result == large + to_string(i));
+        }
+    };
+
+    constexpr size_t sizeLimit = 16 * 1024;
+    mmkv->enableDecryptedValueCache(sizeLimit);
+    check(mmkv);
+    auto stats = mmkv->decryptedValueCacheStats();
+    assert(stats.hitCount == 0 && stats.missCount == 200);
+    assert(stats.totalSize <= sizeLimit && stats.sizeLimit == sizeLimit);
+
+    // the hot values are served from the cache
+    string result;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 5; i++) {
+            assert(mmkv->getString("cache-large-" + to_string(i), result) && result == large + to_string(i));
+        }
+    }
+    stats = mmkv->decryptedValueCacheStats();
+    assert(stats.hitCount >= 45 && stats.hitRatio() > 0);
+
+    // updating & removing keys
+    mmkv->set("updated", "cache-large-0");
+    assert(mmkv->getString("cache-large-0", result) && result == "updated");
+    mmkv->set(large + "1-updated", "cache-large-1");
+    assert(mmkv->getString("cache-large-1", result) && result == large + "1-updated");
+    mmkv->removeValueForKey("cache-large-2");
+    assert(!mmkv->getString("cache-large-2", result));
+    mmkv->removeValuesForKeys({"cache-medium-3"});
+    assert(!mmkv->getString("cache-medium-3", result));
+    mmkv->set(large + "0", "cache-large-0");
+    mmkv->set(large + "1", "cache-large-1");
+    mmkv->set(large + "2", "cache-large-2");
+    mmkv->set(medium + "3", "cache-medium-3");
+    check(mmkv);
+
+    // shrinking the budget, reloading, rewriting & changing the key
+    mmkv->enableDecryptedValueCache(4 * 1024);
+    assert(mmkv->decryptedValueCacheStats().totalSize <= 4 * 1024);
+    check(mmkv);
+    mmkv->clearMemoryCache();
+    check(mmkv);
+    mmkv->trim();
+    check(mmkv);
+    string cryptKey2 = "cacheKey2";
+    auto ret = mmkv->reKey(cryptKey2, MMKVCryptCTR);
+    assert(ret);
+    check(mmkv);
+    mmkv->set("ctr", "cache-large-4");
+    assert(mmkv->getString("cache-large-4", result) && result == "ctr");
+    mmkv->set(large + "4", "cache-large-4");
+
+    // keys with expire date
+    mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
+    mmkv->set(large + "expire", "cache-expire", 1);
+    assert(mmkv->getString("cache-expire", result) && result == large + "expire");
+    assert(mmkv->getString("cache-expire", result) && result == large + "expire");
+    mmkv->set(large + "renewed", "cache-expire");
+    assert(mmkv->getString("cache-expire", result) && result == large + "renewed");
+    check(mmkv);
+
+    // turning it off restores the default behavior
+    mmkv->enableDecryptedValueCache(0);
+    stats = mmkv->decryptedValueCacheStats();
+    assert(stats.hitCount == 0 && stats.missCount == 0 && stats.itemCount == 0);
+    check(mmkv);
+    mmkv->close();
+
+    printf("test decrypted value cache: passed\n");
+}
+
+// the data part of the data file, as it is on disk
+static string readDataBytes(const string &path, size_t size) {
+    string data(size, 0);
+    auto file = fopen(path.c_str(), "rb");
+    assert(file);
+    fseek(file, 4, SEEK_SET);
+    assert(fread(&data[0], 1, size, file) == size);
+    fclose(file);
+    return data;
+}
+
+void testCryptOverrideIV(const string &rootDir) {
+    string cryptKey = "overrideKey";
+    for (auto mode : {MMKVCryptCTR, MMKVCryptCFB}) {
+        auto mmkv = MMKV::mmkvWithID("unit_test_crypt_override", MMKV_SINGLE_PROCESS, &cryptKey);
+        mmkv->clearAll();
+        mmkv->reKey(cryptKey, mode);
+
+        // a single key is rewritten from the beginning, it must not be encrypted with the same keystream
+        string a(64, 'A'), b(64, 'B'), result;
+        assert(mmkv->set(a, "key"));
+        auto size = mmkv->actualSize();
+        auto c1 = readDataBytes(rootDir + "/unit_test_crypt_override", size);
+        assert(mmkv->set(b, "key"));
+        assert(mmkv->actualSize() == size);
+        auto c2 = readDataBytes(rootDir + "/unit_test_crypt_override", size);
+        size_t leaked = 0;
+        for (size_t i = size - a.size(); i < size; i++) {
+            leaked += ((c1[i] ^ c2[i]) == ('A' ^ 'B'));
+        }
+        assert(leaked < 8);
+        mmkv->clearMemoryCache();
+        assert(mmkv->getString("key", result) && result == b);
+        mmkv->close();
+    }
+    printf("test crypt override IV: passed\n");
+}
+
+void testRandomIV() {
+#ifndef MMKV_DISABLE_CRYPT
+    using IV = array<uint8_t, AES_KEY_LEN>;
+    vector<IV> ivs(10000);
+    for (auto &iv : ivs) {
+        AESCrypt::fillRandomIV(iv.data());
+    }
+    sort(ivs.begin(), ivs.end());
+    assert(adjacent_find(ivs.begin(), ivs.end()) == ivs.end());
+
+    // a forked child must not repeat the IVs of its parent
+    int fds[2];
+    assert(pipe(fds) == 0);
+    auto pid = fork();
+    if (pid == 0) {
+        IV iv;
+        AESCrypt::fillRandomIV(iv.data());
+        auto written = write(fds[1], iv.data(), iv.size());
+        _exit(written == (ssize_t) iv.size() ? 0 : 1);
+    }
+    IV parentIV, childIV;
+    AESCrypt::fillRandomIV(parentIV.data());
+    assert(read(fds[0], childIV.data(), childIV.size()) == (ssize_t) childIV.size());
+    int status = 0;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(parentIV != childIV);
+#endif
+    printf("test random IV: passed\n");
+}
+
+#if defined(MMKV_USE_AES_NI) && !defined(MMKV_DISABLE_CRYPT)
+static vector<uint8_t> fromHex(const char *hex) {
+    vector<uint8_t> bytes;
+    for (; hex[0] && hex[1]; hex += 2) {
+        bytes.push_back(static_cast<uint8_t>(stoi(string(hex, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+// everything the AES-NI dispatch replaces, switched to one implementation while alive
+class AESImplementationScope {
+    aes_set_encrypt_t m_setEncryptKey = openssl::AES_set_encrypt_key;
+    aes_set_decrypt_t m_setDecryptKey = openssl::AES_set_decrypt_key;
+    aes_encrypt_t m_encrypt = openssl::AES_encrypt;
+    aes_decrypt_t m_decrypt = openssl::AES_decrypt;
+    aes_cfb128_decrypt_blocks_t m_cfbDecryptBlocks = openssl::AES_cfb128_decrypt_blocks;
+    aes_ctr128_encrypt_blocks_t m_ctrEncryptBlocks = openssl::AES_ctr128_encrypt_blocks;
+
+public:
+    explicit AESImplementationScope(openssl::AESNICapability capability) {
+        if (capability == openssl::AESNINotSupported) {
+            openssl::AES_set_encrypt_key = openssl::AES_C_set_encrypt_key;
+            openssl::AES_set_decrypt_key = openssl::AES_C_set_decrypt_key;
+            openssl::AES_encrypt = openssl::AES_C_encrypt;
+            openssl::AES_decrypt = openssl::AES_C_decrypt;
+            openssl::AES_cfb128_decrypt_blocks = nullptr;
+            openssl::AES_ctr128_encrypt_blocks = nullptr;
+            return;
+        }
+        openssl::AES_set_encrypt_key = openssl::AES_NI_set_encrypt_key;
+        openssl::AES_set_decrypt_key = openssl::AES_NI_set_decrypt_key;
+        openssl::AES_encrypt = openssl::AES_NI_encrypt;
+        openssl::AES_decrypt = openssl::AES_NI_decrypt;
+        if (capability == openssl::AESNIWithVAESSupported) {
+            openssl::AES_cfb128_decrypt_blocks = openssl::AES_VAES_cfb128_decrypt_blocks;
+            openssl::AES_ctr128_encrypt_blocks = openssl::AES_VAES_ctr128_encrypt_blocks;
+        } else {
+            openssl::AES_cfb128_decrypt_blocks = openssl::AES_NI_cfb128_decrypt_blocks;
+            openssl::AES_ctr128_encrypt_blocks = openssl::AES_NI_ctr128_encrypt_blocks;
+        }
+    }
+
+    ~AESImplementationScope() {
+        openssl::AES_set_encrypt_key = m_setEncryptKey;
+        openssl::AES_set_decrypt_key = m_setDecryptKey;
+        openssl::AES_encrypt = m_encrypt;
+        openssl::AES_decrypt = m_decrypt;
+        openssl::AES_cfb128_decrypt_blocks = m_cfbDecryptBlocks;
+        openssl::AES_ctr128_encrypt_blocks = m_ctrEncryptBlocks;
+    }
+};
+#endif
+
+void testAESKnownAnswer() {
+#if defined(MMKV_USE_AES_NI) && !defined(MMKV_DISABLE_CRYPT)
+    using openssl::AES_KEY;
+    // FIPS-197 C.1, AES-128 of one block
+    auto checkBlock = [] {
+        auto key = fromHex("000102030405060708090a0b0c0d0e0f");
+        auto plain = fromHex("00112233445566778899aabbccddeeff");
+        auto expected = fromHex("69c4e0d86a7b0430d8cdb78070b4c55a");
+        AES_KEY encryptKey, decryptKey;
+        openssl::AES_set_encrypt_key(key.data(), 128, &encryptKey);
+        openssl::AES_set_decrypt_key(key.data(), 128, &decryptKey);
+        uint8_t output[16], back[16];
+        openssl::AES_encrypt(plain.data(), output, &encryptKey);
+        assert(memcmp(output, expected.data(), 16) == 0);
+        openssl::AES_decrypt(output, back, &decryptKey);
+        assert(memcmp(back, plain.data(), 16) == 0);
+    };
+    // SP 800-38A F.3.13 (CFB128-AES128) & F.5.1 (CTR-AES128), fed in pieces of odd lengths to resume mid-block
+    auto key = fromHex("2b7e151628aed2a6abf7158809cf4f3c");
+    auto plain = fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+                         "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    auto cfbIV = fromHex("000102030405060708090a0b0c0d0e0f");
+    auto cfbCipher = fromHex("3b3fd92eb72dad20333449f8e83cfb4ac8a64537a0b3a93fcde3cdad9f1ce58b"
+                             "26751f67a3cbb140b1808cf187a4f4dfc04b05357c5d1c0eeac4c66f9ff7f2e6");
+    auto ctrIV = fromHex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    auto ctrCipher = fromHex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+                             "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+    enum Operation { CFBEncrypt, CFBDecrypt, CTR };
+    auto run = [&key](Operation operation, const vector<uint8_t> &iv, const vector<uint8_t> &input, const vector<size_t> &pieces) {
+        AES_KEY aesKey;
+        openssl::AES_set_encrypt_key(key.data(), 128, &aesKey);
+        uint8_t vector[16];
+        memcpy(vector, iv.data(), 16);
+        uint32_t number = 0;
+        std::vector<uint8_t> output(input.size());
+        size_t position = 0;
+        for (size_t index = 0; position < input.size(); index++) {
+            auto length = min(pieces[index % pieces.size()], input.size() - position);
+            auto in = input.data() + position;
+            auto out = output.data() + position;
+            if (operation == CFBEncrypt) {
+                openssl::AES_cfb128_encrypt(in, out, length, &aesKey, vector, &number);
+            } else if (operation == CFBDecrypt) {
+                openssl::AES_cfb128_decrypt(in, out, length, &aesKey, vector, &number);
+            } else {
+                openssl::AES_ctr128_encrypt(in, out, length, &aesKey, vector, &number);
+            }
+            position += length;
+        }
+        return output;
+    };
+    auto checkVectors = [&] {
+        checkBlock();
+        for (auto &pieces : vector<vector<size_t>>{{64}, {1}, {7, 33}, {15, 17, 3}, {31}}) {
+            assert(run(CFBEncrypt, cfbIV, plain, pieces) == cfbCipher);
+            assert(run(CFBDecrypt, cfbIV, cfbCipher, pieces) == plain);
+            assert(run(CTR, ctrIV, plain, pieces) == ctrCipher);
+            assert(run(CTR, ctrIV, ctrCipher, pieces) == plain);
+        }
+    };
+    // the generic one, then whatever this CPU supports
+    auto capability = openssl::AES_NI_capability();
+    for (int level = openssl::AESNINotSupported; level <= capability; level++) {
+        AESImplementationScope implementation(static_cast<openssl::AESNICapability>(level));
+        checkVectors();
+    }
+
+    // long inputs take the multi-block paths, they must be byte-identical to the generic ones
+    vector<uint8_t> data(4099);
+    for (auto &byte : data) {
+        byte = static_cast<uint8_t>(rand());
+    }
+    // the counter carries beyond the lower 64 bits here
+    auto wrapIV = fromHex("0102030405060708fffffffffffffffd");
+    vector<vector<size_t>> allPieces = {{4099}, {1, 255}, {17, 1000, 3}, {129, 513}};
+    vector<vector<uint8_t>> results;
+    {
+        AESImplementationScope generic(openssl::AESNINotSupported);
+        for (auto &pieces : allPieces) {
+            results.push_back(run(CFBEncrypt, cfbIV, data, pieces));
+            results.push_back(run(CFBDecrypt, cfbIV, data, pieces));
+            results.push_back(run(CTR, ctrIV, data, pieces));
+            results.push_back(run(CTR, wrapIV, data, pieces));
+        }
+    }
+    for (int level = openssl::AESNISupported; level <= capability; level++) {
+        AESImplementationScope implementation(static_cast<openssl::AESNICapability>(level));
+        size_t index = 0;
+        for (auto &pieces : allPieces) {
+            assert(run(CFBEncrypt, cfbIV, data, pieces) == results[index++]);
+            assert(run(CFBDecrypt, cfbIV, data, pieces) == results[index++]);
+            assert(run(CTR, ctrIV, data, pieces) == results[index++]);
+            assert(run(CTR, wrapIV, data, pieces) == results[index++]);
+        }
+    }
+    printf("test AES known answer: passed (AES-NI capability %d)\n", capability);
+#endif
+}
+
+void testPCLMULCRC32() {
+#ifdef MMKV_USE_PCLMUL_CRC32
+    if (!mmkv::pclmul_crc32_supported()) {
+        printf("test pclmul crc32: skipped\n");
+        return;
+    }
+    vector<uint8_t> buffer(256 * 1024 + 64);
+    for (auto &byte : buffer) {
+        byte = static_cast<uint8_t>(rand());
+    }
+    // every length around the folding sizes, then random ones, from every misalignment
+    auto check = [&](size_t offset, size_t length) {
+        auto crc = static_cast<uint32_t>(rand());
+        auto ptr = buffer.data() + offset;
+        assert(mmkv::pclmul_crc32(crc, ptr, length) == ZLIB_CRC32(crc, ptr, length));
+        assert(mmkv::pclmul_crc32(0, ptr, length) == ZLIB_CRC32(0, ptr, length));
+    };
+    for (size_t offset = 0; offset < 16; offset++) {
+        for (size_t length = 0; length <= 320; length++) {
+            check(offset, length);
+        }
+    }
+    for (int i = 0; i < 2000; i++) {
+        check(static_cast<size_t>(rand()) % 64, static_cast<size_t>(rand()) % (buffer.size() - 64));
+    }
+    // and chained, as the data is appended piece by piece
+    uint32_t crc = 0;
+    for (size_t position = 0, step = 1; position + step <= buffer.size(); position += step, step = step * 3 % 977 + 1) {
+        crc = mmkv::pclmul_crc32(crc, buffer.data() + position, step);
+        assert(crc == ZLIB_CRC32(0, buffer.data(), position + step));
+    }
+    printf("test pclmul crc32: passed\n");
+#endif
+}
+
+static MMKVRecoverStrategic recoverOnError(const string &, MMKVErrorType) {
+    return OnErrorRecover;
+}
+
+// flip one byte of the data file, offset is relative to the data
+static void corruptFile(const string &path, long offset) {
+    auto file = fopen(path.c_str(), "r+b");
+    assert(file);
+    fseek(file, 4 + offset, SEEK_SET);
+    auto ch = fgetc(file);
+    fseek(file, 4 + offset, SEEK_SET);
+    fputc(ch ^ 0xff, file);
+    fclose(file);
+}
+
+void testSegmentCRC(const string &rootDir) {
+    string cryptKey = "segmentKey";
+    string value(300, 'S');
+    constexpr int total = 2000;
+    auto run = [&](const string &mmapID, string *key, MMKVCryptMode mode) {
+        auto mmkv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS, key);
+        mmkv->clearAll();
+        if (key) {
+            mmkv->reKey(*key, mode);
+        }
+        for (int i = 0; i < total; i++) {
+            mmkv->set(value + to_string(i), "segment-" + to_string(i));
+        }
+        // a full writeback that keeps the leading items where they were
+        vector<string> keys;
+        for (int i = total - 200; i < total - 100; i++) {
+            keys.push_back("segment-" + to_string(i));
+        }
+        mmkv->removeValuesForKeys(keys);
+        assert(mmkv->count() == total - 100);
+        for (int i = total - 200; i < total - 100; i++) {
+            mmkv->set(value + to_string(i), "segment-" + to_string(i));
+        }
+        mmkv->close();
+
+        // the items in the damaged segment are lost, the rest are recovered
+        corruptFile(rootDir + "/" + mmapID, 300 * 1024);
+        mmkv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS, key);
+        auto count = mmkv->count();
+        assert(count < total && count > total - 300);
+        string result;
+        for (int i = 0; i < total; i++) {
+            if (mmkv->getString("segment-" + to_string(i), result)) {
+                assert(result == value + to_string(i));
+            }
+        }
+        assert(mmkv->getString("segment-0", result) && mmkv->getString("segment-" + to_string(total - 1), result));
+
+        // the recovered file is good again
+        mmkv->close();
+        mmkv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS, key);
+        assert(mmkv->count() == count);
+        mmkv->close();
+    };
+
+    MMKV::registerErrorHandler(recoverOnError);
+    run("unit_test_segment_crc", nullptr, MMKVCryptCFB);
+    run("unit_test_segment_crc_cfb", &cryptKey, MMKVCryptCFB);
+    run("unit_test_segment_crc_ctr", &cryptKey, MMKVCryptCTR);
+    MMKV::unRegisterErrorHandler();
+
+    // appends of any size, some of them cross segments
+    auto mmkv = MMKV::mmkvWithID("unit_test_segment_crc_append", MMKV_SINGLE_PROCESS, nullptr, nullptr, 1024 * 1024);
+    mmkv->clearAll();
+    vector<size_t> sizes = {100, 2000, 100 * 1024, 30, 64 * 1024, 5000, 1};
+    for (size_t i = 0; i < sizes.size(); i++) {
+        mmkv->set(string(sizes[i], 'a' + i), "append-" + to_string(i));
+    }
+    mmkv->close();
+    mmkv = MMKV::mmkvWithID("unit_test_segment_crc_append", MMKV_SINGLE_PROCESS);
+    assert(mmkv->count() == sizes.size());
+    for (size_t i = 0; i < sizes.size(); i++) {
+        string result;
+        assert(mmkv->getString("append-" + to_string(i), result) && result == string(sizes[i], 'a' + i));
+    }
+    // so are the segment digests, the full writeback keeps the ones before the first removed item
+    mmkv->removeValuesForKeys({"append-5", "append-6"});
+    mmkv->close();
+
+    // only the items starting in the damaged first segment are lost
+    corruptFile(rootDir + "/unit_test_segment_crc_append", 1024);
+    MMKV::registerErrorHandler(recoverOnError);
+    mmkv = MMKV::mmkvWithID("unit_test_segment_crc_append", MMKV_SINGLE_PROCESS);
+    assert(mmkv->count() == 2);
+    assert(mmkv->containsKey("append-3") && mmkv->containsKey("append-4"));
+    mmkv->close();
+
+    // the crc of the last segment is derived from the whole digest, damage in it is still found
+    mmkv = MMKV::mmkvWithID("unit_test_segment_crc_tail", MMKV_SINGLE_PROCESS);
+    mmkv->clearAll();
+    for (int i = 0; i < 300; i++) {
+        mmkv->set(value, "tail-" + to_string(i));
+    }
+    mmkv->close();
+    corruptFile(rootDir + "/unit_test_segment_crc_tail", 90 * 1024);
+    mmkv = MMKV::mmkvWithID("unit_test_segment_crc_tail", MMKV_SINGLE_PROCESS);
+    assert(mmkv->count() > 150 && mmkv->count() < 300);
+    assert(mmkv->containsKey("tail-0") && !mmkv->containsKey("tail-299"));
+    MMKV::unRegisterErrorHandler();
+    mmkv->close();
+
+    printf("test segment crc: passed\n");
+}
+
+// sorted, disjoint, page aligned, never more than MaxRangeCount
+static void checkDirtyRanges(const DirtyRanges &dirty) {
+    auto &ranges = dirty.ranges();
+    assert(ranges.size() <= DirtyRanges::MaxRangeCount);
+    for (size_t index = 0; index < ranges.size(); index++) {
+        assert(ranges[index].first < ranges[index].second);
+        assert(ranges[index].first % DEFAULT_MMAP_SIZE == 0 && ranges[index].second % DEFAULT_MMAP_SIZE == 0);
+        assert(index == 0 || ranges[index - 1].second < ranges[index].first);
+    }
+}
+
+static bool isCoveredByDirtyRanges(const DirtyRanges &dirty, size_t offset) {
+    for (auto &range : dirty.ranges()) {
+        if (range.first <= offset && offset < range.second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void testDirtyRanges() {
+    const auto page = DEFAULT_MMAP_SIZE;
+    DirtyRanges dirty;
+    dirty.add(10, 10);
+    assert(dirty.empty());
+
+    // aligned to whole pages
+    dirty.add(page + 1, page + 2);
+    assert(dirty.ranges().size() == 1 && dirty.ranges()[0] == make_pair(page, 2 * page));
+
+    // touching & overlapping ones are merged
+    dirty.add(2 * page, 2 * page + 1);
+    assert(dirty.ranges().size() == 1 && dirty.ranges()[0] == make_pair(page, 3 * page));
+    dirty.add(5 * page, 6 * page);
+    dirty.add(page - 1, 5 * page + 1);
+    assert(dirty.ranges().size() == 1 && dirty.ranges()[0] == make_pair(size_t(0), 6 * page));
+
+    // beyond the cap, the two closest ones are collapsed
+    dirty.clear();
+    for (size_t index = 0; index < DirtyRanges::MaxRangeCount; index++) {
+        dirty.add(index * 10 * page, index * 10 * page + 1);
+    }
+    assert(dirty.ranges().size() == DirtyRanges::MaxRangeCount);
+    dirty.add(32 * page, 32 * page + 1);
+    checkDirtyRanges(dirty);
+    assert(dirty.ranges().size() == DirtyRanges::MaxRangeCount);
+    assert(dirty.ranges()[3] == make_pair(30 * page, 33 * page));
+
+    // whatever is written, the ranges handed to msync() cover every written offset
+    dirty.clear();
+    vector<pair<size_t, size_t>> written;
+    for (int round = 0; round < 2000; round++) {
+        size_t start = static_cast<size_t>(rand()) % (1000 * page);
+        size_t end = start + 1 + static_cast<size_t>(rand()) % (2 * page);
+        dirty.add(start, end);
+        written.emplace_back(start, end);
+        checkDirtyRanges(dirty);
+        if (round % 100 == 99) {
+            for (auto &range : written) {
+                assert(isCoveredByDirtyRanges(dirty, range.first) && isCoveredByDirtyRanges(dirty, range.second - 1));
+                for (auto offset = range.first / page * page; offset < range.second; offset += page) {
+                    assert(isCoveredByDirtyRanges(dirty, max(offset, range.first)));
+                }
+            }
+        }
+        if (round % 500 == 499) {
+            dirty.clear();
+            written.clear();
+        }
+    }
+
+    // merging another set keeps all of both
+    DirtyRanges flushing;
+    flushing.add(0, 1);
+    flushing.add(900 * page, 900 * page + 1);
+    dirty.add(450 * page, 451 * page);
+    dirty.add(flushing);
+    checkDirtyRanges(dirty);
+    for (auto offset : {size_t(0), 450 * page, 900 * page}) {
+        assert(isCoveredByDirtyRanges(dirty, offset));
+    }
+    printf("test dirty ranges: passed\n");
+}
+
+void testDirtySync() {
+    auto mmkv = MMKV::mmkvWithID("unit_test_dirty_sync", MMKV_SINGLE_PROCESS);
+    mmkv->clearAll();
+    string value(1000, 'D');
+    // appends, then a full writeback that keeps the leading items, then an override
+    for (int i = 0; i < 1000; i++) {
+        mmkv->set(value + to_string(i), "dirty-" + to_string(i));
+        if (i % 100 == 0) {
+            mmkv->sync(MMKV_ASYNC);
+        }
+    }
+    mmkv->sync(MMKV_SYNC);
+    mmkv->removeValuesForKeys({"dirty-998", "dirty-999"});
+    mmkv->sync(MMKV_ASYNC);
+    mmkv->set(value, "dirty-0");
+    mmkv->sync(MMKV_SYNC);
+    // nothing changed since the last sync
+    mmkv->sync(MMKV_SYNC);
+    mmkv->close();
+
+    mmkv = MMKV::mmkvWithID("unit_test_dirty_sync", MMKV_SINGLE_PROCESS);
+    assert(mmkv->count() == 998);
+    string result;
+    assert(mmkv->getString("dirty-0", result) && result == value);
+    assert(mmkv->getString("dirty-997", result) && result == value + "997");
+    mmkv->clearAll();
+    mmkv->sync(MMKV_SYNC);
+    assert(mmkv->count() == 0);
+    mmkv->close();
+
+    printf("test dirty sync: passed\n");
+}
+
+void testIncrementalBackup(const string &rootDir) {
+    string mmapID = "unit_test_incremental_backup";
+    string backupDir = rootDir + "/incremental_backup";
+    string restoreDir = rootDir + "/incremental_restore";
+    auto backupPath = backupDir + "/" + mmapID;
+    auto mmkv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS);
+    mmkv->clearAll();
+    string value(1000, 'B');
+    for (int i = 0; i < 100; i++) {
+        mmkv->set(value + to_string(i), "backup-" + to_string(i));
+    }
+    auto fileStat = [&](struct stat &st) { assert(stat(backupPath.c_str(), &st) == 0); };
+    auto restoreAndCheck = [&](size_t count) {
+        assert(MMKV::restoreOneFromDirectory(mmapID, backupDir, &restoreDir));
+        auto restored = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS, nullptr, &restoreDir);
+        assert(restored->count() == count);
+        string result;
+        assert(restored->getString("backup-0", result) && result == value + "0");
+        restored->close();
+    };
+
+    // the first backup copies everything
+    unlink((backupPath + ".manifest").c_str());
+    assert(MMKV::backupOneToDirectory(mmapID, backupDir));
+    assert(access((backupPath + ".manifest").c_str(), F_OK) == 0);
+    struct stat first, second;
+    fileStat(first);
+    // set the mtime back, so that any write to the backup shows up without waiting for the clock
+    struct timeval times[2] = {{first.st_atime, 0}, {first.st_mtime - 10, 0}};
+    assert(utimes(backupPath.c_str(), times) == 0);
+    fileStat(first);
+
+    // nothing changed, the backup is skipped
+    assert(MMKV::backupOneToDirectory(mmapID, backupDir));
+    fileStat(second);
+    assert(first.st_ino == second.st_ino && first.st_mtime == second.st_mtime);
+
+    // only the appended data is copied, in place
+    for (int i = 100; i < 120; i++) {
+        mmkv->set(value + to_string(i), "backup-" + to_string(i));
+    }
+    assert(MMKV::backupOneToDirectory(mmapID, backupDir));
+    fileStat(second);
+    assert(first.st_ino == second.st_ino && first.st_mtime != second.st_mtime);
+    restoreAndCheck(120);
+
+    // a full writeback increases the sequence, everything is copied again
+    mmkv->removeValuesForKeys({"backup-118", "backup-119"});
+    assert(MMKV::backupOneToDirectory(mmapID, backupDir));
+    restoreAndCheck(118);
+    mmkv->close();
+
+    printf("test incremental backup: passed\n");
+}
+
+void testThreadLockUnlockFully() {
+    ThreadLock lock;
+    lock.initialize();
+    lock.lock();
+    lock.lock();
+    auto depth = lock.unlockFully();
+    assert(depth == 2);
+    // another thread can take it now
+    bool locked = false;
+    thread([&] {
+        locked = lock.try_lock();
+        if (locked) {
+            lock.unlock();
+        }
+    }).join();
+    assert(locked);
+    lock.relock(depth);
+    lock.unlock();
+    assert(lock.unlockFully() == 1);
+
+    printf("test thread lock unlock fully: passed\n");
+}
+
+static atomic_bool g_backupStarted, g_backupFinished;
+
+static void watchCachedBackup(MMKVLogLevel /*level*/, const char * /*file*/, int /*line*/, const char * /*function*/,
+                              MMKVLog_t message) {
+    if (message.find("backup one cached mmkv") == 0) {
+        g_backupStarted = true;
+    } else if (message.find("finish backup one mmkv") == 0) {
+        g_backupFinished = true;
+    }
+}
+
+void testParallelBackup(const string &rootDir) {
+    string srcDir = rootDir + "/parallel_src";
+    string backupDir = rootDir + "/parallel_backup";
+    constexpr int instanceCount = 8;
+    auto mmapIDOf = [](int i) { return "unit_test_parallel_" + to_string(i); };
+    vector<MMKV *> opened;
+    for (int i = 0; i < instanceCount; i++) {
+        auto kv = MMKV::mmkvWithID(mmapIDOf(i), MMKV_SINGLE_PROCESS, nullptr, &srcDir);
+        kv->clearAll();
+        for (int j = 0; j < 100; j++) {
+            kv->set("value-" + to_string(i) + "-" + to_string(j), "key-" + to_string(j));
+        }
+        // half of them are cached, the other half are backed up by file
+        if (i % 2) {
+            kv->close();
+        } else {
+            opened.push_back(kv);
+        }
+    }
+
+    auto result = MMKV::backupAllToDirectory(backupDir, &srcDir, 4);
+    assert(result.succeededCount == instanceCount && result.failedPaths.empty());
+
+    for (auto kv : opened) {
+        kv->set("changed", "key-0");
+        kv->removeValueForKey("key-1");
+    }
+    result = MMKV::restoreAllFromDirectory(backupDir, &srcDir, 4);
+    assert(result.succeededCount == instanceCount && result.failedPaths.empty());
+
+    for (int i = 0; i < instanceCount; i++) {
+        auto kv = MMKV::mmkvWithID(mmapIDOf(i), MMKV_SINGLE_PROCESS, nullptr, &srcDir);
+        assert(kv->count() == 100);
+        string value;
+        assert(kv->getString("key-0", value) && value == "value-" + to_string(i) + "-0");
+        kv->close();
+    }
+
+    // closing a cached instance waits for its backup, opening others doesn't
+    string largeDir = rootDir + "/parallel_large";
+    string largeBackupDir = rootDir + "/parallel_large_backup";
+    auto large = MMKV::mmkvWithID("unit_test_parallel_large", MMKV_SINGLE_PROCESS, nullptr, &largeDir);
+    large->clearAll();
+    string largeValue(32 * 1024 * 1024, 'L');
+    large->set(largeValue, "large");
+    g_backupStarted = g_backupFinished = false;
+    MMKV::registerLogHandler(watchCachedBackup);
+    bool backupRet = false;
+    thread backupThread([&] { backupRet = MMKV::backupOneToDirectory("unit_test_parallel_large", largeBackupDir, &largeDir); });
+    while (!g_backupStarted) {
+        this_thread::yield();
+    }
+    auto other = MMKV::mmkvWithID(mmapIDOf(0), MMKV_SINGLE_PROCESS, nullptr, &srcDir);
+    assert(other->count() == 100);
+    large->close();
+    assert(g_backupFinished);
+    backupThread.join();
+    MMKV::unRegisterLogHandler();
+    assert(backupRet);
+    large = MMKV::mmkvWithID("unit_test_parallel_large", MMKV_SINGLE_PROCESS, nullptr, &largeBackupDir);
+    string value;
+    assert(large->getString("large", value) && value == largeValue);
+    large->close();
+
+    printf("test parallel backup: passed\n");
+}
+
+void testBulkImport() {
+    string cryptKey = "import";
+    auto plain = MMKV::mmkvWithID("unit_test_import_plain", MMKV_SINGLE_PROCESS);
+    auto crypt = MMKV::mmkvWithID("unit_test_import_crypt", MMKV_SINGLE_PROCESS, &cryptKey);
+    auto dst = MMKV::mmkvWithID("unit_test_import_dst", MMKV_SINGLE_PROCESS);
+    auto cryptDst = MMKV::mmkvWithID("unit_test_import_crypt_dst", MMKV_SINGLE_PROCESS, &cryptKey);
+    for (auto kv : {plain, crypt, dst, cryptDst}) {
+        kv->clearAll();
+    }
+    string longValue(1000, 'I');
+    for (int i = 0; i < 1000; i++) {
+        plain->set("plain-" + to_string(i), "key-" + to_string(i));
+        crypt->set(longValue + to_string(i), "crypt-" + to_string(i));
+    }
+    plain->removeValueForKey("key-0");
+    dst->set("old", "key-1");
+    dst->set("kept", "dst-only");
+
+    auto check = [&](MMKV *kv) {
+        string value;
+        assert(!kv->containsKey("key-0"));
+        assert(kv->getString("key-1", value) && value == "plain-1");
+        assert(kv->getString("key-999", value) && value == "plain-999");
+        assert(kv->getString("crypt-500", value) && value == longValue + "500");
+    };
+    // plain to plain copies the records, crypt to plain decrypts them
+    assert(dst->importFrom(plain) == 999);
+    assert(dst->importFrom(crypt) == 1000);
+    assert(dst->count() == 2000);
+    check(dst);
+    // the file stays valid after reloading
+    dst->clearMemoryCache();
+    assert(dst->count() == 2000);
+    check(dst);
+
+    // plain to crypt encrypts them
+    assert(cryptDst->importFrom(dst) == 2000);
+    cryptDst->clearMemoryCache();
+    assert(cryptDst->count() == 2000);
+    check(cryptDst);
+
+    for (auto kv : {plain, crypt, dst, cryptDst}) {
+        kv->close();
+    }
+    printf("test bulk import: passed\n");
+}
+
+void testStreamDump() {
+    string cryptKey = "stream";
+    auto src = MMKV::mmkvWithID("unit_test_stream_src", MMKV_SINGLE_PROCESS);
+    auto dst = MMKV::mmkvWithID("unit_test_stream_dst", MMKV_SINGLE_PROCESS, &cryptKey);
+    src->clearAll();
+    dst->clearAll();
+    src->enableAutoKeyExpire(MMKV::ExpireNever);
+    string bigValue(200 * 1024, 'S');
+    for (int i = 0; i < 3000; i++) {
+        src->set("stream-" + to_string(i), "key-" + to_string(i));
+    }
+    src->set(bigValue, "big");
+    src->set("gone", "expired", 1);
+    sleep(2);
+
+    string stream;
+    assert(src->dumpTo([&](const void *ptr, size_t size) {
+        stream.append((const char *) ptr, size);
+        return true;
+    }));
+    // the reader hands out a few bytes at a time, like a pipe
+    auto readerOf = [](const string &data) {
+        auto position = make_shared<size_t>(0);
+        return [data, position](void *buffer, size_t size) {
+            size = min<size_t>({size, 1000, data.size() - *position});
+            memcpy(buffer, data.data() + *position, size);
+            *position += size;
+            return size;
+        };
+    };
+
+    size_t count = 0;
+    assert(dst->loadFrom(readerOf(stream), &count));
+    assert(count == 3001 && dst->count() == 3001 && !dst->containsKey("expired"));
+    dst->clearMemoryCache();
+    string value;
+    assert(dst->getString("key-2999", value) && value == "stream-2999");
+    assert(dst->getString("big", value) && value == bigValue);
+
+    // a broken stream keeps the records before the broken one
+    dst->clearAll();
+    assert(!dst->loadFrom(readerOf(stream.substr(0, stream.size() / 2)), &count));
+    assert(count < 3001 && dst->count() == count);
+    auto corrupted = stream;
+    corrupted[corrupted.size() - 20] ^= 0xff;
+    assert(!dst->loadFrom(readerOf(corrupted), &count));
+    assert(!dst->loadFrom(readerOf("not a stream"), &count) && count == 0);
+
+    // the integers are little-endian on any host, a stream put together byte by byte loads
+    assert(stream.compare(8, 4, string("\x01\0\0\0", 4)) == 0);
+    auto appendLittleEndian = [](string &data, uint32_t value) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            data.push_back(static_cast<char>(value >> shift));
+        }
+    };
+    string handmade = "MMKVDUMP";
+    appendLittleEndian(handmade, 1);
+    auto recordStart = handmade.size();
+    appendLittleEndian(handmade, 1);
+    appendLittleEndian(handmade, 2);
+    appendLittleEndian(handmade, MMKV::ExpireNever);
+    handmade += "k\x01" "a";
+    auto recordCRC = CRC32(0, (const uint8_t *) handmade.data() + recordStart, handmade.size() - recordStart);
+    appendLittleEndian(handmade, (uint32_t) recordCRC);
+    string end;
+    appendLittleEndian(end, 0);
+    appendLittleEndian(end, 1);
+    appendLittleEndian(end, (uint32_t) CRC32(0, (const uint8_t *) end.data(), end.size()));
+    handmade += end;
+    dst->clearAll();
+    assert(dst->loadFrom(readerOf(handmade), &count) && count == 1);
+    assert(dst->getString("k", value) && value == "a");
+
+    // a record claiming a huge value is read in chunks, nothing that large is allocated for a short stream
+    string huge = handmade.substr(0, recordStart);
+    appendLittleEndian(huge, 1);
+    appendLittleEndian(huge, 1u << 30);
+    appendLittleEndian(huge, MMKV::ExpireNever);
+    huge += "k" + string(100 * 1024, 'h');
+    size_t position = 0, largestRead = 0;
+    assert(!dst->loadFrom(
+        [&](void *buffer, size_t size) {
+            largestRead = max(largestRead, size);
+            size = min(size, huge.size() - position);
+            memcpy(buffer, huge.data() + position, size);
+            position += size;
+            return size;
+        },
+        &count));
+    assert(count == 0 && largestRead <= 64 * 1024);
+
+    // a key longer than the stream allows fails the dump, rather than writing one that never loads
+    assert(dst->set(string("long"), string(70000, 'K')));
+    assert(!dst->dumpTo([](const void *, size_t) { return true; }));
+
+    src->close();
+    dst->close();
+    printf("test stream dump: passed\n");
+}
+
+void testAccessHints() {
+    auto kv = MMKV::mmkvWithID("unit_test_access_hints", MMKV_SINGLE_PROCESS);
+    kv->clearAll();
+    string longValue(1000, 'H');
+    for (int i = 0; i < 1000; i++) {
+        kv->set(longValue + to_string(i), "key-" + to_string(i));
+    }
+    auto check = [&](size_t expectedCount) {
+        string value;
+        assert(kv->count() == expectedCount);
+        assert(kv->getString("key-999", value) && value == longValue + "999");
+    };
+
+    // the values are read back from the file after the pages are reclaimed
+    kv->reclaimPageCache();
+    check(1000);
+    kv->reclaimPageCache(true);
+    check(1000);
+    MMKV::reclaimAllPageCache();
+    check(1000);
+
+    // full writeback & reloading work the same with or without the hints
+    for (bool enable : {false, true}) {
+        kv->enableAccessHints(enable);
+        kv->removeValueForKey("key-" + to_string(enable));
+        kv->trim();
+        kv->clearMemoryCache();
+        check(enable ? 998 : 999);
+        kv->set("appended", "key-appended");
+        kv->clearMemoryCache();
+        check(enable ? 999 : 1000);
+        kv->removeValueForKey("key-appended");
+    }
+
+    kv->close();
+    printf("test access hints: passed\n");
+}
+
+void testHugePage() {
+    auto kv = MMKV::mmkvWithID("unit_test_huge_page", MMKV_SINGLE_PROCESS | MMKV_HUGE_PAGE);
+    kv->clearAll();
+    // grow it over a few huge pages, each growth remaps the file
+    string longValue(4000, 'P');
+    for (int i = 0; i < 2000; i++) {
+        kv->set(longValue + to_string(i), "key-" + to_string(i));
+    }
+    kv->trim();
+    kv->clearMemoryCache();
+    string value;
+    assert(kv->count() == 2000);
+    assert(kv->getString("key-0", value) && value == longValue + "0");
+    assert(kv->getString("key-1999", value) && value == longValue + "1999");
+
+    kv->close();
+    printf("test huge page: passed\n");
+}
+
+static void copyFileForTest(const string &srcPath, const string &dstPath) {
+    auto src = fopen(srcPath.c_str(), "rb");
+    auto dst = fopen(dstPath.c_str(), "wb");
+    assert(src && dst);
+    char buffer[64 * 1024];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+        assert(fwrite(buffer, 1, size, dst) == size);
+    }
+    fclose(src);
+    fclose(dst);
+}
+
+void testBufferedIO(const string &rootDir) {
+    auto kv = MMKV::mmkvWithID("unit_test_buffered_io", MMKV_SINGLE_PROCESS | MMKV_BUFFERED_IO);
+    kv->clearAll();
+    string longValue(1000, 'B');
+    for (int i = 0; i < 3000; i++) {
+        kv->set(longValue + to_string(i), "key-" + to_string(i));
+    }
+    kv->removeValueForKey("key-0");
+    kv->trim();
+    string value;
+    assert(kv->count() == 2999);
+    assert(kv->getString("key-2999", value) && value == longValue + "2999");
+
+    // without sync(), what's on disk is written back every MB or so, and stays loadable
+    auto copyID = string("unit_test_buffered_io_copy");
+    copyFileForTest(rootDir + "/unit_test_buffered_io", rootDir + "/" + copyID);
+    copyFileForTest(rootDir + "/unit_test_buffered_io.crc", rootDir + "/" + copyID + ".crc");
+    auto copy = MMKV::mmkvWithID(copyID, MMKV_SINGLE_PROCESS);
+    auto count = copy->count();
+    assert(count > 0 && count <= 2999);
+    copy->close();
+
+    // everything is written back on close
+    kv->set("appended", "key-appended");
+    kv->close();
+    kv = MMKV::mmkvWithID("unit_test_buffered_io", MMKV_SINGLE_PROCESS);
+    assert(kv->count() == 3000);
+    assert(!kv->containsKey("key-0"));
+    assert(kv->getString("key-appended", value) && value == "appended");
+    kv->close();
+
+    // and the other way around
+    kv = MMKV::mmkvWithID("unit_test_buffered_io", MMKV_SINGLE_PROCESS | MMKV_BUFFERED_IO);
+    assert(kv->count() == 3000);
+    assert(kv->getString("key-1", value) && value == longValue + "1");
+    kv->clearMemoryCache();
+    assert(kv->count() == 3000);
+    kv->close();
+    printf("test buffered io: passed\n");
+}
+
+void testMemfd(const string &rootDir) {
+    auto kv = MMKV::mmkvWithID("unit_test_memfd", MMKV_MEMFD);
+    assert(kv && kv->isMemfd() && kv->isMultiProcess());
+    kv->set("parent", "key-parent");
+    auto fd = kv->memfdFD();
+    auto metaFD = kv->memfdMetaFD();
+    assert(fd >= 0 && metaFD >= 0);
+
+    // the child grows it over a few pages, the parent has to remap it
+    string longValue(1000, 'M');
+    auto pid = fork();
+    if (pid == 0) {
+        auto child = MMKV::mmkvWithMemfdFD("unit_test_memfd_child", fd, metaFD);
+        string value;
+        bool ok = child && child->getString("key-parent", value) && value == "parent";
+        for (int i = 0; ok && i < 100; i++) {
+            ok = child->set(longValue + to_string(i), "key-" + to_string(i));
+        }
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    assert(pid > 0 && waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    string value;
+    assert(kv->count() == 101);
+    assert(kv->getString("key-99", value) && value == longValue + "99");
+
+    // the memfd can't shrink, trim() keeps everything intact
+    kv->removeValuesForKeys({"key-0", "key-1"});
+    kv->trim();
+    kv->clearMemoryCache();
+    assert(kv->count() == 99);
+    assert(kv->getString("key-parent", value) && value == "parent");
+    kv->close();
+
+    // a memfd & a file instance of the same ID are two instances, backup & restore only see the file one
+    auto memfdKV = MMKV::mmkvWithID("unit_test_memfd_and_file", MMKV_MEMFD);
+    auto fileKV = MMKV::mmkvWithID("unit_test_memfd_and_file", MMKV_SINGLE_PROCESS);
+    assert(memfdKV && fileKV && memfdKV != fileKV && memfdKV->isMemfd() && !fileKV->isMemfd());
+    assert(MMKV::mmkvWithID("unit_test_memfd_and_file", MMKV_MEMFD) == memfdKV);
+    assert(MMKV::mmkvWithMemfdFD("unit_test_memfd_and_file", memfdKV->memfdFD(), memfdKV->memfdMetaFD()) == memfdKV);
+    fileKV->clearAll();
+    memfdKV->set("memfd", "owner");
+    fileKV->set("file", "owner");
+    string backupDir = rootDir + "/memfd_backup";
+    assert(MMKV::backupOneToDirectory("unit_test_memfd_and_file", backupDir));
+    fileKV->set("changed", "owner");
+    assert(MMKV::restoreOneFromDirectory("unit_test_memfd_and_file", backupDir));
+    assert(fileKV->getString("owner", value) && value == "file");
+    assert(memfdKV->getString("owner", value) && value == "memfd");
+    memfdKV->close();
+    fileKV->close();
+    printf("test memfd: passed\n");
+}
+
+void testMultiProcessOverride(const string &rootDir) {
+    auto kv = MMKV::mmkvWithID("unit_test_mp_override", MMKV_MULTI_PROCESS);
+    kv->clearAll();
+    // the same files opened once more through hard links, as if from another process
+    auto path = rootDir + "/unit_test_mp_override";
+    auto peerPath = rootDir + "/unit_test_mp_override_peer";
+    unlink(peerPath.c_str());
+    unlink((peerPath + ".crc").c_str());
+    assert(link(path.c_str(), peerPath.c_str()) == 0);
+    assert(link((path + ".crc").c_str(), (peerPath + ".crc").c_str()) == 0);
+    auto peer = MMKV::mmkvWithID("unit_test_mp_override_peer", MMKV_MULTI_PROCESS);
+    assert(peer && peer != kv);
+
+    // a single hot key keeps rewriting from the beginning instead of appending
+    for (int32_t i = 0; i < 5000; i++) {
+        assert(kv->set(i, "hot"));
+        assert(peer->getInt32("hot") == i);
+        assert(kv->actualSize() < 32);
+    }
+    assert(peer->set(string(100, 'P'), "peer"));
+    string value;
+    assert(kv->getString("peer", value) && value == string(100, 'P'));
+    assert(kv->getInt32("hot") == 4999);
+
+    // the other way around, and an emptied store starts over from the beginning too
+    peer->removeValuesForKeys({"hot", "peer"});
+    assert(peer->set("again", "hot"));
+    assert(kv->count() == 1 && kv->getString("hot", value) && value == "again");
+    assert(kv->actualSize() < 32 && kv->totalSize() == DEFAULT_MMAP_SIZE);
+
+    peer->close();
+    kv->close();
+
+    // encrypted, the peer has to pick up the new IV that comes with every rewrite
+    string cryptKey = "mpOverrideKey";
+    kv = MMKV::mmkvWithID("unit_test_mp_override", MMKV_MULTI_PROCESS, &cryptKey);
+    kv->clearAll();
+    kv->reKey(cryptKey, MMKVCryptCTR);
+    peer = MMKV::mmkvWithID("unit_test_mp_override_peer", MMKV_MULTI_PROCESS, &cryptKey);
+    assert(peer->cryptMode() == MMKVCryptCTR);
+    assert(kv->set(string(64, 'A'), "hot"));
+    auto size = kv->actualSize();
+    auto c1 = readDataBytes(path, size);
+    for (char ch = 'B'; ch <= 'Z'; ch++) {
+        assert(kv->set(string(64, ch), "hot"));
+        assert(peer->getString("hot", value) && value == string(64, ch));
+    }
+    assert(kv->actualSize() == size);
+    auto c2 = readDataBytes(path, size);
+    size_t leaked = 0;
+    for (size_t i = size - 64; i < size; i++) {
+        leaked += ((c1[i] ^ c2[i]) == ('A' ^ 'Z'));
+    }
+    assert(leaked < 8);
+    assert(peer->set(string(64, 'p'), "hot"));
+    assert(kv->getString("hot", value) && value == string(64, 'p'));
+
+    peer->close();
+    kv->close();
+    printf("test multi-process override: passed\n");
+}
+
+// everything in the instance in one number, to compare what two processes see
+static size_t digestOf(MMKV *kv) {
+    auto keys = kv->allKeys();
+    sort(keys.begin(), keys.end());
+    size_t digest = keys.size();
+    string value;
+    for (auto &key : keys) {
+        kv->getString(key, value);
+        digest = digest * 31 + hash<string>()(key + "=" + value);
+    }
+    return digest;
+}
+
+static size_t g_relocationCount = 0;
+
+static void countRelocation(MMKVLogLevel /*level*/, const char * /*file*/, int /*line*/, const char *function,
+                            MMKVLog_t message) {
+    if (strcmp(function, "relocateByCompactionJournal") == 0 && message.find("relocated") != string::npos) {
+        g_relocationCount++;
+    }
+}
+
+void testCompactionJournal() {
+    const string mmapID = "unit_test_compaction_journal";
+    MMKV::removeStorage(mmapID);
+    int toChild[2], toParent[2];
+    assert(pipe(toChild) == 0 && pipe(toParent) == 0);
+
+    // the child keeps the instance loaded, and compares it with the parent every now and then
+    auto pid = fork();
+    if (pid == 0) {
+        // how often it catches up by the journal rather than a full reload
+        MMKV::registerLogHandler(countRelocation);
+        auto kv = MMKV::mmkvWithID(mmapID, MMKV_MULTI_PROCESS);
+        size_t digest = kv->count();
+        if (write(toParent[1], &digest, sizeof(digest)) != sizeof(digest)) {
+            _exit(1);
+        }
+        size_t round = 0;
+        while (read(toChild[0], &round, sizeof(round)) == sizeof(round) && round > 0) {
+            digest = digestOf(kv);
+            // and appends after catching up
+            kv->set(to_string(round), "child");
+            if (write(toParent[1], &digest, sizeof(digest)) != sizeof(digest)) {
+                _exit(1);
+            }
+        }
+        if (write(toParent[1], &g_relocationCount, sizeof(g_relocationCount)) != sizeof(g_relocationCount)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    size_t childDigest = 1;
+    assert(pid > 0 && read(toParent[0], &childDigest, sizeof(childDigest)) == sizeof(childDigest) && childDigest == 0);
+
+    auto kv = MMKV::mmkvWithID(mmapID, MMKV_MULTI_PROCESS);
+    size_t round = 0;
+    auto compareWithChild = [&]() {
+        auto digest = digestOf(kv);
+        round++;
+        assert(write(toChild[1], &round, sizeof(round)) == sizeof(round));
+        assert(read(toParent[0], &childDigest, sizeof(childDigest)) == sizeof(childDigest) && childDigest == digest);
+        string value;
+        assert(kv->getString("child", value) && value == to_string(round));
+    };
+    for (size_t index = 0; index < 300; index++) {
+        kv->set(string(64 + index % 64, 'a' + index % 26), "key-" + to_string(index));
+    }
+    // some keys are hot, some get removed, the child is behind by a few appends when it's compacted
+    size_t compactions = 0;
+    for (size_t step = 0; step < 6000; step++) {
+        auto key = "key-" + to_string((step * 7) % 40);
+        auto lastActualSize = kv->actualSize();
+        if (step % 11 == 0) {
+            kv->removeValueForKey(key);
+        } else {
+            kv->set(string(64 + step % 64, 'a' + step % 26) + to_string(step), key);
+        }
+        if (kv->actualSize() < lastActualSize) {
+            compactions++;
+            compareWithChild();
+        } else if (step % 97 == 0) {
+            compareWithChild();
+        }
+    }
+    assert(compactions > 3);
+
+    size_t stop = 0, relocations = 0;
+    assert(write(toChild[1], &stop, sizeof(stop)) == sizeof(stop));
+    assert(read(toParent[0], &relocations, sizeof(relocations)) == sizeof(relocations));
+    // every compaction is caught up with by the journal, a full reload would pass the comparisons too
+    assert(relocations >= compactions);
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(toChild[0]);
+    close(toChild[1]);
+    close(toParent[0]);
+    close(toParent[1]);
+    kv->close();
+    printf("test compaction journal: passed\n");
+}
+
+static ContentChangedKeys g_changedKeys;
+
+static void onContentKeysChanged(const string &mmapID, const ContentChangedKeys &changes) {
+    if (mmapID == "unit_test_content_keys_change") {
+        g_changedKeys = changes;
+    }
+}
+
+void testContentKeysChange() {
+    const string mmapID = "unit_test_content_keys_change";
+    MMKV::removeStorage(mmapID);
+    int toChild[2], toParent[2];
+    assert(pipe(toChild) == 0 && pipe(toParent) == 0);
+
+    // the child listens, and tells whether each round of changes is reported as expected
+    auto pid = fork();
+    if (pid == 0) {
+        MMKV::registerContentKeysChangeHandler(onContentKeysChanged);
+        auto kv = MMKV::mmkvWithID(mmapID, MMKV_MULTI_PROCESS);
+        kv->count();
+        using Keys = vector<string>;
+        vector<ContentChangedKeys> expected = {
+            {Keys{"a", "b", "c"}, Keys{}, Keys{}},
+            {Keys{"d"}, Keys{"b"}, Keys{"c"}},
+            {Keys{}, Keys{}, Keys{"a", "b", "d"}},
+        };
+        char ok = 1;
+        if (write(toParent[1], &ok, sizeof(ok)) != sizeof(ok)) {
+            _exit(1);
+        }
+        for (auto &expect : expected) {
+            char round = 0;
+            if (read(toChild[0], &round, sizeof(round)) != sizeof(round)) {
+                _exit(1);
+            }
+            g_changedKeys = ContentChangedKeys();
+            kv->checkContentChanged();
+            for (auto keys : {&g_changedKeys.addedKeys, &g_changedKeys.updatedKeys, &g_changedKeys.removedKeys}) {
+                sort(keys->begin(), keys->end());
+            }
+            ok = g_changedKeys.addedKeys == expect.addedKeys && g_changedKeys.updatedKeys == expect.updatedKeys &&
+                 g_changedKeys.removedKeys == expect.removedKeys;
+            if (write(toParent[1], &ok, sizeof(ok)) != sizeof(ok)) {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    char ok = 0;
+    assert(pid > 0 && read(toParent[0], &ok, sizeof(ok)) == sizeof(ok) && ok);
+
+    auto kv = MMKV::mmkvWithID(mmapID, MMKV_MULTI_PROCESS);
+    auto checkChild = [&]() {
+        char round = 1;
+        assert(write(toChild[1], &round, sizeof(round)) == sizeof(round));
+        assert(read(toParent[0], &ok, sizeof(ok)) == sizeof(ok) && ok);
+    };
+    kv->set("value", "a");
+    kv->set("value", "b");
+    kv->set("value", "c");
+    checkChild();
+
+    kv->set("value2", "b");
+    kv->removeValueForKey("c");
+    kv->set("value", "d");
+    // added & removed in the same round, nothing to tell
+    kv->set("value", "e");
+    kv->removeValueForKey("e");
+    checkChild();
+
+    // rewritten as a whole
+    kv->clearAll();
+    checkChild();
+
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    close(toChild[0]);
+    close(toChild[1]);
+    close(toParent[0]);
+    close(toParent[1]);
+    kv->close();
+    printf("test content keys change: passed\n");
+}
+
+void testChangeFeed() {
+    string cryptKey = "change_feed";
+    for (auto key : {(string *) nullptr, &cryptKey}) {
+        auto kv = MMKV::mmkvWithID("unit_test_change_feed", MMKV_SINGLE_PROCESS, key);
+        kv->clearAll();
+
+        // small int32 values are encoded in one byte, a removal has an empty value
+        vector<pair<string, int>> records;
+        auto collect = [&](size_t limit) {
+            return [&records, limit](const string &key, const MMBuffer &value) {
+                records.emplace_back(key, value.length() == 0 ? -1 : *(const uint8_t *) value.getPtr());
+                return records.size() < limit;
+            };
+        };
+        MMKV::ChangeCursor cursor;
+        kv->set(1, "a");
+        kv->set(2, "b");
+        kv->removeValueForKey("a");
+        assert(kv->changesSince(cursor, collect(SIZE_MAX)));
+        assert((records == vector<pair<string, int>>{{"a", 1}, {"b", 2}, {"a", -1}}));
+
+        records.clear();
+        assert(kv->changesSince(cursor, collect(SIZE_MAX)) && records.empty());
+        kv->set(3, "c");
+        kv->set(4, "d");
+        kv->set(5, "e");
+        assert(kv->changesSince(cursor, collect(2)));
+        assert((records == vector<pair<string, int>>{{"c", 3}, {"d", 4}}));
+        records.clear();
+        assert(kv->changesSince(cursor, collect(SIZE_MAX)));
+        assert((records == vector<pair<string, int>>{{"e", 5}}));
+
+        // a rewritten log invalidates the cursor, and it's replayed from the beginning
+        kv->clearAll();
+        kv->set(6, "f");
+        records.clear();
+        assert(!kv->changesSince(cursor, collect(SIZE_MAX)) && cursor.offset == 0 && records.empty());
+        assert(kv->changesSince(cursor, collect(SIZE_MAX)));
+        assert((records == vector<pair<string, int>>{{"f", 6}}));
+
+        // a single key is rewritten from the beginning, with a new IV when encrypted
+        kv->set(7, "f");
+        records.clear();
+        assert(!kv->changesSince(cursor, collect(SIZE_MAX)) && cursor.offset == 0);
+        assert(kv->changesSince(cursor, collect(SIZE_MAX)));
+        assert((records == vector<pair<string, int>>{{"f", 7}}));
+        kv->close();
+    }
+    printf("test change feed: passed\n");
+}
+
+void testLazyLoad(const string &rootDir) {
+    auto mmapID = "unit_test_lazy_load";
+    auto kv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS);
+    kv->clearAll();
+    for (int i = 0; i < 100; i++) {
+        kv->set(i, "int-" + to_string(i));
+    }
+    kv->set("old value", "string");
+    kv->set("new value", "string");
+    kv->set("", "empty");
+    kv->set(true, "removed");
+    kv->removeValueForKey("removed");
+    kv->close();
+
+    // point reads are served by the index: hits, the last record of a key, empty values, removals and misses,
+    // well beyond the number of reads that used to fall through to the full load
+    kv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS | MMKV_LAZY_LOAD);
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; i < 100; i++) {
+            assert(kv->getInt32("int-" + to_string(i), -1) == i);
+        }
+        string result;
+        assert(kv->getString("string", result) && result == "new value");
+        assert(kv->getString("empty", result) && result.empty());
+        assert(!kv->getBool("removed", false));
+        assert(kv->getInt32("missing", -1) == -1);
+    }
+
+    // anything but a point read loads the whole file from the index
+    assert(kv->count() == 102);
+    assert(!kv->containsKey("removed"));
+    kv->set(100, "int-100");
+    assert(kv->getInt32("int-100") == 100);
+    string result;
+    assert(kv->getString("string", result) && result == "new value");
+    kv->clearMemoryCache();
+    assert(kv->getInt32("int-100") == 100);
+    assert(kv->count() == 103);
+    kv->close();
+
+    // a log that fails the crc check is never indexed, the full load handles the error
+    auto file = fopen((rootDir + "/" + mmapID).c_str(), "r+b");
+    assert(file);
+    fseek(file, 8, SEEK_SET);
+    auto ch = fgetc(file);
+    fseek(file, 8, SEEK_SET);
+    fputc(ch ^ 0xff, file);
+    fclose(file);
+    kv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS | MMKV_LAZY_LOAD);
+    assert(kv->getInt32("int-1", -1) == -1);
+    assert(kv->count() == 0);
+    kv->close();
+
+    printf("test lazy load: passed\n");
+}
+
 int main() {
     locale::global(locale(""));
     wcout.imbue(locale(""));
@@ -269,4 +1952,32 @@ int main() {
     testBytes(mmkv);
     testVector(mmkv);
     testRemove(mmkv);
+    testForEach(mmkv);
+    testGetMany(mmkv);
+    testTypeMismatch();
+    testSnapshot();
+    testExpireIndex();
+    testCryptCTR();
+    testCryptOverrideIV(rootDir);
+    testRandomIV();
+    testDecryptedValueCache();
+    testAESKnownAnswer();
+    testPCLMULCRC32();
+    testSegmentCRC(rootDir);
+    testDirtyRanges();
+    testDirtySync();
+    testIncrementalBackup(rootDir);
+    testThreadLockUnlockFully();
+    testParallelBackup(rootDir);
+    testBulkImport();
+    testStreamDump();
+    testAccessHints();
+    testHugePage();
+    testBufferedIO(rootDir);
+    testMemfd(rootDir);
+    testMultiProcessOverride(rootDir);
+    testCompactionJournal();
+    testContentKeysChange();
+    testChangeFeed();
+    testLazyLoad(rootDir);
 }
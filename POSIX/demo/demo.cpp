@@ -577,6 +577,32 @@ void testAutoExpiration() {
     cout << "all non expire keys: " << ::to_string(allKeys) << endl;
 }
 
+void testExpireSweeper() {
+    auto mmkv = MMKV::mmkvWithID("testExpireSweeper");
+    mmkv->clearAll();
+    mmkv->enableAutoKeyExpire(MMKV::ExpireNever);
+    for (int i = 0; i < 100; i++) {
+        mmkv->set(i, "sweep_key_" + to_string(i), 1);
+    }
+    mmkv->set(true, "never_expire_key");
+
+    MMKV::startExpireSweeper(1, 64);
+    // instances come & go while being swept
+    for (int i = 0; i < 40; i++) {
+        auto other = MMKV::mmkvWithID("testExpireSweeper2");
+        other->enableAutoKeyExpire(1);
+        other->set(i, "sweep_key_" + to_string(i));
+        other->close();
+        usleep(100 * 1000);
+    }
+    MMKV::stopExpireSweeper();
+    // count() without filtering tells whether the keys are actually removed
+    assert(mmkv->count() == 1);
+    assert(mmkv->containsKey("never_expire_key"));
+    mmkv->disableAutoKeyExpire();
+    printf("testExpireSweeper: passed\n");
+}
+
 void testExpectedCapacity() {
     auto mmkv0 = MMKV::mmkvWithID("testExpectedCapacity0", MMKV_SINGLE_PROCESS, nullptr, nullptr, 0);
     assert(mmkv0->totalSize() == DEFAULT_MMAP_SIZE);
@@ -869,6 +895,93 @@ void testGetStringSpeed() {
     printf("old_method = %" PRId64 ", new_method = %" PRId64 "\n", end1 - start1, end2 - start2);
 }
 
+void testLoadSpeed() {
+    auto mmkv = MMKV::mmkvWithID("testLoadSpeed");
+    if (mmkv->count() != 1000000) {
+        mmkv->clearAll();
+        for (int i = 0; i < 1000000; i++) {
+            mmkv->set(i, "key-" + to_string(i));
+        }
+    }
+    uint64_t total = 0;
+    for (int round = 0; round < 10; round++) {
+        mmkv->clearMemoryCache();
+        auto start = getTimeInMs();
+        auto count = mmkv->count();
+        total += getTimeInMs() - start;
+        assert(count == 1000000);
+    }
+    printf("load 1M keys: %" PRId64 " ms per round\n", total / 10);
+}
+
+void testGetPrimitiveSpeed() {
+    auto mmkv = MMKV::mmkvWithID("testGetPrimitiveSpeed");
+    mmkv->set(true, "bool");
+    mmkv->set(-1024, "int32");
+    mmkv->set(numeric_limits<uint32_t>::max(), "uint32");
+    mmkv->set(numeric_limits<int64_t>::min(), "int64");
+    mmkv->set(numeric_limits<uint64_t>::max(), "uint64");
+    mmkv->set(3.14f, "float");
+    mmkv->set(3.1415926, "double");
+
+    const int loops = 5000000;
+    double sum = 0;
+    auto measure = [&](const char *name, const function<double()> &getter) {
+        auto start = getTimeInMs();
+        for (int i = 0; i < loops; i++) {
+            sum += getter();
+        }
+        printf("get %s x %d: %" PRId64 " ms\n", name, loops, getTimeInMs() - start);
+    };
+    measure("bool", [&] { return mmkv->getBool("bool"); });
+    measure("int32", [&] { return mmkv->getInt32("int32"); });
+    measure("uint32", [&] { return mmkv->getUInt32("uint32"); });
+    measure("int64", [&] { return mmkv->getInt64("int64"); });
+    measure("uint64", [&] { return mmkv->getUInt64("uint64"); });
+    measure("float", [&] { return mmkv->getFloat("float"); });
+    measure("double", [&] { return mmkv->getDouble("double"); });
+    printf("testGetPrimitiveSpeed: checksum %f\n", sum);
+}
+
+void testCryptSpeed() {
+    string aesKey = "cryptKey", aesKey2 = "cryptKey2";
+    auto mmkv = MMKV::mmkvWithID("testCryptSpeed", MMKV_SINGLE_PROCESS, &aesKey);
+    const int keyCount = 200000;
+    if (mmkv->count() != keyCount) {
+        mmkv->clearAll();
+        string value(100, 'v');
+        for (int i = 0; i < keyCount; i++) {
+            mmkv->set(value, "key-" + to_string(i));
+        }
+        mmkv->set(string(4096, 'b'), "key-0");
+    }
+
+    uint64_t total = 0;
+    for (int round = 0; round < 10; round++) {
+        mmkv->clearMemoryCache();
+        auto start = getTimeInMs();
+        auto count = mmkv->count();
+        total += getTimeInMs() - start;
+        assert(count == keyCount);
+    }
+    printf("load %d encrypted keys: %" PRId64 " ms per round\n", keyCount, total / 10);
+
+    string result;
+    auto start = getTimeInMs();
+    for (int i = 0; i < 200000; i++) {
+        mmkv->getString("key-0", result);
+    }
+    printf("get encrypted 4KB string x 200000: %" PRId64 " ms\n", getTimeInMs() - start);
+    assert(result.size() == 4096);
+
+    start = getTimeInMs();
+    for (int round = 0; round < 5; round++) {
+        mmkv->reKey(aesKey2);
+        mmkv->reKey(aesKey);
+    }
+    printf("reKey %d encrypted keys: %" PRId64 " ms per round\n", keyCount, (getTimeInMs() - start) / 10);
+}
+
 void printVector(vector<string> &v) {
     printf("testCompareBeforeSet: string<vector>: ");
     if (v.empty()) {
@@ -1310,6 +1423,34 @@ void testImport() {
     assert(dst->count(true) == 0);
 }
 
+void testLazyLoad() {
+    string mmapID = "test_lazy_load";
+    auto kv = MMKV::mmkvWithID(mmapID);
+    kv->clearAll();
+    for (int i = 0; i < 1000; i++) {
+        kv->set(i, "int-" + to_string(i));
+    }
+    kv->set("old value", "string");
+    kv->set("new value", "string");
+    kv->set(true, "removed");
+    kv->removeValueForKey("removed");
+    kv->close();
+
+    kv = MMKV::mmkvWithID(mmapID, MMKV_SINGLE_PROCESS | MMKV_LAZY_LOAD);
+    assert(kv->getInt32("int-0") == 0);
+    assert(kv->getInt32("int-999") == 999);
+    string result;
+    kv->getString("string", result);
+    assert(result == "new value");
+    assert(!kv->containsKey("removed"));
+    assert(kv->count() == 1001);
+
+    kv->set(1000, "int-1000");
+    assert(kv->getInt32("int-1000") == 1000);
+    kv->close();
+    printf("testLazyLoad passed\n");
+}
+
 void MyLogHandler(MMKVLogLevel level, const char *file, int line, const char *function, const string &message) {
 
     auto desc = [level] {
@@ -1365,12 +1506,17 @@ int main() {
     testOverride();
     testClearAllKeepSpace();
 //    testGetStringSpeed();
+//    testLoadSpeed();
+//    testGetPrimitiveSpeed();
+//    testCryptSpeed();
     testCompareBeforeSet();
     testBackup();
     testRestore();
     testAutoExpiration();
+    testExpireSweeper();
 //    testFtruncateFail();
     testRemoveStorage();
     testReadOnly();
     testImport();
+    testLazyLoad();
 }
@@ -405,6 +405,87 @@ MMKV_EXPORT void checkReSetCryptKey(void *handle, GoStringWrap oKey) {}
 
 #    endif // MMKV_DISABLE_CRYPT
 
+static vector<string> toKeys(GoStringWrap *keyArray, uint64_t count) {
+    vector<string> keys;
+    keys.reserve(count);
+    for (uint64_t index = 0; index < count; index++) {
+        auto &stringWrap = keyArray[index];
+        if (stringWrap.ptr) {
+            keys.emplace_back(stringWrap.ptr, stringWrap.length);
+        } else {
+            keys.emplace_back();
+        }
+    }
+    return keys;
+}
+
+template <typename T>
+static uint64_t decodeMany(void *handle, GoStringWrap *keyArray, uint64_t count, T *values, T defaultValue) {
+    MMKV *kv = static_cast<MMKV *>(handle);
+    if (kv && keyArray && values && count > 0) {
+        vector<T> result;
+        auto found = kv->getMany(toKeys(keyArray, count), result, defaultValue);
+        for (uint64_t index = 0; index < count; index++) {
+            values[index] = result[index];
+        }
+        return found;
+    }
+    return 0;
+}
+
+MMKV_EXPORT uint64_t decodeManyBool(void *handle, GoStringWrap *keyArray, uint64_t count, bool *values, bool defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT uint64_t decodeManyInt32(void *handle, GoStringWrap *keyArray, uint64_t count, int32_t *values, int32_t defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT uint64_t decodeManyUInt32(void *handle, GoStringWrap *keyArray, uint64_t count, uint32_t *values, uint32_t defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT uint64_t decodeManyInt64(void *handle, GoStringWrap *keyArray, uint64_t count, int64_t *values, int64_t defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT uint64_t decodeManyUInt64(void *handle, GoStringWrap *keyArray, uint64_t count, uint64_t *values, uint64_t defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT uint64_t decodeManyFloat(void *handle, GoStringWrap *keyArray, uint64_t count, float *values, float defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT uint64_t decodeManyDouble(void *handle, GoStringWrap *keyArray, uint64_t count, double *values, double defaultValue) {
+    return decodeMany(handle, keyArray, count, values, defaultValue);
+}
+
+MMKV_EXPORT GoStringWrap *decodeManyBytes(void *handle, GoStringWrap *keyArray, uint64_t count) {
+    MMKV *kv = static_cast<MMKV *>(handle);
+    if (kv && keyArray && count > 0) {
+        vector<MMBuffer> values;
+        kv->getMany(toKeys(keyArray, count), values);
+        auto valueArray = (GoStringWrap *) calloc(count, sizeof(GoStringWrap));
+        if (!valueArray) {
+            return nullptr;
+        }
+        for (uint64_t index = 0; index < count; index++) {
+            auto &value = values[index];
+            if (value.length() > 0) {
+                auto &stringWrap = valueArray[index];
+                stringWrap.ptr = (char *) malloc(value.length());
+                if (stringWrap.ptr) {
+                    memcpy((void *) stringWrap.ptr, value.getPtr(), value.length());
+                    stringWrap.length = static_cast<int64_t>(value.length());
+                }
+            }
+        }
+        return valueArray;
+    }
+    return nullptr;
+}
+
 MMKV_EXPORT GoStringWrap *allKeys(void *handle, uint64_t *lengthPtr, bool filterExpire) {
     MMKV *kv = static_cast<MMKV *>(handle);
     if (kv) {
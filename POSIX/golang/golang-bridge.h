@@ -83,6 +83,17 @@ bool reKey(void *handle, GoStringWrap_t oKey);
 void *cryptKey(void *handle, uint32_t *lengthPtr);
 void checkReSetCryptKey(void *handle, GoStringWrap_t oKey);
 
+// multi-get: values[i] = value of keyArray[i] or defaultValue, return the count of keys found
+uint64_t decodeManyBool(void *handle, GoStringWrap_t *keyArray, uint64_t count, bool *values, bool defaultValue);
+uint64_t decodeManyInt32(void *handle, GoStringWrap_t *keyArray, uint64_t count, int32_t *values, int32_t defaultValue);
+uint64_t decodeManyUInt32(void *handle, GoStringWrap_t *keyArray, uint64_t count, uint32_t *values, uint32_t defaultValue);
+uint64_t decodeManyInt64(void *handle, GoStringWrap_t *keyArray, uint64_t count, int64_t *values, int64_t defaultValue);
+uint64_t decodeManyUInt64(void *handle, GoStringWrap_t *keyArray, uint64_t count, uint64_t *values, uint64_t defaultValue);
+uint64_t decodeManyFloat(void *handle, GoStringWrap_t *keyArray, uint64_t count, float *values, float defaultValue);
+uint64_t decodeManyDouble(void *handle, GoStringWrap_t *keyArray, uint64_t count, double *values, double defaultValue);
+// return an array of count values, a value not found has nil ptr
+GoStringWrap_t *decodeManyBytes(void *handle, GoStringWrap_t *keyArray, uint64_t count);
+
 GoStringWrap_t *allKeys(void *handle, uint64_t *lengthPtr, bool filterExpire);
 bool containsKey(void *handle, GoStringWrap_t oKey);
 uint64_t count(void *handle, bool filterExpire);
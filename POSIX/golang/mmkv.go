@@ -166,6 +166,18 @@ type MMKV interface {
 	// GetBytesBuffer get C memory directly (without memcpy), much more efferent for large value
 	GetBytesBuffer(key string) MMBuffer
 
+	// GetManyXXX get values of many keys at once, much more efficient than calling GetXXX() one by one
+	// the value of a key not found is defaultValue
+	GetManyBool(keys []string, defaultValue bool) []bool
+	GetManyInt32(keys []string, defaultValue int32) []int32
+	GetManyInt64(keys []string, defaultValue int64) []int64
+	GetManyUInt32(keys []string, defaultValue uint32) []uint32
+	GetManyUInt64(keys []string, defaultValue uint64) []uint64
+	GetManyFloat32(keys []string, defaultValue float32) []float32
+	GetManyFloat64(keys []string, defaultValue float64) []float64
+	// GetManyBytes the value of a key not found is nil
+	GetManyBytes(keys []string) [][]byte
+
 	RemoveKey(key string)
 	RemoveKeys(keys []string)
 
@@ -588,6 +600,93 @@ func (kv ctorMMKV) RemoveKey(key string) {
 	C.removeValueForKey(unsafe.Pointer(kv), C.wrapGoString(key))
 }
 
+func (kv ctorMMKV) GetManyBool(keys []string, defaultValue bool) []bool {
+	result := make([]bool, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyBool(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.bool)(unsafe.Pointer(&result[0])), C.bool(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyInt32(keys []string, defaultValue int32) []int32 {
+	result := make([]int32, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyInt32(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.int32_t)(unsafe.Pointer(&result[0])), C.int32_t(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyInt64(keys []string, defaultValue int64) []int64 {
+	result := make([]int64, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyInt64(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.int64_t)(unsafe.Pointer(&result[0])), C.int64_t(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyUInt32(keys []string, defaultValue uint32) []uint32 {
+	result := make([]uint32, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyUInt32(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.uint32_t)(unsafe.Pointer(&result[0])), C.uint32_t(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyUInt64(keys []string, defaultValue uint64) []uint64 {
+	result := make([]uint64, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyUInt64(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.uint64_t)(unsafe.Pointer(&result[0])), C.uint64_t(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyFloat32(keys []string, defaultValue float32) []float32 {
+	result := make([]float32, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyFloat(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.float)(unsafe.Pointer(&result[0])), C.float(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyFloat64(keys []string, defaultValue float64) []float64 {
+	result := make([]float64, len(keys))
+	if len(keys) > 0 {
+		keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+		C.decodeManyDouble(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)), (*C.double)(unsafe.Pointer(&result[0])), C.double(defaultValue))
+	}
+	return result
+}
+
+func (kv ctorMMKV) GetManyBytes(keys []string) [][]byte {
+	count := uint64(len(keys))
+	result := make([][]byte, count)
+	if count == 0 {
+		return result
+	}
+	keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
+	valueArray := C.decodeManyBytes(unsafe.Pointer(kv), keyArray, C.uint64_t(count))
+	if valueArray == nil {
+		return result
+	}
+	values := (*[math.MaxInt32 / unsafe.Sizeof(C.struct_GoStringWrap{})]C.struct_GoStringWrap)(unsafe.Pointer(valueArray))[0:count:count]
+	for index := uint64(0); index < count; index++ {
+		value := values[index]
+		if value.ptr != nil {
+			result[index] = C.GoBytes(unsafe.Pointer(value.ptr), C.int(value.length))
+		}
+	}
+
+	C.freeStringArray(valueArray, C.size_t(count))
+	C.free(unsafe.Pointer(valueArray))
+	return result
+}
+
 func (kv ctorMMKV) RemoveKeys(keys []string) {
 	keyArray := (*C.struct_GoStringWrap)(unsafe.Pointer(&keys[0]))
 	C.removeValuesForKeys(unsafe.Pointer(kv), keyArray, C.uint64_t(len(keys)))
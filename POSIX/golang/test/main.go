@@ -93,6 +93,9 @@ func functionalTest() {
 	kv.RemoveKey("bool")
 	fmt.Println("after remove, contains \"bool\"? ", kv.Contains("bool"))
 
+	fmt.Println("many int32 =", kv.GetManyInt32([]string{"int32", "bool", "not_exist"}, -1))
+	fmt.Println("many bytes =", kv.GetManyBytes([]string{"bytes", "not_exist"}))
+
 	kv.RemoveKeys([]string{"int32", "int64"})
 	fmt.Println("count =", kv.Count(), ", all keys:", kv.AllKeys())
 
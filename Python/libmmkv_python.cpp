@@ -274,6 +274,76 @@ PYBIND11_MODULE(mmkv, m) {
         },
         "decode a bytes value", py::arg("key"), py::arg("defaultValue") = py::bytes());
 
+    clsMMKV.def(
+        "getManyBool",
+        [](MMKV &kv, const vector<string> &keys, bool defaultValue) {
+            vector<bool> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many boolean values at once", py::arg("keys"), py::arg("defaultValue") = false);
+    clsMMKV.def(
+        "getManyInt",
+        [](MMKV &kv, const vector<string> &keys, int32_t defaultValue) {
+            vector<int32_t> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many int32 values at once", py::arg("keys"), py::arg("defaultValue") = 0);
+    clsMMKV.def(
+        "getManyUInt",
+        [](MMKV &kv, const vector<string> &keys, uint32_t defaultValue) {
+            vector<uint32_t> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many unsigned int32 values at once", py::arg("keys"), py::arg("defaultValue") = 0);
+    clsMMKV.def(
+        "getManyLongInt",
+        [](MMKV &kv, const vector<string> &keys, int64_t defaultValue) {
+            vector<int64_t> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many int64 values at once", py::arg("keys"), py::arg("defaultValue") = 0);
+    clsMMKV.def(
+        "getManyLongUInt",
+        [](MMKV &kv, const vector<string> &keys, uint64_t defaultValue) {
+            vector<uint64_t> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many unsigned int64 values at once", py::arg("keys"), py::arg("defaultValue") = 0);
+    clsMMKV.def(
+        "getManyFloat",
+        [](MMKV &kv, const vector<string> &keys, double defaultValue) {
+            vector<double> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many float/double values at once", py::arg("keys"), py::arg("defaultValue") = 0);
+    clsMMKV.def(
+        "getManyString",
+        [](MMKV &kv, const vector<string> &keys, const string &defaultValue) {
+            vector<string> result;
+            kv.getMany(keys, result, defaultValue);
+            return result;
+        },
+        "decode many UTF-8 String/bytes values at once", py::arg("keys"), py::arg("defaultValue") = string());
+    clsMMKV.def(
+        "getManyBytes",
+        [](MMKV &kv, const vector<string> &keys, const py::bytes &defaultValue) {
+            // bytes share the length-delimited encoding of strings
+            vector<string> values;
+            kv.getMany(keys, values, string(defaultValue));
+            py::list result;
+            for (auto &value : values) {
+                result.append(py::bytes(value));
+            }
+            return result;
+        },
+        "decode many bytes values at once", py::arg("keys"), py::arg("defaultValue") = py::bytes());
+
     clsMMKV.def("__contains__", &MMKV::containsKey, py::arg("key"));
     clsMMKV.def("keys", &MMKV::allKeys, py::arg("filterExpire") = false);
 
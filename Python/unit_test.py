@@ -180,6 +180,30 @@ def test_bytes(kv):
     print('test bytes: passed')
 
 
+def test_get_many(kv):
+    kv.set(-1, 'ManyInt0')
+    kv.set(1, 'ManyInt1')
+    kv.set('many', 'ManyString')
+    kv.set('', 'ManyEmpty')
+
+    values = kv.getManyInt(['ManyInt0', KeyNotExist, 'ManyInt1'], 2)
+    assert values == [-1, 2, 1]
+
+    values = kv.getManyString(['ManyString', KeyNotExist])
+    assert values == ['many', '']
+
+    values = kv.getManyString(['ManyString', 'ManyEmpty', KeyNotExist], 'default')
+    assert values == ['many', '', 'default']
+
+    values = kv.getManyBytes(['ManyString', KeyNotExist])
+    assert values == [b'many', b'']
+
+    values = kv.getManyBytes(['ManyString', 'ManyEmpty', KeyNotExist], b'default')
+    assert values == [b'many', b'', b'default']
+
+    print('test get many: passed')
+
+
 def test_equal(kv, mmap_id):
     assert kv.mmapID() == mmap_id
 
@@ -206,4 +230,5 @@ if __name__ == '__main__':
     test_float(kv)
     test_string(kv)
     test_bytes(kv)
+    test_get_many(kv)
     test_equal(kv, 'unit_test_python')